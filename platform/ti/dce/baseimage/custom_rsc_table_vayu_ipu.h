@@ -43,6 +43,7 @@
 #define __CUSTOM_RSC_TABLE_VAYU_IPU_H__
 
 #include <ti/ipc/remoteproc/rsc_types.h>
+#include <ti/framework/dce/dce_stats.h>
 
 /* IPU Memory Map */
 #define L4_DRA7XX_BASE          0x4A000000
@@ -94,6 +95,10 @@
 #define IPU_MEM_IPC_VRING_SIZE  SZ_1M
 #define IPU_MEM_IPC_DATA_SIZE   SZ_1M
 
+/* live statistics page, read by the host, see dce_stats.h */
+#define IPU_MEM_STATS           DCE_STATS_DA
+#define IPU_MEM_STATS_SIZE      DCE_STATS_SIZE
+
 #define IPU_MEM_TEXT_SIZE       (SZ_1M * 6)
 
 /*
@@ -125,7 +130,7 @@
 struct my_resource_table {
     struct resource_table base;
 
-    UInt32 offset[17];  /* Should match 'num' in actual definition */
+    UInt32 offset[18];  /* Should match 'num' in actual definition */
 
     /* rpmsg vdev entry */
     struct fw_rsc_vdev rpmsg_vdev;
@@ -141,6 +146,9 @@ struct my_resource_table {
     /* ipcdata carveout entry */
     struct fw_rsc_carveout ipcdata_cout;
 
+    /* statistics carveout entry */
+    struct fw_rsc_carveout stats_cout;
+
     /* trace entry */
     struct fw_rsc_trace trace;
 
@@ -189,7 +197,7 @@ extern char ti_trace_SysMin_Module_State_0_outbuf__A;
 
 struct my_resource_table ti_ipc_remoteproc_ResourceTable = {
     1,      /* we're the first version that implements this */
-    17,     /* number of entries in the table */
+    18,     /* number of entries in the table */
     0, 0,   /* reserved, must be zero */
     /* offsets to entries */
     {
@@ -197,6 +205,7 @@ struct my_resource_table ti_ipc_remoteproc_ResourceTable = {
         offsetof(struct my_resource_table, text_cout),
         offsetof(struct my_resource_table, data_cout),
         offsetof(struct my_resource_table, ipcdata_cout),
+        offsetof(struct my_resource_table, stats_cout),
         offsetof(struct my_resource_table, trace),
         offsetof(struct my_resource_table, devmem0),
         offsetof(struct my_resource_table, devmem1),
@@ -240,6 +249,12 @@ struct my_resource_table ti_ipc_remoteproc_ResourceTable = {
         IPU_MEM_IPC_DATA_SIZE, 0, 0, "IPU_MEM_IPC_DATA",
     },
 
+    {
+        TYPE_CARVEOUT,
+        IPU_MEM_STATS, 0,
+        IPU_MEM_STATS_SIZE, 0, 0, "IPU_MEM_STATS",
+    },
+
     {
         TYPE_TRACE, TRACEBUFADDR, 0x8000, 0, "trace:sysm3",
     },
@@ -47,6 +47,7 @@
 #include <stdlib.h>
 
 #include <platform/ti/dce/baselib/ipumm_main.h>
+#include <ti/framework/dce/dce_stats.h>
 
 // Include the custom resource table for memory configuration.
 #if (defined VAYU_ES10)
@@ -60,7 +61,25 @@
 #endif
 
 extern uint32_t    dce_debug;
+extern uint32_t    dce_dpb_autosize;
+extern uint32_t    ivahd_idle_hold_ms;
+extern uint32_t    ivahd_wake_lead_ms;
+extern uint32_t    ivahd_dvfs;
+extern uint32_t    ivahd_boot_us;
+extern char        ivahd_poll_steps[];
+extern uint32_t    dce_init_us[];
+extern uint32_t    dce_batch_window_ms;
+extern uint32_t    dce_late_acquire;
+extern char        dce_timeline_buf[];
+extern uint32_t    dce_admission;
+extern uint32_t    dce_admission_headroom;
+extern char        dce_btrace_buf[];
 extern Uint32 kpi_control;
+extern unsigned long kpi_timebase;
+extern uint32_t    dce_stats_period_ms;
+extern char        kpi_sampler_buf[];
+extern uint32_t    kpi_sampler_hz;
+extern uint32_t    dce_rpc_trace;
 
 static unsigned int SyslinkMemUtils_VirtToPhys(Ptr Addr)
 {
@@ -99,6 +118,22 @@ void tools_ShowVersion()
                    \nTrace Usage: level:[0-4: 0-no trace, 1-err, 2-debug, 3-info, 4-CE,FC,IPC traces] \n\n",
                   SyslinkMemUtils_VirtToPhys(&dce_debug), dce_debug);
     System_printf("Trace Buffer PA 0x%x kpi_control (PA 0x%x value 0x%x)\n", SyslinkMemUtils_VirtToPhys((Ptr)(TRACEBUFADDR)), SyslinkMemUtils_VirtToPhys((Ptr)(&kpi_control)), kpi_control);
+    System_printf("H.264 DPB autosize PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_dpb_autosize), dce_dpb_autosize);
+    System_printf("IVA-HD idle hold (ms) PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&ivahd_idle_hold_ms), ivahd_idle_hold_ms);
+    System_printf("IVA-HD wake lead (ms) PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&ivahd_wake_lead_ms), ivahd_wake_lead_ms);
+    System_printf("IVA-HD DVFS PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&ivahd_dvfs), ivahd_dvfs);
+    System_printf("IVA-HD boot time PA 0x%x poll steps PA 0x%x\n", SyslinkMemUtils_VirtToPhys(&ivahd_boot_us), SyslinkMemUtils_VirtToPhys(ivahd_poll_steps));
+    System_printf("Init stages (us) PA 0x%x\n", SyslinkMemUtils_VirtToPhys(dce_init_us));
+    System_printf("Codec batch window (ms) PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_batch_window_ms), dce_batch_window_ms);
+    System_printf("Late IVA-HD acquire PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_late_acquire), dce_late_acquire);
+    System_printf("IVA-HD timeline PA 0x%x\n", SyslinkMemUtils_VirtToPhys(dce_timeline_buf));
+    System_printf("IVA-HD admission control PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_admission), dce_admission);
+    System_printf("IVA-HD admission headroom PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_admission_headroom), dce_admission_headroom);
+    System_printf("Binary trace PA 0x%x, enable PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(dce_btrace_buf), SyslinkMemUtils_VirtToPhys(&dce_btrace), dce_btrace);
+    System_printf("KPI timebase PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&kpi_timebase), kpi_timebase);
+    System_printf("Statistics page PA 0x%x, period PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys((Ptr)DCE_STATS_DA), SyslinkMemUtils_VirtToPhys(&dce_stats_period_ms), dce_stats_period_ms);
+    System_printf("Sampler PA 0x%x, rate PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(kpi_sampler_buf), SyslinkMemUtils_VirtToPhys(&kpi_sampler_hz), kpi_sampler_hz);
+    System_printf("RPC phases trace PA 0x%x value %d\n", SyslinkMemUtils_VirtToPhys(&dce_rpc_trace), dce_rpc_trace);
 }
 
 int main(int argc, char * *argv)
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <xdc/std.h>
+#include <xdc/cfg/global.h>
+#include <xdc/runtime/Error.h>
+#include <xdc/runtime/IHeap.h>
+#include <xdc/runtime/Memory.h>
+
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/heaps/HeapMem.h>
+#include <ti/sysbios/heaps/HeapCallback.h>
+
+#include "dce_heap.h"
+
+/* what HeapMem really takes out of the heap for a block */
+#define HEAP_BLOCK_ALIGN    sizeof(HeapMem_Header)
+#define HEAP_BLOCK_SIZE(s)  (((s) + HEAP_BLOCK_ALIGN - 1) & ~(HEAP_BLOCK_ALIGN - 1))
+
+/* created in dce_ipu.cfg */
+extern const HeapMem_Handle         heap0_mem;
+extern const HeapMem_Handle         heapCtrl_mem;
+extern const HeapCallback_Handle    heap0;
+extern const HeapCallback_Handle    heapCtrl;
+
+typedef struct DceHeap {
+    IHeap_Handle     heap;      /* the HeapMem doing the work */
+    Bool             init;
+    Bool             dirty;     /* changed since the last refresh */
+    DceHeap_Stats    stats;
+} DceHeap;
+
+static DceHeap    dce_heaps[DCE_HEAP_NUM];
+
+static IHeap_Handle backing_heap(int id)
+{
+    switch( id ) {
+        case DCE_HEAP_DEFAULT :
+            return (HeapMem_Handle_upCast(heap0_mem));
+        case DCE_HEAP_CTRL :
+            return (HeapMem_Handle_upCast(heapCtrl_mem));
+        default :
+            return (NULL);
+    }
+}
+
+IHeap_Handle dce_heap_handle(int id)
+{
+    switch( id ) {
+        case DCE_HEAP_CTRL :
+            return (HeapCallback_Handle_upCast(heapCtrl));
+        default :
+            return (HeapCallback_Handle_upCast(heap0));
+    }
+}
+
+int dce_heap_space(IALG_MemSpace space)
+{
+    switch( space ) {
+        case IALG_DARAM0 :
+        case IALG_DARAM1 :
+        case IALG_DARAM2 :
+        case IALG_SARAM0 :
+        case IALG_SARAM1 :
+        case IALG_SARAM2 :
+            return (DCE_HEAP_CTRL);
+        default :
+            return (DCE_HEAP_DEFAULT);
+    }
+}
+
+int dce_heap_select(const IALG_MemRec *rec)
+{
+    if((dce_heap_space(rec->space) == DCE_HEAP_CTRL) ||
+       (rec->size <= DCE_HEAP_CTRL_MAX)) {
+        return (DCE_HEAP_CTRL);
+    }
+
+    return (DCE_HEAP_DEFAULT);
+}
+
+/* Done on first use rather than at create, as HeapMem may not have been
+ * started up yet at that point.
+ */
+static void heap_init(DceHeap *h)
+{
+    Memory_Stats    s;
+
+    Memory_getStats(h->heap, &s);
+
+    h->stats.total = s.totalSize;
+    h->stats.used = s.totalSize - s.totalFreeSize;
+    h->stats.high_water = h->stats.used;
+    h->stats.largest_free = s.largestFreeSize;
+    h->init = TRUE;
+}
+
+/*
+ * HeapCallback functions, see dce_ipu.cfg
+ */
+UArg dce_heap_create(UArg arg)
+{
+    DceHeap    *h = &dce_heaps[arg];
+
+    h->heap = backing_heap(arg);
+
+    return ((UArg)h);
+}
+
+Void dce_heap_delete(UArg context)
+{
+}
+
+Ptr dce_heap_alloc(UArg context, SizeT size, SizeT align)
+{
+    DceHeap       *h = (DceHeap *)context;
+    Error_Block    eb;
+    Ptr            ptr;
+    UInt           key;
+    uint32_t       free;
+
+    if( !h->init ) {
+        heap_init(h);
+    }
+
+    Error_init(&eb);
+    ptr = Memory_alloc(h->heap, size, align, &eb);
+
+    key = Hwi_disable();
+
+    if( ptr ) {
+        h->stats.used += HEAP_BLOCK_SIZE(size);
+        h->stats.alloc_count++;
+        if( h->stats.used > h->stats.high_water ) {
+            h->stats.high_water = h->stats.used;
+        }
+    } else {
+        /* nothing this big (with this alignment) is left */
+        h->stats.failures++;
+        if( size <= h->stats.largest_free ) {
+            h->stats.largest_free = size - 1;
+        }
+    }
+
+    free = h->stats.total - h->stats.used;
+    if( h->stats.largest_free > free ) {
+        h->stats.largest_free = free;
+    }
+    h->dirty = TRUE;
+
+    Hwi_restore(key);
+
+    return (ptr);
+}
+
+Void dce_heap_free(UArg context, Ptr addr, SizeT size)
+{
+    DceHeap    *h = (DceHeap *)context;
+    UInt        key;
+
+    Memory_free(h->heap, addr, size);
+
+    key = Hwi_disable();
+
+    h->stats.used -= HEAP_BLOCK_SIZE(size);
+    h->stats.alloc_count--;
+
+    /* at least that block is free now, it may have merged with others */
+    if( HEAP_BLOCK_SIZE(size) > h->stats.largest_free ) {
+        h->stats.largest_free = HEAP_BLOCK_SIZE(size);
+    }
+    h->dirty = TRUE;
+
+    Hwi_restore(key);
+}
+
+Void dce_heap_getstats(UArg context, Memory_Stats *stats)
+{
+    DceHeap    *h = (DceHeap *)context;
+
+    if( !h->init ) {
+        heap_init(h);
+    }
+
+    stats->totalSize = h->stats.total;
+    stats->totalFreeSize = h->stats.total - h->stats.used;
+    stats->largestFreeSize = h->stats.largest_free;
+}
+
+Bool dce_heap_isblocking(UArg context)
+{
+    DceHeap    *h = (DceHeap *)context;
+
+    return (Memory_query(h->heap, Memory_Q_BLOCKING));
+}
+
+/*
+ * Accessors
+ */
+void dce_heap_stats(int id, DceHeap_Stats *stats)
+{
+    DceHeap    *h = &dce_heaps[id];
+    UInt        key;
+
+    if( !h->init ) {
+        heap_init(h);
+    }
+
+    key = Hwi_disable();
+    *stats = h->stats;
+    Hwi_restore(key);
+}
+
+void dce_heap_refresh(int id)
+{
+    DceHeap        *h = &dce_heaps[id];
+    Memory_Stats    s;
+    UInt            key;
+
+    if( !h->init ) {
+        heap_init(h);
+        return;
+    }
+
+    if( !h->dirty ) {
+        return;
+    }
+
+    h->dirty = FALSE;
+    Memory_getStats(h->heap, &s);
+
+    key = Hwi_disable();
+    /* an alloc/free since the walk makes it stale, try again next time */
+    if( !h->dirty ) {
+        h->stats.largest_free = s.largestFreeSize;
+    }
+    Hwi_restore(key);
+}
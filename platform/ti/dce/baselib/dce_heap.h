@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __DCE_HEAP_H__
+#define __DCE_HEAP_H__
+
+#include <stdint.h>
+#include <xdc/runtime/IHeap.h>
+#include <ti/xdais/ialg.h>
+
+/* Accounting wrapper around the heaps of dce_ipu.cfg.
+ *
+ * The heaps seen by the rest of the system are ti.sysbios.heaps.HeapCallback
+ * instances forwarding to a HeapMem, the callbacks keep the usage counters
+ * up to date on each alloc/free.  So Memory_getStats() on them, and
+ * dce_heap_stats(), are O(1) instead of walking the free list with
+ * interrupts off.
+ *
+ * The largest free block can not be known without a walk: it is tracked
+ * as an upper bound, lowered on allocation and failures and raised on
+ * free, and only made exact again by dce_heap_refresh() when the host
+ * asks for it (INFO_TYPE_LARGEST_FREE_HEAP).
+ *
+ * The heaps are split by memory class, see dce_ipu.cfg.
+ */
+#define DCE_HEAP_DEFAULT    0   /* heap0: large buffers, default heap */
+#define DCE_HEAP_CTRL       1   /* heapCtrl: small persistent objects */
+#define DCE_HEAP_NUM        2
+
+/* Persistent requests up to this size are control data */
+#define DCE_HEAP_CTRL_MAX   (64 * 1024)
+
+typedef struct DceHeap_Stats {
+    uint32_t    total;          /* bytes */
+    uint32_t    used;
+    uint32_t    high_water;     /* highest used since boot */
+    uint32_t    alloc_count;    /* live allocations */
+    uint32_t    largest_free;   /* approximate, see above */
+    uint32_t    failures;       /* allocations which failed */
+} DceHeap_Stats;
+
+/* Heap (as in Memory_alloc()) of a heap id */
+IHeap_Handle dce_heap_handle(int id);
+
+/* Heap id a memTab should come from, for allocations done by DCE */
+int dce_heap_select(const IALG_MemRec *rec);
+
+/* Heap id DSKT2 allocates a memory space from, as set in dce_ipu.cfg */
+int dce_heap_space(IALG_MemSpace space);
+
+/* Copy of the counters of heap id, does not touch the heap itself */
+void dce_heap_stats(int id, DceHeap_Stats *stats);
+
+/* Walk heap id to get the exact largest free block, if it changed since
+ * the last refresh.  Not for use in the decode path.
+ */
+void dce_heap_refresh(int id);
+
+#endif /* __DCE_HEAP_H__ */
@@ -77,12 +77,16 @@ int IPUMM_Main(int argc, char * *argv)
     extern void start_load_task(void);
     UInt16    hostId;
 
+    dce_init_stage(DCE_STAGE_MAIN);
+
     /* Set up interprocessor notifications */
     System_printf("%s starting..\n", MultiProc_getName(MultiProc_self()));
 
     hostId = MultiProc_getId("HOST");
     RPMessage_init(hostId);
+    dce_init_stage(DCE_STAGE_RPMSG);
 
+    /* the IVA-HD bring-up task runs along the IPC setup, see dce_init() */
     dce_init();
 
     /* CPU load reporting in the trace. */
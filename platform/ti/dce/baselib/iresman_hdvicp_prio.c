@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Priority aware front end to "ti.sdo.fc.ires.hdvicp".
+ *
+ * The stock IRESMAN_HDVICP still does the resource management, this only
+ * sits in between to know which instance holds the IVA-HD and how urgent
+ * each instance is:
+ *
+ *  - process calls are admitted by priority (see dispatch.c), which takes
+ *    care of preemption at frame boundaries,
+ *  - the handles IRESMAN_HDVICP hands out get their release wrapped, and
+ *    when a higher priority process call is waiting by the time a codec
+ *    gives the IVA-HD back mid frame (slice or row boundary), the codec is
+ *    made to yield, see dce_yield().
+ *
+ * The wait is wrapped too, to time the IVA-HD runs of each process call
+ * (see hdvicp_runs_begin()): how long the host takes before the first
+ * run, is blocked waiting for the IVA-HD, and takes after the last run.
+ * The codecs do not report their own split of a frame.
+ */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/Assert.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include <ti/xdais/ires.h>
+
+#include <ti/sdo/fc/ires/iresman.h>
+#include <ti/sdo/fc/ires/hdvicp/iresman_hdvicp.h>
+#include <ti/sdo/fc/ires/hdvicp/ires_hdvicp2.h>
+
+#include <ti/framework/dce/dce_priv.h>
+#include <ti/utils/osal/trace.h>
+
+/* HDVICP handles, one per codec instance at most */
+#define MAX_HANDLES    32
+
+typedef struct HdvicpPrioObj {
+    IRES_HDVICP2_Handle         handle;     /* from IRESMAN_HDVICP, NULL if unused */
+    IALG_Handle                 alg;
+    IRES_YieldContext          *yield;      /* as given to the last acquire */
+    IRES_HDVICP2_AcquireFxn     acquire;    /* of IRESMAN_HDVICP */
+    IRES_HDVICP2_ReleaseFxn     release;
+    IRES_HDVICP2_WaitFxn        wait;
+
+    /* runs of the current process call, in Timestamp counts */
+    uint32_t                    t_begin;
+    uint32_t                    t_first;    /* first wait entered */
+    uint32_t                    t_last;     /* last wait returned */
+    uint32_t                    iva;        /* blocked in wait */
+    uint32_t                    runs;
+} HdvicpPrioObj;
+
+typedef struct HdvicpPrio {
+    IALG_Handle    alg;                     /* NULL if unused */
+    Int            prio;
+} HdvicpPrio;
+
+static HdvicpPrioObj    objs[MAX_HANDLES];
+static HdvicpPrio       prios[MAX_HANDLES];
+
+/* preemptions at release, for the trace */
+static uint32_t         preemptions = 0;
+
+static HdvicpPrioObj *find_obj(IRES_HDVICP2_Handle handle)
+{
+    int    i;
+
+    for( i = 0; i < MAX_HANDLES; i++ ) {
+        if( objs[i].handle == handle ) {
+            return (&objs[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+static HdvicpPrioObj *find_alg(IALG_Handle alg)
+{
+    int    i;
+
+    for( i = 0; i < MAX_HANDLES; i++ ) {
+        if( objs[i].handle && (objs[i].alg == alg)) {
+            return (&objs[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+static HdvicpPrio *find_prio(IALG_Handle alg)
+{
+    int    i;
+
+    for( i = 0; i < MAX_HANDLES; i++ ) {
+        if( prios[i].alg == alg ) {
+            return (&prios[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+void hdvicp_prio_set(IALG_Handle alg, Int prio)
+{
+    HdvicpPrio    *p;
+    UInt           key = Task_disable();
+
+    p = find_prio(alg);
+    if( !p && prio ) {
+        p = find_prio(NULL);
+        if( !p ) {
+            Task_restore(key);
+            ERROR("no room for the priority of alg %p", alg);
+            return;
+        }
+        p->alg = alg;
+    }
+    if( p ) {
+        p->prio = prio;
+        if( !prio ) {
+            p->alg = NULL;
+        }
+    }
+
+    Task_restore(key);
+
+    DEBUG("alg %p priority %d", alg, prio);
+}
+
+Int hdvicp_prio_get(IALG_Handle alg)
+{
+    HdvicpPrio    *p;
+    Int            prio = 0;
+    UInt           key = Task_disable();
+
+    p = alg ? find_prio(alg) : NULL;
+    if( p ) {
+        prio = p->prio;
+    }
+    Task_restore(key);
+
+    return (prio);
+}
+
+void hdvicp_prio_remove(IALG_Handle alg)
+{
+    hdvicp_prio_set(alg, 0);
+}
+
+static XDAS_Void acquire(IALG_Handle algHandle, IRES_HDVICP2_Handle iresHandle,
+                         IRES_YieldContext *yieldCtxt, XDAS_UInt32 *reloadHDVICP,
+                         XDAS_UInt32 *configurationId, XDAS_Int32 lateAcquireArg)
+{
+    HdvicpPrioObj    *obj = find_obj(iresHandle);
+
+    Assert_isTrue(obj, NULL);
+
+    obj->yield = yieldCtxt;
+    obj->acquire(algHandle, iresHandle, yieldCtxt, reloadHDVICP,
+                 configurationId, lateAcquireArg);
+}
+
+static XDAS_Void release(IALG_Handle algHandle, IRES_HDVICP2_Handle iresHandle)
+{
+    HdvicpPrioObj    *obj = find_obj(iresHandle);
+
+    Assert_isTrue(obj, NULL);
+
+    obj->release(algHandle, iresHandle);
+
+    /* The IVA-HD is free and the codec has nothing on it to save, a good
+     * time to let a more urgent instance in.  dce_yield() ignores this
+     * outside of process calls.
+     */
+    if( dce_dispatch_preempt(hdvicp_prio_get(algHandle))) {
+        preemptions++;
+        DEBUG("alg %p preempted (%d)", algHandle, preemptions);
+        dce_yield(IRES_ALL, obj->yield, NULL);
+    }
+}
+
+static XDAS_UInt32 wait(IALG_Handle algHandle, IRES_HDVICP2_Handle iresHandle,
+                        IRES_YieldContext *yieldCtxt)
+{
+    HdvicpPrioObj    *obj = find_obj(iresHandle);
+    XDAS_UInt32       ret;
+    uint32_t          t;
+
+    Assert_isTrue(obj, NULL);
+
+    t = Timestamp_get32();
+    ret = obj->wait(algHandle, iresHandle, yieldCtxt);
+    obj->t_last = Timestamp_get32();
+
+    if( !obj->runs++ ) {
+        obj->t_first = t;
+    }
+    obj->iva += obj->t_last - t;
+
+    return (ret);
+}
+
+/* Start timing the IVA-HD runs of alg, at the beginning of a process call.
+ * A codec with more than one HDVICP handle only has its first one timed.
+ */
+void hdvicp_runs_begin(IALG_Handle alg)
+{
+    HdvicpPrioObj    *obj = find_alg(alg);
+
+    if( obj ) {
+        obj->t_begin = Timestamp_get32();
+        obj->iva = 0;
+        obj->runs = 0;
+    }
+}
+
+/* At the end of the process call, returns -1 if alg has no HDVICP handle */
+Int hdvicp_runs_end(IALG_Handle alg, Hdvicp_Runs *runs)
+{
+    HdvicpPrioObj    *obj = find_alg(alg);
+    uint32_t          t = Timestamp_get32();
+
+    if( !obj ) {
+        return (-1);
+    }
+
+    runs->runs = obj->runs;
+    runs->iva = obj->iva;
+    if( obj->runs ) {
+        runs->pre = obj->t_first - obj->t_begin;
+        runs->post = t - obj->t_last;
+    } else {
+        runs->pre = t - obj->t_begin;
+        runs->post = 0;
+    }
+
+    return (0);
+}
+
+static String getProtocolName()
+{
+    return (IRESMAN_HDVICP.getProtocolName());
+}
+
+static IRES_ProtocolRevision *getProtocolRevision()
+{
+    return (IRESMAN_HDVICP.getProtocolRevision());
+}
+
+static IRES_Status myinit(IRESMAN_Params *initArgs)
+{
+    memset(objs, 0, sizeof(objs));
+    return (IRESMAN_HDVICP.init(initArgs));
+}
+
+static IRES_Status myexit()
+{
+    return (IRESMAN_HDVICP.exit());
+}
+
+static IRES_Handle getHandles(IALG_Handle algHandle,
+                              IRES_ResourceDescriptor *resDesc, Int scratchGroupId,
+                              IRES_Status *status)
+{
+    IRES_HDVICP2_Handle    handle;
+    HdvicpPrioObj         *obj;
+
+    obj = find_obj(NULL);
+    if( !obj ) {
+        ERROR("too many HDVICP handles");
+        *status = IRES_ENORESOURCE;
+        return (NULL);
+    }
+
+    handle = (IRES_HDVICP2_Handle)IRESMAN_HDVICP.getHandle(algHandle, resDesc,
+                                                           scratchGroupId, status);
+    if( !handle ) {
+        return (NULL);
+    }
+
+    obj->handle = handle;
+    obj->alg = algHandle;
+    obj->yield = NULL;
+    obj->acquire = handle->acquire;
+    obj->release = handle->release;
+    obj->wait = handle->wait;
+
+    handle->acquire = acquire;
+    handle->release = release;
+    handle->wait = wait;
+
+    DEBUG("alg %p got HDVICP handle %p", algHandle, handle);
+
+    return ((IRES_Handle)handle);
+}
+
+static IRES_Status freeHandles(IALG_Handle algHandle,
+                               IRES_Handle algResourceHandle,
+                               IRES_ResourceDescriptor *resDesc,
+                               Int scratchGroupId)
+{
+    IRES_HDVICP2_Handle    handle = (IRES_HDVICP2_Handle)algResourceHandle;
+    HdvicpPrioObj         *obj = find_obj(handle);
+
+    if( obj ) {
+        handle->acquire = obj->acquire;
+        handle->release = obj->release;
+        handle->wait = obj->wait;
+        memset(obj, 0, sizeof(*obj));
+    }
+
+    hdvicp_prio_remove(algHandle);
+
+    return (IRESMAN_HDVICP.freeHandle(algHandle, algResourceHandle, resDesc,
+                                      scratchGroupId));
+}
+
+IRESMAN_Fxns    IRESMAN_HDVICP_PRIO =
+{
+    getProtocolName,
+    getProtocolRevision,
+    myinit,
+    myexit,
+    getHandles,
+    freeHandles,
+};
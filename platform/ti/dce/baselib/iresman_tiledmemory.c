@@ -30,27 +30,99 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-/* This is a dummy implementation of "ti.sdo.fc.ires.tiledmemory"
- * that just allocates from the heap:
+/* Implementation of "ti.sdo.fc.ires.tiledmemory".
+ *
+ * Requests for an 8/16/32-bit or page mode buffer get a real area of the
+ * TILER container: slots are taken from the window reserved for the IPU
+ * (see tiler_container.h), backed with pages from the heap and mapped by
+ * refilling the DMM PAT.  Raw requests, and any request which cannot be
+ * served from the container, fall back to a plain heap allocation as
+ * before.
  */
 
+#include <string.h>
+
 #include <xdc/std.h>
 #include <xdc/runtime/System.h>
 #include <xdc/runtime/Memory.h>
 #include <xdc/runtime/Assert.h>
+#include <ti/sysbios/hal/Cache.h>
 
 #include <ti/xdais/ires.h>
 
 #include <ti/sdo/fc/ires/iresman.h>
 #include <ti/sdo/fc/ires/tiledmemory/ires_tiledmemory.h>
+#include <ti/ipc/remoteproc/Resource.h>
 
 #include <ti/framework/dce/dce_priv.h>
 #include <ti/utils/osal/trace.h>
 
+#include "tiler_container.h"
+
 #define MIN_ALIGNMENT 0x4
+
+/* TILER system space and DMM registers, as seen from L3 */
+#define TILER_SYS_BASE            0x60000000
+#define DMM_BASE_PA               0x4E000000
+
+#define DMM_PAT_STATUS(n)         (0x4C0 + (n) * 0x4)
+#define DMM_PAT_DESCR(n)          (0x500 + (n) * 0x10)
+
+#define DMM_PAT_STATUS_READY      0x00000001
+#define DMM_PAT_STATUS_VALID      0x00000002
+#define DMM_PAT_STATUS_RUN        0x00000004
+#define DMM_PAT_STATUS_ERROR      0x0000FC00
+
+#define DMM_REFILL_TIMEOUT_US     10000
+
+/* Window of the container handed to the IPU and the PAT refill engine
+ * used to map it.  The host side tiler must be set up to keep off both,
+ * so they are only given by the board build (tiler_window and tiler_pat,
+ * see build/config.bld).  By default the window is empty and the 2D path
+ * is off.
+ */
+#ifndef TILER_IPU_WINDOW
+#define TILER_IPU_WINDOW          0, 0, -1, -1
+#endif
+#ifndef TILER_IPU_PAT_ENGINE
+#define TILER_IPU_PAT_ENGINE      -1
+#endif
+
+int    tiler_ipu_window[4] = { TILER_IPU_WINDOW };
+int    tiler_ipu_pat_engine = TILER_IPU_PAT_ENGINE;
+
+/* PAT refill descriptor, read by the DMM from memory */
+typedef struct DmmRefill {
+    uint32_t    next_pa;
+    uint32_t    area;       /* x0 | y0 << 8 | x1 << 16 | y1 << 24 */
+    uint32_t    ctrl;       /* start | dir << 4 | lut_id << 8 | ... */
+    uint32_t    data_pa;    /* list of page addresses, raster order */
+} DmmRefill;
+
+/* what we hand out as IRES_TILEDMEMORY_Handle */
+typedef struct TiledMemoryObj {
+    IRES_TILEDMEMORY_Obj      obj;        /* must be first */
+    tiler_fmt                 fmt;
+    tiler_area                area;
+    Void                     *backing;    /* pages behind the area, or NULL */
+    Int                       size;       /* of the backing or linear buffer */
+    IALG_Handle               alg;        /* owner */
+    Int                       save_off;   /* in the hibernation buffer */
+    struct TiledMemoryObj    *next;       /* in the list of all handles */
+} TiledMemoryObj;
+
 static IRESMAN_PersistentAllocFxn   *allocFxn;  /* Memory alloc function */
 static IRESMAN_PersistentFreeFxn    *freeFxn;   /* Memory free function */
 
+static tiler_container    container;
+static TiledMemoryObj    *handles = NULL;
+static Bool               container_ok = FALSE;
+static uint32_t           dmm_base = 0;
+static uint32_t           dummy_page_pa = 0;
+static Void              *dummy_page = NULL;
+
+#define DMM_REG(off)      (*(volatile uint32_t *)(dmm_base + (off)))
+
 static void *allocRes(int size, int alignment)
 {
     if( alignment < MIN_ALIGNMENT ) {
@@ -83,6 +155,225 @@ static void freeRes(void *base, int size)
     freeFxn(&rec, 1);
 }
 
+static uint32_t virt_to_phys(Void *va)
+{
+    UInt32    pa = 0;
+
+    if( Resource_virtToPhys((UInt32)va, &pa)) {
+        ERROR("no physical address for %p", va);
+        return (0);
+    }
+    return (pa);
+}
+
+/* Refill the PAT entries of an area with the given pages (or with the
+ * dummy page when pages is NULL), and wait for the engine to be done.
+ *
+ * Once handed to the engine, the descriptors are only freed when it is
+ * known to be done with them.  After an error or a timeout it may still
+ * be reading them, so they are leaked instead.
+ */
+static int dmm_refill(tiler_fmt fmt, const tiler_area *area, Void *pages)
+{
+    tiler_area    rect[3];
+    DmmRefill    *desc;
+    uint32_t     *data;
+    uint32_t      n, i, j, status;
+    int           nrect, size, ret = -1;
+
+    n = tiler_area_slots(fmt, area);
+    nrect = tiler_area_rects(fmt, area, rect);
+    size = nrect * sizeof(DmmRefill) + n * sizeof(uint32_t);
+
+    desc = allocRes(size, 16);
+    if( !desc ) {
+        ERROR("could not allocate PAT descriptors");
+        return (-1);
+    }
+    data = (uint32_t *)(desc + nrect);
+
+    for( i = 0; i < n; i++ ) {
+        data[i] = pages ?
+                  virt_to_phys((char *)pages + i * TILER_SLOT_SIZE) :
+                  dummy_page_pa;
+        if( !data[i] ) {
+            goto out;
+        }
+    }
+
+    for( i = 0, j = 0; i < (uint32_t)nrect; i++ ) {
+        desc[i].next_pa = (i + 1 < (uint32_t)nrect) ? virt_to_phys(&desc[i + 1]) : 0;
+        desc[i].area = rect[i].x0 | (rect[i].y0 << 8) |
+                       (rect[i].x1 << 16) | (rect[i].y1 << 24);
+        desc[i].ctrl = 0x1;     /* start, LUT 0 */
+        desc[i].data_pa = virt_to_phys(&data[j]);
+        j += (rect[i].x1 - rect[i].x0 + 1) * (rect[i].y1 - rect[i].y0 + 1);
+    }
+
+    Cache_wbInv(desc, size, Cache_Type_ALL, TRUE);
+
+    if( ivahd_poll_reg("tiler: PAT ready",
+                       &DMM_REG(DMM_PAT_STATUS(tiler_ipu_pat_engine)),
+                       DMM_PAT_STATUS_READY, DMM_PAT_STATUS_READY, TRUE,
+                       DMM_REFILL_TIMEOUT_US)) {
+        ERROR("PAT engine %d not ready", tiler_ipu_pat_engine);
+        goto out;
+    }
+
+    DMM_REG(DMM_PAT_DESCR(tiler_ipu_pat_engine)) = virt_to_phys(desc);
+
+    /* an engine in error does not get back to ready */
+    ivahd_poll_reg("tiler: PAT refill",
+                   &DMM_REG(DMM_PAT_STATUS(tiler_ipu_pat_engine)),
+                   DMM_PAT_STATUS_READY | DMM_PAT_STATUS_VALID |
+                   DMM_PAT_STATUS_RUN | DMM_PAT_STATUS_ERROR,
+                   DMM_PAT_STATUS_READY, TRUE, DMM_REFILL_TIMEOUT_US);
+
+    status = DMM_REG(DMM_PAT_STATUS(tiler_ipu_pat_engine));
+    if((status & (DMM_PAT_STATUS_READY | DMM_PAT_STATUS_VALID |
+                  DMM_PAT_STATUS_RUN | DMM_PAT_STATUS_ERROR)) !=
+       DMM_PAT_STATUS_READY) {
+        ERROR("PAT refill failed: status 0x%x, leaking %d bytes of descriptors",
+              status, size);
+        return (-1);
+    }
+    ret = 0;
+
+out:
+    freeRes(desc, size);
+    return (ret);
+}
+
+static void container_init(void)
+{
+    container_ok = FALSE;
+
+    if((tiler_ipu_pat_engine < 0) ||
+       tiler_container_init(&container, tiler_ipu_window[0],
+                             tiler_ipu_window[1], tiler_ipu_window[2],
+                             tiler_ipu_window[3])) {
+        INFO("no TILER window, tiled memory comes from the heap");
+        return;
+    }
+
+    if( Resource_physToVirt(DMM_BASE_PA, &dmm_base)) {
+        ERROR("DMM is not mapped, tiled memory comes from the heap");
+        return;
+    }
+
+    /* unmapped slots point to this page */
+    dummy_page = allocRes(TILER_SLOT_SIZE, TILER_SLOT_SIZE);
+    if( !dummy_page ) {
+        ERROR("could not allocate dummy page");
+        return;
+    }
+    dummy_page_pa = virt_to_phys(dummy_page);
+
+    container_ok = (dummy_page_pa != 0);
+}
+
+static tiler_fmt get_fmt(IRES_TILEDMEMORY_AccessUnit accessUnit)
+{
+    switch( accessUnit ) {
+        case IRES_TILEDMEMORY_8BIT :
+            return (TILER_FMT_8BIT);
+        case IRES_TILEDMEMORY_16BIT :
+            return (TILER_FMT_16BIT);
+        case IRES_TILEDMEMORY_32BIT :
+            return (TILER_FMT_32BIT);
+        default :
+            return (TILER_FMT_PAGE);
+    }
+}
+
+/* Try to serve the request from the TILER container */
+static Bool alloc_tiled(IRES_TILEDMEMORY_ProtocolArgs *args,
+                        TiledMemoryObj *tobj)
+{
+    tiler_fmt    fmt;
+    uint32_t     sys;
+    UInt32       va;
+    int          ret, size;
+
+    if( !container_ok || (args->accessUnit == IRES_TILEDMEMORY_RAW)) {
+        return (FALSE);
+    }
+
+    fmt = get_fmt(args->accessUnit);
+
+    if( fmt == TILER_FMT_PAGE ) {
+        size = args->sizeDim0;
+        if( args->sizeDim1 ) {
+            size *= args->sizeDim1;
+        }
+        ret = tiler_container_reserve_1d(&container, size, &tobj->area);
+    } else {
+        ret = tiler_container_reserve_2d(&container, fmt, args->sizeDim0,
+                                         args->sizeDim1, args->alignment,
+                                         &tobj->area);
+    }
+
+    if( ret ) {
+        INFO("TILER window full (%d slots used)", container.slots_used);
+        return (FALSE);
+    }
+
+    tobj->fmt = fmt;
+    tobj->size = tiler_area_slots(fmt, &tobj->area) * TILER_SLOT_SIZE;
+    tobj->backing = allocRes(tobj->size, TILER_SLOT_SIZE);
+    if( !tobj->backing ) {
+        ERROR("could not allocate %d bytes of TILER backing", tobj->size);
+        goto fail;
+    }
+
+    sys = TILER_SYS_BASE + tiler_area_offset(fmt, &tobj->area);
+    if( Resource_physToVirt(sys, &va)) {
+        ERROR("TILER address 0x%x is not mapped", sys);
+        goto fail;
+    }
+
+    if( dmm_refill(fmt, &tobj->area, tobj->backing)) {
+        goto fail;
+    }
+
+    tobj->obj.memoryBaseAddress = (Void *)va;
+    tobj->obj.systemSpaceBaseAddress = (Void *)sys;
+    tobj->obj.tilerBaseAddress = (Void *)sys;
+    tobj->obj.isTiledMemory = TRUE;
+    tobj->obj.accessUnit = args->accessUnit;
+
+    DEBUG("tiled: fmt %d slots (%d,%d)-(%d,%d) va 0x%x sys 0x%x", fmt,
+          tobj->area.x0, tobj->area.y0, tobj->area.x1, tobj->area.y1, va, sys);
+
+    return (TRUE);
+
+fail:
+    if( tobj->backing ) {
+        freeRes(tobj->backing, tobj->size);
+        tobj->backing = NULL;
+    }
+    tiler_container_release(&container, fmt, &tobj->area);
+    return (FALSE);
+}
+
+static void free_tiled(TiledMemoryObj *tobj)
+{
+    /* the backing is already gone when the owner is hibernated */
+    if( !tobj->backing ) {
+        tiler_container_release(&container, tobj->fmt, &tobj->area);
+        return;
+    }
+
+    /* point the slots back to the dummy page before giving the pages up */
+    if( dmm_refill(tobj->fmt, &tobj->area, NULL)) {
+        /* the DMM may still reference the pages, better leak them */
+        ERROR("could not unmap TILER area, leaking %d bytes", tobj->size);
+    } else {
+        freeRes(tobj->backing, tobj->size);
+    }
+    tiler_container_release(&container, tobj->fmt, &tobj->area);
+}
+
 static String getProtocolName()
 {
     return ("ti.sdo.fc.ires.tiledmemory");
@@ -99,11 +390,17 @@ static IRES_Status myinit(IRESMAN_Params *initArgs)
 {
     allocFxn = initArgs->allocFxn;
     freeFxn = initArgs->freeFxn;
+    container_init();
     return (IRES_OK);
 }
 
 static IRES_Status myexit()
 {
+    if( dummy_page ) {
+        freeRes(dummy_page, TILER_SLOT_SIZE);
+        dummy_page = NULL;
+    }
+    container_ok = FALSE;
     return (IRES_OK);
 }
 
@@ -119,7 +416,7 @@ static IRES_Handle getHandles(IALG_Handle algHandle,
 {
     IRES_TILEDMEMORY_ProtocolArgs   *args =
         (IRES_TILEDMEMORY_ProtocolArgs *)resDesc->protocolArgs;
-    IRES_TILEDMEMORY_Handle    handle = NULL;
+    TiledMemoryObj            *tobj = NULL;
     Void                      *ptr = NULL;
     int                        size, alignment;
 
@@ -132,7 +429,26 @@ static IRES_Handle getHandles(IALG_Handle algHandle,
         size *= args->sizeDim1;
     }
 
-    DEBUG("alloc: %dx%d (%d)(%d)", args->sizeDim0, args->sizeDim1, size, alignment);
+    DEBUG("alloc: %dx%d (%d)(%d) unit %d", args->sizeDim0, args->sizeDim1,
+          size, alignment, args->accessUnit);
+
+    tobj = allocRes(sizeof(*tobj), MIN_ALIGNMENT);
+    if( !tobj ) {
+        ERROR("could not allocate handle");
+        goto fail;
+    }
+    memset(tobj, 0, sizeof(*tobj));
+
+    tobj->obj.ires.getStaticProperties = getStaticProperties;
+    tobj->obj.ires.persistent = IRES_PERSISTENT;
+
+    tobj->alg = algHandle;
+
+    if( alloc_tiled(args, tobj)) {
+        tobj->next = handles;
+        handles = tobj;
+        return ((IRES_Handle)tobj);
+    }
 
     ptr = allocRes(size, alignment);
     if( !ptr ) {
@@ -141,30 +457,22 @@ static IRES_Handle getHandles(IALG_Handle algHandle,
         goto fail;
     }
 
-    handle = allocRes(sizeof(*handle), MIN_ALIGNMENT);
-    if( !handle ) {
-        ERROR("could not allocate handle");
-        goto fail;
-    }
-
-    handle->ires.getStaticProperties = getStaticProperties;
-    handle->ires.persistent = IRES_PERSISTENT;
-    handle->memoryBaseAddress = ptr;  /* MMU set up for 0x0 offset */
-    handle->systemSpaceBaseAddress = ptr;
-    handle->isTiledMemory = FALSE;
-    handle->accessUnit = IRES_TILEDMEMORY_RAW;
-    handle->tilerBaseAddress = NULL;
+    tobj->size = size;
+    tobj->obj.memoryBaseAddress = ptr;  /* MMU set up for 0x0 offset */
+    tobj->obj.systemSpaceBaseAddress = ptr;
+    tobj->obj.isTiledMemory = FALSE;
+    tobj->obj.accessUnit = IRES_TILEDMEMORY_RAW;
+    tobj->obj.tilerBaseAddress = NULL;
 
     DEBUG("allocation succeeded: %dx%d", args->sizeDim0, args->sizeDim1);
 
-    return ((IRES_Handle)handle);
+    tobj->next = handles;
+    handles = tobj;
+    return ((IRES_Handle)tobj);
 
 fail:
-    if( ptr ) {
-        freeRes(ptr, size);
-    }
-    if( handle ) {
-        freeRes(handle, sizeof(*handle));
+    if( tobj ) {
+        freeRes(tobj, sizeof(*tobj));
     }
     *status = IRES_ENOMEM;
     return (NULL);
@@ -175,28 +483,116 @@ static IRES_Status freeHandles(IALG_Handle algHandle,
                                IRES_ResourceDescriptor *resDesc,
                                Int scratchGroupId)
 {
-    IRES_TILEDMEMORY_ProtocolArgs   *args =
-        (IRES_TILEDMEMORY_ProtocolArgs *)resDesc->protocolArgs;
-    IRES_TILEDMEMORY_Handle    handle =
-        (IRES_TILEDMEMORY_Handle)algResourceHandle;
-    int    size;
+    TiledMemoryObj    *tobj = (TiledMemoryObj *)algResourceHandle;
+    TiledMemoryObj   **prev;
 
-    Assert_isTrue(args, NULL);
-    Assert_isTrue(handle, NULL);
+    Assert_isTrue(tobj, NULL);
 
-    size = args->sizeDim0;
-    if( args->sizeDim1 ) {
-        size *= args->sizeDim1;
+    for( prev = &handles; *prev; prev = &(*prev)->next ) {
+        if( *prev == tobj ) {
+            *prev = tobj->next;
+            break;
+        }
     }
 
-    DEBUG("free: %dx%d (%d)", args->sizeDim0, args->sizeDim1, size);
+    DEBUG("free: %p tiled %d (%d)", tobj->obj.memoryBaseAddress,
+          tobj->obj.isTiledMemory, tobj->size);
 
-    freeRes(handle->memoryBaseAddress, size);
-    freeRes(handle, sizeof(*handle));
+    if( tobj->obj.isTiledMemory ) {
+        free_tiled(tobj);
+    } else {
+        freeRes(tobj->obj.memoryBaseAddress, tobj->size);
+    }
+    freeRes(tobj, sizeof(*tobj));
 
     return (IRES_OK);
 }
 
+/* Hibernation of an algorithm's TILER buffers.
+ *
+ * The container area of a buffer is kept reserved while its owner is
+ * hibernated, only the pages behind it are given back, so the addresses
+ * the algorithm holds are still good once the pages are brought back.
+ * Buffers which fell back to the heap have no such indirection and stay
+ * resident.
+ */
+int tiledmemory_hibernate_size(IALG_Handle alg)
+{
+    TiledMemoryObj    *tobj;
+    int                size = 0;
+
+    for( tobj = handles; tobj; tobj = tobj->next ) {
+        if((tobj->alg == alg) && tobj->backing ) {
+            size += tobj->size;
+        }
+    }
+
+    return (size);
+}
+
+int tiledmemory_hibernate(IALG_Handle alg, uint8_t *save)
+{
+    TiledMemoryObj    *tobj;
+    int                size = 0;
+
+    for( tobj = handles; tobj; tobj = tobj->next ) {
+        if((tobj->alg != alg) || !tobj->backing ) {
+            continue;
+        }
+
+        /* the IVA may have written it behind our back */
+        Cache_wbInv(tobj->backing, tobj->size, Cache_Type_ALL, TRUE);
+        memcpy(save + size, tobj->backing, tobj->size);
+
+        if( dmm_refill(tobj->fmt, &tobj->area, NULL)) {
+            ERROR("could not unmap TILER area, %p stays resident", tobj);
+            continue;
+        }
+
+        freeRes(tobj->backing, tobj->size);
+        tobj->backing = NULL;
+        tobj->save_off = size;
+        size += tobj->size;
+    }
+
+    DEBUG("hibernated %d bytes of TILER backing for alg %p", size, alg);
+
+    return (size);
+}
+
+int tiledmemory_resume(IALG_Handle alg, const uint8_t *save)
+{
+    TiledMemoryObj    *tobj;
+    int                size = 0;
+
+    for( tobj = handles; tobj; tobj = tobj->next ) {
+        if((tobj->alg != alg) || tobj->backing || !tobj->obj.isTiledMemory ) {
+            continue;
+        }
+
+        tobj->backing = allocRes(tobj->size, TILER_SLOT_SIZE);
+        if( !tobj->backing ) {
+            ERROR("could not allocate %d bytes of TILER backing", tobj->size);
+            return (-1);
+        }
+
+        memcpy(tobj->backing, save + tobj->save_off, tobj->size);
+        Cache_wbInv(tobj->backing, tobj->size, Cache_Type_ALL, TRUE);
+
+        if( dmm_refill(tobj->fmt, &tobj->area, tobj->backing)) {
+            freeRes(tobj->backing, tobj->size);
+            tobj->backing = NULL;
+            return (-1);
+        }
+
+        size += tobj->size;
+    }
+
+    DEBUG("resumed %d bytes of TILER backing for alg %p", size, alg);
+
+    return (size);
+}
+
 IRESMAN_Fxns    IRESMAN_TILEDMEMORY =
 {
     getProtocolName,
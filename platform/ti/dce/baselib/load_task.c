@@ -57,6 +57,7 @@
 /* Monitor load and trace any change. */
 static Void loadTaskFxn(UArg arg0, UArg arg1)
 {
+    extern void dce_stats_kick(void);
     UInt32 prev_load = 0;
 
     /* Suppress warnings. */
@@ -96,6 +97,9 @@ static Void loadTaskFxn(UArg arg0, UArg arg1)
             prev_load = load;
         }
 
+        /* Start the statistics page if the host switched it on meanwhile. */
+        dce_stats_kick();
+
         /* Delay. */
         Task_sleep(SLEEP_TICKS);
     }
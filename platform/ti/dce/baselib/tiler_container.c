@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "tiler_container.h"
+
+/* Slot geometry per access mode, as laid out by the DMM:
+ * a slot is 64x64 bytes in 8-bit mode, 64x32 pixels in 16-bit mode and
+ * 32x32 pixels in 32-bit mode, which is 4KB in all cases.
+ */
+static const struct {
+    uint32_t    slot_w;     /* in pixels */
+    uint32_t    slot_h;     /* in lines */
+    uint32_t    cpp;        /* bytes per pixel */
+    uint32_t    stride;     /* bytes per line */
+} geom[] = {
+    [TILER_FMT_8BIT]  = { 64, 64, 1, 1 << 14 },
+    [TILER_FMT_16BIT] = { 64, 32, 2, 1 << 15 },
+    [TILER_FMT_32BIT] = { 32, 32, 4, 1 << 15 },
+    [TILER_FMT_PAGE]  = { 0, 0, 1, 0 },
+};
+
+#define BIT_WORD(x)     ((x) >> 5)
+#define BIT_MASK(x)     (1u << ((x) & 31))
+
+static int slot_is_used(const tiler_container *tc, int x, int y)
+{
+    return ((tc->map[y][BIT_WORD(x)] & BIT_MASK(x)) != 0);
+}
+
+/* Returns the first used slot in row y between x and x + w - 1, or -1 */
+static int row_first_used(const tiler_container *tc, int y, int x, int w)
+{
+    int    i;
+
+    for( i = x; i < x + w; i++ ) {
+        if( slot_is_used(tc, i, y)) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+static void row_mark(tiler_container *tc, int y, int x, int w, int used)
+{
+    int    i;
+
+    for( i = x; i < x + w; i++ ) {
+        if( used ) {
+            tc->map[y][BIT_WORD(i)] |= BIT_MASK(i);
+        } else {
+            tc->map[y][BIT_WORD(i)] &= ~BIT_MASK(i);
+        }
+    }
+}
+
+static void area_mark(tiler_container *tc, tiler_fmt fmt,
+                      const tiler_area *area, int used)
+{
+    tiler_area    rect[3];
+    int           i, y, nrect;
+
+    nrect = tiler_area_rects(fmt, area, rect);
+
+    for( i = 0; i < nrect; i++ ) {
+        for( y = rect[i].y0; y <= rect[i].y1; y++ ) {
+            row_mark(tc, y, rect[i].x0, rect[i].x1 - rect[i].x0 + 1, used);
+        }
+    }
+}
+
+int tiler_container_init(tiler_container *tc, int x0, int y0, int x1, int y1)
+{
+    if((x0 < 0) || (y0 < 0) || (x0 > x1) || (y0 > y1) ||
+       (x1 >= TILER_CONTAINER_WIDTH) || (y1 >= TILER_CONTAINER_HEIGHT)) {
+        return (-1);
+    }
+
+    memset(tc, 0, sizeof(*tc));
+    tc->win_x0 = x0;
+    tc->win_y0 = y0;
+    tc->win_x1 = x1;
+    tc->win_y1 = y1;
+
+    return (0);
+}
+
+int tiler_container_reserve_2d(tiler_container *tc, tiler_fmt fmt,
+                               uint32_t width, uint32_t height,
+                               uint32_t align, tiler_area *area)
+{
+    uint32_t    w, h, a;
+    int         x, y, row, used;
+
+    if((fmt == TILER_FMT_PAGE) || !width || !height ) {
+        return (-1);
+    }
+
+    w = (width + geom[fmt].slot_w - 1) / geom[fmt].slot_w;
+    h = (height + geom[fmt].slot_h - 1) / geom[fmt].slot_h;
+
+    /* alignment is counted from the start of the container, in slots */
+    a = (align + geom[fmt].slot_w * geom[fmt].cpp - 1) /
+        (geom[fmt].slot_w * geom[fmt].cpp);
+    if( !a ) {
+        a = 1;
+    }
+
+    if((w > (uint32_t)(tc->win_x1 - tc->win_x0 + 1)) ||
+       (h > (uint32_t)(tc->win_y1 - tc->win_y0 + 1))) {
+        return (-1);
+    }
+
+    /* first fit, scanning the window top to bottom and left to right */
+    for( y = tc->win_y0; y + h - 1 <= tc->win_y1; y++ ) {
+        x = ((tc->win_x0 + a - 1) / a) * a;
+
+        while( x + w - 1 <= tc->win_x1 ) {
+            used = -1;
+
+            for( row = y; row < (int)(y + h); row++ ) {
+                used = row_first_used(tc, row, x, w);
+                if( used >= 0 ) {
+                    break;
+                }
+            }
+
+            if( used < 0 ) {
+                for( row = y; row < (int)(y + h); row++ ) {
+                    row_mark(tc, row, x, w, 1);
+                }
+
+                area->x0 = x;
+                area->y0 = y;
+                area->x1 = x + w - 1;
+                area->y1 = y + h - 1;
+                tc->slots_used += w * h;
+                return (0);
+            }
+
+            /* skip past the slot in the way, keeping the alignment */
+            x = ((used + 1 + a - 1) / a) * a;
+        }
+    }
+
+    return (-1);
+}
+
+int tiler_container_reserve_1d(tiler_container *tc, uint32_t size,
+                               tiler_area *area)
+{
+    int         win_w = tc->win_x1 - tc->win_x0 + 1;
+    int         full_rows = (win_w == TILER_CONTAINER_WIDTH);
+    uint32_t    n = (size + TILER_SLOT_SIZE - 1) / TILER_SLOT_SIZE;
+    uint32_t    run = 0;
+    int         x, y, start = 0;
+
+    if( !n ) {
+        return (-1);
+    }
+
+    /* Page mode addresses are linear over whole container rows, so a run
+     * may only wrap to the next row when the window spans the full width.
+     */
+    if( !full_rows && (n > (uint32_t)win_w)) {
+        return (-1);
+    }
+
+    for( y = tc->win_y0; y <= tc->win_y1; y++ ) {
+        if( !full_rows ) {
+            run = 0;
+        }
+
+        for( x = tc->win_x0; x <= tc->win_x1; x++ ) {
+            if( slot_is_used(tc, x, y)) {
+                run = 0;
+                continue;
+            }
+
+            if( !run ) {
+                start = y * TILER_CONTAINER_WIDTH + x;
+            }
+
+            if( ++run == n ) {
+                area->x0 = start % TILER_CONTAINER_WIDTH;
+                area->y0 = start / TILER_CONTAINER_WIDTH;
+                area->x1 = x;
+                area->y1 = y;
+                area_mark(tc, TILER_FMT_PAGE, area, 1);
+                tc->slots_used += n;
+                return (0);
+            }
+        }
+    }
+
+    return (-1);
+}
+
+void tiler_container_release(tiler_container *tc, tiler_fmt fmt,
+                             const tiler_area *area)
+{
+    area_mark(tc, fmt, area, 0);
+    tc->slots_used -= tiler_area_slots(fmt, area);
+}
+
+uint32_t tiler_area_slots(tiler_fmt fmt, const tiler_area *area)
+{
+    if( fmt == TILER_FMT_PAGE ) {
+        return ((area->y1 * TILER_CONTAINER_WIDTH + area->x1) -
+                (area->y0 * TILER_CONTAINER_WIDTH + area->x0) + 1);
+    }
+
+    return ((area->x1 - area->x0 + 1) * (area->y1 - area->y0 + 1));
+}
+
+int tiler_area_rects(tiler_fmt fmt, const tiler_area *area, tiler_area rect[3])
+{
+    int    n = 0;
+
+    if((fmt != TILER_FMT_PAGE) || (area->y0 == area->y1)) {
+        rect[0] = *area;
+        return (1);
+    }
+
+    /* partial first row */
+    rect[n].x0 = area->x0;
+    rect[n].y0 = area->y0;
+    rect[n].x1 = TILER_CONTAINER_WIDTH - 1;
+    rect[n].y1 = area->y0;
+    n++;
+
+    /* full rows in between */
+    if( area->y1 - area->y0 > 1 ) {
+        rect[n].x0 = 0;
+        rect[n].y0 = area->y0 + 1;
+        rect[n].x1 = TILER_CONTAINER_WIDTH - 1;
+        rect[n].y1 = area->y1 - 1;
+        n++;
+    }
+
+    /* partial last row */
+    rect[n].x0 = 0;
+    rect[n].y0 = area->y1;
+    rect[n].x1 = area->x1;
+    rect[n].y1 = area->y1;
+    n++;
+
+    return (n);
+}
+
+uint32_t tiler_area_offset(tiler_fmt fmt, const tiler_area *area)
+{
+    uint32_t    off;
+
+    if( fmt == TILER_FMT_PAGE ) {
+        off = (area->y0 * TILER_CONTAINER_WIDTH + area->x0) * TILER_SLOT_SIZE;
+    } else {
+        off = area->y0 * geom[fmt].slot_h * geom[fmt].stride +
+              area->x0 * geom[fmt].slot_w * geom[fmt].cpp;
+    }
+
+    return (off | ((uint32_t)fmt << TILER_ACC_MODE_SHIFT));
+}
+
+uint32_t tiler_fmt_stride(tiler_fmt fmt)
+{
+    return (geom[fmt].stride);
+}
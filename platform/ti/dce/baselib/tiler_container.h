@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __TILER_CONTAINER_H__
+#define __TILER_CONTAINER_H__
+
+#include <stdint.h>
+
+/* Slot allocator for the DMM/TILER container.
+ *
+ * The container is a grid of 256x128 slots, each slot being backed by
+ * one 4KB page through the DMM PAT.  In the 8/16/32-bit modes a slot
+ * covers a 2D block of pixels, in page mode slots are laid out in raster
+ * order and give a 1D (linear) view.
+ *
+ * The host owns the container, so the IPU only allocates inside a window
+ * of slots which the host side tiler has been told to leave alone.
+ *
+ * There is no OS dependency in here: the allocator is plain C and builds
+ * on the host as well.  Programming the PAT is left to the caller.
+ * test/tiler_container_test.c runs it on the host against a stand-in of
+ * the PAT.
+ */
+
+#define TILER_CONTAINER_WIDTH     256   /* in slots */
+#define TILER_CONTAINER_HEIGHT    128   /* in slots */
+#define TILER_SLOT_SIZE           4096  /* bytes of backing per slot */
+
+#define TILER_ACC_MODE_SHIFT      27
+
+typedef enum tiler_fmt {
+    TILER_FMT_8BIT  = 0,
+    TILER_FMT_16BIT = 1,
+    TILER_FMT_32BIT = 2,
+    TILER_FMT_PAGE  = 3
+} tiler_fmt;
+
+/* inclusive slot coordinates of an allocated area.  For page mode areas
+ * (x0,y0) is the first slot and (x1,y1) the last one in raster order.
+ */
+typedef struct tiler_area {
+    uint16_t    x0, y0;
+    uint16_t    x1, y1;
+} tiler_area;
+
+typedef struct tiler_container {
+    uint16_t    win_x0, win_y0;
+    uint16_t    win_x1, win_y1;
+    uint32_t    slots_used;
+    uint32_t    map[TILER_CONTAINER_HEIGHT][TILER_CONTAINER_WIDTH / 32];
+} tiler_container;
+
+/* Set up an empty container which only hands out slots from the
+ * inclusive window (x0,y0)-(x1,y1).  Returns -1 on a bad window.
+ */
+int tiler_container_init(tiler_container *tc, int x0, int y0, int x1, int y1);
+
+/* Reserve a 2D area for a width x height buffer (in pixels of the given
+ * format).  align is the requested start alignment in bytes.
+ * Returns 0 on success, -1 if the window has no room left.
+ */
+int tiler_container_reserve_2d(tiler_container *tc, tiler_fmt fmt,
+                               uint32_t width, uint32_t height,
+                               uint32_t align, tiler_area *area);
+
+/* Reserve a run of slots for a page mode buffer of size bytes. */
+int tiler_container_reserve_1d(tiler_container *tc, uint32_t size,
+                               tiler_area *area);
+
+void tiler_container_release(tiler_container *tc, tiler_fmt fmt,
+                             const tiler_area *area);
+
+/* Number of slots (and so of backing pages) covered by an area */
+uint32_t tiler_area_slots(tiler_fmt fmt, const tiler_area *area);
+
+/* Split an area into the rectangles which the PAT can be refilled with.
+ * 2D areas are a single rectangle, page mode areas crossing rows are made
+ * of a partial first row, full rows, and a partial last row.  Returns the
+ * number of rectangles written to rect[] (at most 3).
+ */
+int tiler_area_rects(tiler_fmt fmt, const tiler_area *area, tiler_area rect[3]);
+
+/* Offset of the area in the TILER system space, access mode included */
+uint32_t tiler_area_offset(tiler_fmt fmt, const tiler_area *area);
+
+/* Line stride in bytes of a buffer in the given mode */
+uint32_t tiler_fmt_stride(tiler_fmt fmt);
+
+#endif /* __TILER_CONTAINER_H__ */
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <string.h>
+
+#include "admission.h"
+
+#define ADM_MB_SIZE        16
+#define ADM_DEFAULT_COST   1000
+
+#ifndef   DIM
+#  define DIM(a) (sizeof((a)) / sizeof((a)[0]))
+#endif
+
+/* Starting point, IVA-HD cycles per macroblock for typical content,
+ * worst profile.  Calibration takes over after the first frames.
+ */
+static const struct {
+    const char    *name;
+    uint32_t       cycles_per_mb;
+} adm_defaults[] =
+{
+    { "ivahd_h264dec",   800 },
+    { "ivahd_h264enc",   1400 },
+    { "ivahd_mpeg4dec",  600 },
+    { "ivahd_mpeg4enc",  900 },
+    { "ivahd_mpeg2vdec", 500 },
+    { "ivahd_vc1vdec",   800 },
+    { "ivahd_jpegvdec",  300 },
+    { "ivahd_jpegvenc",  300 },
+};
+
+void dce_adm_init(dce_adm *adm, uint32_t mhz, uint32_t headroom)
+{
+    memset(adm, 0, sizeof(*adm));
+    adm->capacity = mhz * 1000;
+    adm->headroom = headroom;
+}
+
+/* Whether a live stream refers to costs[cost] */
+static int cost_used(const dce_adm *adm, int cost)
+{
+    int    i;
+
+    for( i = 0; i < DCE_ADM_MAX_STREAMS; i++ ) {
+        if( adm->streams[i].id && (adm->streams[i].cost == cost)) {
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+/* Cycles per macroblock a codec starts from, before calibration */
+static uint32_t default_cost(const char *name)
+{
+    uint32_t    i;
+
+    for( i = 0; i < DIM(adm_defaults); i++ ) {
+        if( !strcmp(adm_defaults[i].name, name)) {
+            return (adm_defaults[i].cycles_per_mb);
+        }
+    }
+
+    return (ADM_DEFAULT_COST);
+}
+
+/* Entry of name/profile, or -1 when there is none yet */
+static int lookup_cost(const dce_adm *adm, const char *name, int32_t profile)
+{
+    int    i;
+
+    for( i = 0; i < DCE_ADM_MAX_COSTS; i++ ) {
+        if( adm->costs[i].name[0] && (adm->costs[i].profile == profile) &&
+            !strncmp(adm->costs[i].name, name, DCE_ADM_NAME_SIZE - 1)) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/* Entry of name/profile, created when there is none.  Returns -1 when
+ * all the entries are used by live streams.
+ */
+static int find_cost(dce_adm *adm, const char *name, int32_t profile)
+{
+    int    i, free_slot;
+
+    free_slot = lookup_cost(adm, name, profile);
+    if( free_slot >= 0 ) {
+        return (free_slot);
+    }
+
+    for( i = 0; i < DCE_ADM_MAX_COSTS; i++ ) {
+        if( !adm->costs[i].name[0] ) {
+            free_slot = i;
+            break;
+        }
+    }
+
+    /* recycle the least calibrated entry no stream uses when full */
+    if( free_slot < 0 ) {
+        for( i = 0; i < DCE_ADM_MAX_COSTS; i++ ) {
+            if( !cost_used(adm, i) && ((free_slot < 0) ||
+                                       (adm->costs[i].samples < adm->costs[free_slot].samples))) {
+                free_slot = i;
+            }
+        }
+        if( free_slot < 0 ) {
+            return (-1);
+        }
+    }
+
+    strncpy(adm->costs[free_slot].name, name, DCE_ADM_NAME_SIZE - 1);
+    adm->costs[free_slot].name[DCE_ADM_NAME_SIZE - 1] = '\0';
+    adm->costs[free_slot].profile = profile;
+    adm->costs[free_slot].samples = 0;
+    adm->costs[free_slot].cycles_per_mb = default_cost(name);
+
+    return (free_slot);
+}
+
+static dce_adm_stream *find_stream(dce_adm *adm, void *id, int create)
+{
+    dce_adm_stream    *free_slot = NULL;
+    int                i;
+
+    for( i = 0; i < DCE_ADM_MAX_STREAMS; i++ ) {
+        if( adm->streams[i].id == id ) {
+            return (&adm->streams[i]);
+        }
+        if( !free_slot && !adm->streams[i].id ) {
+            free_slot = &adm->streams[i];
+        }
+    }
+
+    if( create && free_slot ) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->id = id;
+        free_slot->cost = -1;
+        return (free_slot);
+    }
+
+    return (NULL);
+}
+
+static uint32_t load_of(uint32_t mbs, uint32_t fps_x1000, uint32_t cpm)
+{
+    uint64_t    load = (uint64_t)mbs * fps_x1000 * cpm / 1000000;
+
+    return ((load > 0xffffffff) ? 0xffffffff : (uint32_t)load);
+}
+
+static uint32_t stream_load(const dce_adm *adm, const dce_adm_stream *s)
+{
+    uint32_t    cpm = (s->cost < 0) ? ADM_DEFAULT_COST : adm->costs[s->cost].cycles_per_mb;
+
+    return (load_of(s->mbs, s->fps_x1000, cpm));
+}
+
+static uint32_t mbs_of(uint32_t width, uint32_t height)
+{
+    return (((width + ADM_MB_SIZE - 1) / ADM_MB_SIZE) *
+            ((height + ADM_MB_SIZE - 1) / ADM_MB_SIZE));
+}
+
+uint32_t dce_adm_cost_of(const dce_adm *adm, const char *name, int32_t profile,
+                         uint32_t width, uint32_t height, uint32_t fps_x1000)
+{
+    int    cost = lookup_cost(adm, name, profile);
+
+    return (load_of(mbs_of(width, height), fps_x1000,
+                    (cost < 0) ? default_cost(name) : adm->costs[cost].cycles_per_mb));
+}
+
+/* Recompute the load of s, and whether everything still fits */
+static int commit(dce_adm *adm, dce_adm_stream *s)
+{
+    uint32_t    limit = (uint32_t)((uint64_t)adm->capacity * (100 - adm->headroom) / 100);
+
+    adm->committed -= s->load;
+    s->load = stream_load(adm, s);
+    adm->committed += s->load;
+
+    return ((adm->committed > limit) ? -1 : 0);
+}
+
+int dce_adm_admit(dce_adm *adm, void *id, const char *name, int32_t profile,
+                  uint32_t width, uint32_t height, uint32_t fps_x1000,
+                  int refuse)
+{
+    dce_adm_stream    *s = find_stream(adm, id, 1);
+
+    if( !s ) {
+        return (-1);
+    }
+
+    s->cost = find_cost(adm, name, profile);
+    s->mbs = mbs_of(width, height);
+    s->fps_x1000 = fps_x1000;
+
+    if( commit(adm, s) < 0 ) {
+        if( refuse ) {
+            dce_adm_remove(adm, id);
+        }
+        return (-1);
+    }
+
+    return (0);
+}
+
+int dce_adm_set_fps(dce_adm *adm, void *id, uint32_t fps_x1000, int refuse)
+{
+    dce_adm_stream    *s = find_stream(adm, id, 0);
+    uint32_t           old;
+
+    if( !s ) {
+        return (0);
+    }
+
+    old = s->fps_x1000;
+    s->fps_x1000 = fps_x1000;
+
+    if( commit(adm, s) < 0 ) {
+        if( refuse ) {
+            s->fps_x1000 = old;
+            commit(adm, s);
+        }
+        return (-1);
+    }
+
+    return (0);
+}
+
+void dce_adm_remove(dce_adm *adm, void *id)
+{
+    dce_adm_stream    *s = find_stream(adm, id, 0);
+
+    if( s ) {
+        adm->committed -= s->load;
+        s->id = NULL;
+    }
+}
+
+void dce_adm_frame(dce_adm *adm, void *id, uint32_t width, uint32_t height,
+                   uint32_t cycles)
+{
+    dce_adm_stream    *s = find_stream(adm, id, 0);
+    dce_adm_cost      *c;
+    uint32_t           mbs, cpm;
+    int                i;
+
+    if( !s || (s->cost < 0)) {
+        return;
+    }
+
+    /* the admitted size is the largest the instance may see */
+    mbs = (width && height) ? mbs_of(width, height) : s->mbs;
+    if( !mbs ) {
+        return;
+    }
+
+    c = &adm->costs[s->cost];
+    cpm = cycles / mbs;
+
+    /* moving average, 1/8 weight, starting from the first measure */
+    if( c->samples++ ) {
+        c->cycles_per_mb = (uint32_t)((int32_t)c->cycles_per_mb +
+                                      ((int32_t)cpm - (int32_t)c->cycles_per_mb) / 8);
+    } else {
+        c->cycles_per_mb = cpm;
+    }
+
+    /* the committed load follows the calibration */
+    adm->committed = 0;
+    for( i = 0; i < DCE_ADM_MAX_STREAMS; i++ ) {
+        if( adm->streams[i].id ) {
+            adm->streams[i].load = stream_load(adm, &adm->streams[i]);
+            adm->committed += adm->streams[i].load;
+        }
+    }
+}
+
+uint32_t dce_adm_remaining(const dce_adm *adm)
+{
+    uint32_t    limit = (uint32_t)((uint64_t)adm->capacity * (100 - adm->headroom) / 100);
+
+    return ((adm->committed >= limit) ? 0 : limit - adm->committed);
+}
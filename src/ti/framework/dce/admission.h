@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __ADMISSION_H__
+#define __ADMISSION_H__
+
+#include <stdint.h>
+
+/* IVA-HD admission control model.
+ *
+ * Each instance commits IVA-HD load from what it declares at create time
+ * (resolution, frame rate): macroblocks per second times the cost of a
+ * macroblock for its codec and profile, in IVA-HD cycles.  Instances are
+ * refused (or only flagged) when the committed load would go over the
+ * capacity, less a headroom.
+ *
+ * Costs start from a built-in table and are calibrated from the IVA-HD
+ * cycles measured on each frame, over the size of that frame rather than
+ * the one admitted, so the model follows what the codecs really take on
+ * this part and these streams.  A cost entry is only recycled once no
+ * instance uses it, new codecs take the default cost when all are used.
+ *
+ * Loads are in kcycles/s.  Plain C without any BIOS dependency, so it can
+ * be built and exercised on a host.  Not reentrant, the caller serializes.
+ */
+
+#define DCE_ADM_MAX_COSTS      16
+#define DCE_ADM_MAX_STREAMS    32
+#define DCE_ADM_NAME_SIZE      24
+
+typedef struct dce_adm_cost {
+    char        name[DCE_ADM_NAME_SIZE];    /* codec, empty when unused */
+    int32_t     profile;
+    uint32_t    cycles_per_mb;              /* moving average once measured */
+    uint32_t    samples;
+} dce_adm_cost;
+
+typedef struct dce_adm_stream {
+    void        *id;            /* codec handle, NULL when unused */
+    int          cost;          /* index in costs[], -1 for the default */
+    uint32_t     mbs;           /* macroblocks per frame */
+    uint32_t     fps_x1000;
+    uint32_t     load;          /* committed, kcycles/s */
+} dce_adm_stream;
+
+typedef struct dce_adm {
+    uint32_t          capacity;     /* kcycles/s */
+    uint32_t          headroom;     /* % of the capacity kept free */
+    uint32_t          committed;    /* kcycles/s */
+    dce_adm_cost      costs[DCE_ADM_MAX_COSTS];
+    dce_adm_stream    streams[DCE_ADM_MAX_STREAMS];
+} dce_adm;
+
+void dce_adm_init(dce_adm *adm, uint32_t mhz, uint32_t headroom);
+
+/* Load an instance of codec name/profile at width x height, fps_x1000
+ * frames per second would commit, in kcycles/s.  Leaves adm untouched.
+ */
+uint32_t dce_adm_cost_of(const dce_adm *adm, const char *name, int32_t profile,
+                         uint32_t width, uint32_t height, uint32_t fps_x1000);
+
+/* Commit the load of instance id.  Returns 0 if it fits within the
+ * capacity less the headroom, -1 if it does not, in which case it is
+ * committed anyway unless refuse is set.
+ */
+int dce_adm_admit(dce_adm *adm, void *id, const char *name, int32_t profile,
+                  uint32_t width, uint32_t height, uint32_t fps_x1000,
+                  int refuse);
+
+/* Change the frame rate of id, same as dce_adm_admit(), a refused change
+ * leaves the previous frame rate committed.
+ */
+int dce_adm_set_fps(dce_adm *adm, void *id, uint32_t fps_x1000, int refuse);
+
+void dce_adm_remove(dce_adm *adm, void *id);
+
+/* A frame of id, width x height (0 x 0 if unknown: the admitted size),
+ * took cycles IVA-HD cycles.
+ */
+void dce_adm_frame(dce_adm *adm, void *id, uint32_t width, uint32_t height,
+                   uint32_t cycles);
+
+/* What is left before the headroom, kcycles/s */
+uint32_t dce_adm_remaining(const dce_adm *adm);
+
+#endif /* __ADMISSION_H__ */
@@ -44,10 +44,13 @@
 #include <ti/pm/IpcPower.h>
 #include <ti/sdo/ce/global/CESettings.h>
 #include <ti/sdo/ce/Engine.h>
+#include <ti/sdo/ce/visa.h>
+#include <ti/xdais/ires.h>
 #include <ti/sdo/fc/global/FCSettings.h>
 #include <ti/sdo/fc/utils/fcutils.h>
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/hal/Cache.h>
+#include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/posix/pthread.h>
@@ -56,21 +59,48 @@
 #include <xdc/runtime/Diags.h>
 #include <xdc/runtime/Memory.h>
 #include <xdc/runtime/IHeap.h>
+#include <xdc/runtime/Timestamp.h>
 #include <xdc/runtime/knl/Thread.h>
 #include <xdc/std.h>
 #include <ti/sysbios/utils/Load.h>
 
+#include <ti/sdo/codecs/h264vdec/ih264vdec.h>
+
+#include <platform/ti/dce/baselib/dce_heap.h>
+
 #include "dce_priv.h"
 #include "dce_rpc.h"
+#include "h264_sps.h"
+#include "timeline.h"
+#include "admission.h"
+#include "rpcprof.h"
+#include "lockprof.h"
 #include "ti/utils/profile.h"
 
 static uint32_t    suspend_initialised = 0;
 uint32_t           dce_debug = DCE_DEBUG_LEVEL;
+/* Set to create H.264 decoders with the buffers the stream really needs
+ * rather than with the worst case asked for by the client, see dpb_create().
+ */
+uint32_t           dce_dpb_autosize = 0;
+/* Set to have H.264 decoders claim the IVA-HD only once their M4 side
+ * parsing is done, see dce_yield().
+ */
+uint32_t           dce_late_acquire = 0;
+/* IVA-HD admission control, see admission.h: 0 off, 1 only trace the
+ * instances going over the capacity, 2 refuse them.  The headroom is in %
+ * of the capacity, dce_admission_fps is the frame rate assumed for the
+ * instances which do not declare one (decoders, encoders until
+ * XDM_SETPARAMS).
+ */
+uint32_t           dce_admission = 0;
+uint32_t           dce_admission_headroom = 10;
+uint32_t           dce_admission_fps = 30;
+static dce_adm     admission;
 
 #define SERVER_NAME "rpmsg-dce"
 #define CALLBACK_SERVER_NAME "dce-callback"
 
-#define MEMORYSTATS_DEBUG
 /* Each client is based on a unique id from MmServiceMgr which is the connect identity */
 /*   created by IPC per MmRpc_create instances                                         */
 #define NUM_CLIENTS 10
@@ -116,12 +146,51 @@ static int videnc2_reloc(VIDDEC3_Handle handle, uint8_t *ptr, uint32_t len);
 static VIDDEC3_Handle viddec3_create(Engine_Handle engine, String name, VIDDEC3_Params *params);
 static XDAS_Int32 viddec3_control(VIDDEC3_Handle codec,VIDDEC3_Cmd id,VIDDEC3_DynamicParams * dynParams,VIDDEC3_Status * status);
 static XDAS_Int32 viddec3_process(VIDDEC3_Handle codec, XDM2_BufDesc *inBufs, XDM2_BufDesc *outBufs, VIDDEC3_InArgs *inArgs, VIDDEC3_OutArgs *outArgs);
+static void viddec3_delete(VIDDEC3_Handle codec);
 
 static Int32 get_rproc_info(UInt32 size, UInt32 *data);
 
 static int viddec3_reloc(VIDDEC3_Handle handle, uint8_t *ptr, uint32_t len);
 
 static Semaphore_Handle sync_process_sem;
+static Dce_Lock        *sync_process_lock = NULL;  /* see lockprof.h */
+/* Task running a process call, with sync_process_sem held */
+static Task_Handle      process_task = NULL;
+static Uint32           process_codec = 0;
+static void            *process_cls = NULL;
+static Int              process_prio = 0;
+static uint32_t         process_yields = 0;
+static Dce_Rpc_Prof    *process_prof = NULL;
+static Ivahd_Frame     *process_frame = NULL;
+
+/* posted once ivahd_init() is done, see ivahd_init_main() */
+static Semaphore_Handle ivahd_ready_sem;
+static volatile Bool    ivahd_ready = FALSE;
+
+uint32_t    dce_init_us[DCE_STAGE_NUM];
+
+static const char * const    dce_stage_names[DCE_STAGE_NUM] = {
+    "main", "rpmsg", "ivahd-init", "ivahd-rman", "ivahd-boot",
+    "server", "first-open", "first-frame"
+};
+
+void dce_init_stage(Dce_Stage stage)
+{
+    if( !dce_init_us[stage] ) {
+        dce_init_us[stage] = ivahd_now_us();
+        INFO("stage %s at %d us", dce_stage_names[stage], dce_init_us[stage]);
+    }
+}
+
+/* Wait for the IVA-HD bring-up started at boot to be over */
+static void wait_ivahd_ready(void)
+{
+    if( !ivahd_ready ) {
+        Semaphore_pend(ivahd_ready_sem, BIOS_WAIT_FOREVER);
+        /* let the next waiter through too */
+        Semaphore_post(ivahd_ready_sem);
+    }
+}
 
 typedef struct {
     XDM_DataSyncHandle dataSyncHandle;
@@ -135,6 +204,7 @@ typedef struct {
     Uint32 mpu_crash_indication;
     Uint32 putdata_toclient;
     Uint32 putData_endprocess;
+    Dce_Lock *lock;     /* profile of callback_mutex */
 } Callback_data;
 
 typedef struct {
@@ -146,6 +216,9 @@ typedef struct {
     Uint32 codec_id;
     Callback_data decode_callback[NUM_INSTANCE];
     Callback_data encode_callback[NUM_INSTANCE];
+    Uint32 late_acquire[NUM_INSTANCE]; /* decode_codec[] may acquire late */
+    Uint32 decode_busy[NUM_INSTANCE];  /* in process(), see codec_wait_idle() */
+    Uint32 encode_busy[NUM_INSTANCE];
 } Client;
 static Client clients[NUM_CLIENTS] = {0};
 
@@ -179,6 +252,39 @@ static inline Client * get_client_instance(Uint32 codec)
     return NULL;
 }
 
+/* In process() mark of an instance, NULL for an unknown one */
+static Uint32 *codec_busy(Uint32 codec)
+{
+    int i, j;
+
+    for( i = 0; i < DIM(clients); i++ ) {
+        for( j = 0; j < DIM(clients[i].decode_codec); j++ ) {
+            if( clients[i].decode_codec[j] == (VIDDEC3_Handle) codec ) {
+                return (&clients[i].decode_busy[j]);
+            }
+            if( clients[i].encode_codec[j] == (VIDENC2_Handle) codec ) {
+                return (&clients[i].encode_busy[j]);
+            }
+        }
+    }
+    return (NULL);
+}
+
+/* IVA-HD channel of a decoder set up for late acquire, or -1 */
+static XDAS_Int32 late_acquire_channel(Uint32 codec)
+{
+    int i, j;
+
+    for( i = 0; i < DIM(clients); i++ ) {
+        for( j = 0; j < DIM(clients[i].decode_codec); j++ ) {
+            if( clients[i].decode_codec[j] == (VIDDEC3_Handle) codec ) {
+                return (clients[i].late_acquire[j] ? i * NUM_INSTANCE + j : -1);
+            }
+        }
+    }
+    return (-1);
+}
+
 static struct {
     CreateFxn  create;
     ControlFxn control;
@@ -196,7 +302,7 @@ static struct {
     [OMAP_DCE_VIDDEC3] =
     {
         (CreateFxn)viddec3_create,   (ControlFxn)viddec3_control,
-        (ProcessFxn)viddec3_process, (DeleteFxn)VIDDEC3_delete,
+        (ProcessFxn)viddec3_process, (DeleteFxn)viddec3_delete,
         (RelocFxn)viddec3_reloc,
     },
 };
@@ -220,6 +326,7 @@ static void dce_suspend()
 {
     INFO("Preparing for suspend...");
     FC_suspend();
+    ivahd_idle_flush();
 }
 
 static void dce_resume()
@@ -328,6 +435,339 @@ static void get_viddec3_version(VIDDEC3_Handle h, char *buffer, unsigned size)
     }
 }
 
+/* Automatic DPB sizing for H.264 decoders (dce_dpb_autosize).
+ *
+ * Clients tend to create decoders for the worst case (level 5.1, 16 frames
+ * of 1080p or more) whatever the stream.  When enabled, the decoder is still
+ * created with the client's params so GETBUFINFO and friends behave as
+ * usual, but on the first process call the SPS is looked up in the input,
+ * and the instance is created again with the resolution, level and DPB
+ * depth the stream actually needs (never more than what the client asked
+ * for).  A later SPS needing more makes the instance grow, after draining
+ * the frames still held by the smaller one: the process calls flush it,
+ * one frame to display per call, and consume none of the input, which
+ * the client submits again as XDM asks.  The call ending the flush goes
+ * on with the new instance.
+ *
+ * As the real codec handle changes under the client's feet, the handle
+ * given back to it is the Dpb_data record.
+ */
+#define DPB_SPS_SCAN_SIZE   (16 * 1024)
+#define DPB_NAME_SIZE       32
+#define DPB_MAX_FLUSH       17  /* a full DPB, plus the call returning the error */
+
+typedef struct {
+    VIDDEC3_Handle             codec;      /* instance currently decoding */
+    Engine_Handle              engine;
+    char                       name[DPB_NAME_SIZE];
+    IH264VDEC_Params           params;     /* as asked for by the client */
+    IH264VDEC_Params           sized;      /* what codec was created with */
+    IH264VDEC_DynamicParams    dyn_params; /* last XDM_SETPARAMS, replayed on create */
+    Uint32                     have_dyn;
+    Uint32                     resized;
+    Uint32                     draining;   /* flush calls so far, before growing */
+    IH264VDEC_Params           grow;       /* to create once drained */
+} Dpb_data;
+
+static Dpb_data   *dpb_instances[NUM_CLIENTS * NUM_INSTANCE];
+
+/* The algorithm of a CE codec instance */
+static IALG_Handle instance_alg(void *instance)
+{
+    IALG_Fxns      *fxns = NULL;
+    IALG_Handle     alg = NULL;
+
+    VISA_getAlgFxns((VISA_Handle)instance, &fxns, &alg);
+
+    return (alg);
+}
+
+/* H.264 level_idc to IH264VDEC_LevelId, in enum order */
+static const uint8_t    dpb_levels[] =
+{
+    10, 9, 11, 12, 13, 20, 21, 22, 30, 31, 32, 40, 41, 42, 50, 51
+};
+
+static Dpb_data *dpb_lookup(VIDDEC3_Handle codec)
+{
+    int    i;
+
+    for( i = 0; i < DIM(dpb_instances); i++ ) {
+        if( dpb_instances[i] && (VIDDEC3_Handle)dpb_instances[i] == codec ) {
+            return (dpb_instances[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/* The codec instance behind a handle given to the client */
+static VIDDEC3_Handle dpb_codec(VIDDEC3_Handle codec)
+{
+    Dpb_data   *dpb = dpb_lookup(codec);
+
+    return (dpb ? dpb->codec : codec);
+}
+
+static int dpb_eligible(String name, VIDDEC3_Params *params)
+{
+    return (dce_dpb_autosize && !strcmp(name, "ivahd_h264dec") &&
+            (strlen(name) < DPB_NAME_SIZE) &&
+            (params->size == sizeof(IH264VDEC_Params)) &&
+            (params->outputDataMode != IVIDEO_NUMROWS));
+}
+
+static VIDDEC3_Handle dpb_create(Engine_Handle engine, String name, IH264VDEC_Params *params)
+{
+    Dpb_data   *dpb;
+    int         i;
+
+    for( i = 0; i < DIM(dpb_instances); i++ ) {
+        if( !dpb_instances[i] ) {
+            break;
+        }
+    }
+
+    if( i == DIM(dpb_instances)) {
+        ERROR("No more DPB autosize slots, creating %s as asked", name);
+        return (VIDDEC3_create(engine, name, (VIDDEC3_Params *)params));
+    }
+
+    dpb = Memory_calloc(NULL, sizeof(Dpb_data), 0, NULL);
+    if( !dpb ) {
+        ERROR("DPB autosize record allocation failed");
+        return (NULL);
+    }
+
+    dpb->codec = VIDDEC3_create(engine, name, (VIDDEC3_Params *)params);
+    if( !dpb->codec ) {
+        Memory_free(NULL, dpb, sizeof(Dpb_data));
+        return (NULL);
+    }
+
+    dpb->engine = engine;
+    strcpy(dpb->name, name);
+    dpb->params = *params;
+    dpb->sized = *params;
+    dpb_instances[i] = dpb;
+
+    return ((VIDDEC3_Handle)dpb);
+}
+
+static void dpb_delete(Dpb_data *dpb)
+{
+    int    i;
+
+    for( i = 0; i < DIM(dpb_instances); i++ ) {
+        if( dpb_instances[i] == dpb ) {
+            dpb_instances[i] = NULL;
+        }
+    }
+
+    if( dpb->codec ) {
+        VIDDEC3_delete(dpb->codec);
+    }
+    Memory_free(NULL, dpb, sizeof(Dpb_data));
+}
+
+/* Params fitting the stream described by sps, clamped to the client's */
+static void dpb_params(Dpb_data *dpb, const h264_sps_info *sps, IH264VDEC_Params *p)
+{
+    XDAS_Int32    level = IH264VDEC_MAXLEVELID;
+    int           i;
+
+    *p = dpb->params;
+
+    for( i = 0; i < DIM(dpb_levels); i++ ) {
+        if( dpb_levels[i] == sps->level_idc ) {
+            level = i;
+            break;
+        }
+    }
+
+    if((XDAS_Int32)sps->width < p->viddec3Params.maxWidth ) {
+        p->viddec3Params.maxWidth = sps->width;
+    }
+    if((XDAS_Int32)sps->height < p->viddec3Params.maxHeight ) {
+        p->viddec3Params.maxHeight = sps->height;
+    }
+    if((p->dpbSizeInFrames == IH264VDEC_DPB_NUMFRAMES_AUTO) ||
+       ((XDAS_Int32)sps->dpb_frames < p->dpbSizeInFrames)) {
+        p->dpbSizeInFrames = sps->dpb_frames;
+    }
+    if((p->presetLevelIdc < 0) || (level < p->presetLevelIdc)) {
+        p->presetLevelIdc = level;
+    }
+}
+
+static int dpb_fits(const IH264VDEC_Params *p, const IH264VDEC_Params *sized)
+{
+    return ((p->viddec3Params.maxWidth <= sized->viddec3Params.maxWidth) &&
+            (p->viddec3Params.maxHeight <= sized->viddec3Params.maxHeight) &&
+            (p->dpbSizeInFrames <= sized->dpbSizeInFrames) &&
+            (p->presetLevelIdc <= sized->presetLevelIdc));
+}
+
+/* Start flushing the current instance, to be grown to p once drained */
+static void dpb_drain_start(Dpb_data *dpb, const IH264VDEC_Params *p)
+{
+    VIDDEC3_DynamicParams    dyn_params = { .size = sizeof(VIDDEC3_DynamicParams) };
+    VIDDEC3_Status           status = { .size = sizeof(VIDDEC3_Status) };
+
+    VIDDEC3_control(dpb->codec, XDM_FLUSH, &dyn_params, &status);
+    dpb->grow = *p;
+    dpb->draining = 1;
+}
+
+/* One flush call of the current instance.  Returns TRUE while it still
+ * has frames to give back, which are left in outArgs for the client.
+ * Once done, the buffers released by the last call are copied to freed[].
+ */
+static Bool dpb_drain(Dpb_data *dpb, XDM2_BufDesc *inBufs, XDM2_BufDesc *outBufs,
+                      VIDDEC3_InArgs *inArgs, VIDDEC3_OutArgs *outArgs,
+                      XDAS_Int32 *freed, int *nfreed)
+{
+    XDAS_Int32    num_bytes = inArgs->numBytes;
+    XDAS_Int32    ret;
+    int           j;
+
+    inArgs->numBytes = 0;
+    ret = VIDDEC3_process(dpb->codec, inBufs, outBufs, inArgs, outArgs);
+    inArgs->numBytes = num_bytes;
+
+    if((ret == VIDDEC3_EOK) && (dpb->draining++ < DPB_MAX_FLUSH)) {
+        /* the input is decoded by the grown instance, once drained */
+        outArgs->bytesConsumed = 0;
+        return (TRUE);
+    }
+
+    *nfreed = 0;
+    for( j = 0; j < IVIDEO2_MAX_IO_BUFFERS && outArgs->freeBufID[j]; j++ ) {
+        freed[(*nfreed)++] = outArgs->freeBufID[j];
+    }
+    dpb->draining = 0;
+
+    return (FALSE);
+}
+
+static int dpb_recreate(Dpb_data *dpb, IH264VDEC_Params *p)
+{
+    VIDDEC3_Status    status = { .size = sizeof(VIDDEC3_Status) };
+    Int               prio = hdvicp_prio_get(instance_alg(dpb->codec));
+
+    VIDDEC3_delete(dpb->codec);
+
+    dpb->codec = VIDDEC3_create(dpb->engine, dpb->name, (VIDDEC3_Params *)p);
+    if( !dpb->codec ) {
+        ERROR("Could not create %s with %dx%d, %d frames, falling back to client params",
+              dpb->name, p->viddec3Params.maxWidth, p->viddec3Params.maxHeight, p->dpbSizeInFrames);
+        *p = dpb->params;
+        dpb->codec = VIDDEC3_create(dpb->engine, dpb->name, (VIDDEC3_Params *)p);
+        if( !dpb->codec ) {
+            ERROR("Could not create %s again", dpb->name);
+            return (-1);
+        }
+    }
+
+    dpb->sized = *p;
+    hdvicp_prio_set(instance_alg(dpb->codec), prio);
+
+    if( dpb->have_dyn ) {
+        VIDDEC3_control(dpb->codec, XDM_SETPARAMS,
+                        (VIDDEC3_DynamicParams *)&dpb->dyn_params, &status);
+    }
+
+    INFO("%s sized for %dx%d, %d frames, level id %d", dpb->name,
+         p->viddec3Params.maxWidth, p->viddec3Params.maxHeight,
+         p->dpbSizeInFrames, p->presetLevelIdc);
+
+    return (0);
+}
+
+static XDAS_Int32 dpb_process(Dpb_data *dpb, XDM2_BufDesc *inBufs, XDM2_BufDesc *outBufs,
+                              VIDDEC3_InArgs *inArgs, VIDDEC3_OutArgs *outArgs)
+{
+    XDAS_Int32          freed[IVIDEO2_MAX_IO_BUFFERS];
+    h264_sps_info       sps;
+    IH264VDEC_Params    p;
+    uint8_t            *buf = NULL;
+    uint32_t            len = 0;
+    XDAS_Int32          ret;
+    int                 i, j, nfreed = 0;
+
+    if( !dpb->codec ) {
+        return (XDM_EFAIL);
+    }
+
+    if( inBufs->numBufs > 0 && inArgs->numBytes > 0 ) {
+        buf = (uint8_t *)inBufs->descs[0].buf;
+        len = inArgs->numBytes < DPB_SPS_SCAN_SIZE ? inArgs->numBytes : DPB_SPS_SCAN_SIZE;
+    }
+
+    if( buf ) {
+        Cache_inv(buf, len, Cache_Type_ALL, TRUE);
+    }
+
+    if( !dpb->draining && buf && !h264_find_sps(buf, len, &sps)) {
+        dpb_params(dpb, &sps, &p);
+
+        if( !dpb->resized ) {
+            DEBUG("first SPS: %dx%d level %d, %d frames", sps.width, sps.height,
+                  sps.level_idc, sps.dpb_frames);
+            dpb->resized = 1;
+            if( memcmp(&p, &dpb->sized, sizeof(p)) && dpb_recreate(dpb, &p)) {
+                return (XDM_EFAIL);
+            }
+        } else if( !dpb_fits(&p, &dpb->sized)) {
+            DEBUG("new SPS needs more: %dx%d level %d, %d frames", sps.width,
+                  sps.height, sps.level_idc, sps.dpb_frames);
+
+            /* never shrink along the way, only grow */
+            if( p.viddec3Params.maxWidth < dpb->sized.viddec3Params.maxWidth ) {
+                p.viddec3Params.maxWidth = dpb->sized.viddec3Params.maxWidth;
+            }
+            if( p.viddec3Params.maxHeight < dpb->sized.viddec3Params.maxHeight ) {
+                p.viddec3Params.maxHeight = dpb->sized.viddec3Params.maxHeight;
+            }
+            if( p.dpbSizeInFrames < dpb->sized.dpbSizeInFrames ) {
+                p.dpbSizeInFrames = dpb->sized.dpbSizeInFrames;
+            }
+            if( p.presetLevelIdc < dpb->sized.presetLevelIdc ) {
+                p.presetLevelIdc = dpb->sized.presetLevelIdc;
+            }
+
+            dpb_drain_start(dpb, &p);
+        }
+    }
+
+    if( dpb->draining ) {
+        if( dpb_drain(dpb, inBufs, outBufs, inArgs, outArgs, freed, &nfreed)) {
+            return (VIDDEC3_EOK);
+        }
+        if( dpb_recreate(dpb, &dpb->grow)) {
+            return (XDM_EFAIL);
+        }
+    }
+
+    ret = VIDDEC3_process(dpb->codec, inBufs, outBufs, inArgs, outArgs);
+
+    /* hand the buffers the old instance released back along with this call's */
+    j = 0;
+    while( j < IVIDEO2_MAX_IO_BUFFERS && outArgs->freeBufID[j] ) {
+        j++;
+    }
+
+    for( i = 0; i < nfreed; i++ ) {
+        if( j < IVIDEO2_MAX_IO_BUFFERS ) {
+            outArgs->freeBufID[j++] = freed[i];
+        } else {
+            ERROR("No room left in freeBufID, leaking id %d", freed[i]);
+        }
+    }
+
+    return (ret);
+}
+
 // VIDDEC3_create wrapper, to display version string in the trace.
 static VIDDEC3_Handle viddec3_create(Engine_Handle engine, String name, VIDDEC3_Params *params)
 {
@@ -336,10 +776,14 @@ static VIDDEC3_Handle viddec3_create(Engine_Handle engine, String name, VIDDEC3_
     DEBUG(">> engine=%08x, name=%s, params=%p", engine, name, params);
     DEBUG(">> max_height %d max_width %d frame_rate %d", params->maxHeight, params->maxWidth, params->maxFrameRate);
 
-    h = VIDDEC3_create(engine, name, params);
+    if( dpb_eligible(name, params)) {
+        h = dpb_create(engine, name, (IH264VDEC_Params *)params);
+    } else {
+        h = VIDDEC3_create(engine, name, params);
+    }
 
     if( h ) {
-        get_viddec3_version(h, version_buffer, VERSION_SIZE);
+        get_viddec3_version(dpb_codec(h), version_buffer, VERSION_SIZE);
         INFO("Created viddec3 %s: version %s", name, version_buffer);
     }
 
@@ -349,6 +793,21 @@ static VIDDEC3_Handle viddec3_create(Engine_Handle engine, String name, VIDDEC3_
 static XDAS_Int32 viddec3_control(VIDDEC3_Handle codec,VIDDEC3_Cmd id,VIDDEC3_DynamicParams * dynParams,VIDDEC3_Status * status)
 {
     Client* c;
+    Dpb_data* dpb;
+
+    dpb = dpb_lookup(codec);
+    if (dpb) {
+        if (id == XDM_SETPARAMS) {
+            memset(&dpb->dyn_params, 0, sizeof(dpb->dyn_params));
+            memcpy(&dpb->dyn_params, dynParams,
+                   dynParams->size < sizeof(dpb->dyn_params) ? dynParams->size : sizeof(dpb->dyn_params));
+            dpb->have_dyn = 1;
+        }
+        if (!dpb->codec) {
+            return (XDM_EFAIL);
+        }
+        return (VIDDEC3_control(dpb->codec, id, dynParams, status));
+    }
 
     c = get_client_instance((Uint32) codec);
     if (c) {
@@ -375,8 +834,14 @@ static XDAS_Int32 viddec3_control(VIDDEC3_Handle codec,VIDDEC3_Cmd id,VIDDEC3_Dy
 static XDAS_Int32 viddec3_process(VIDDEC3_Handle codec, XDM2_BufDesc *inBufs, XDM2_BufDesc *outBufs, VIDDEC3_InArgs *inArgs, VIDDEC3_OutArgs *outArgs)
 {
     Client* c;
+    Dpb_data* dpb;
     XDAS_Int32 ret;
 
+    dpb = dpb_lookup(codec);
+    if (dpb) {
+        return (dpb_process(dpb, inBufs, outBufs, inArgs, outArgs));
+    }
+
     c = get_client_instance((Uint32) codec);
     if (c) {
         int i;
@@ -400,6 +865,44 @@ static XDAS_Int32 viddec3_process(VIDDEC3_Handle codec, XDM2_BufDesc *inBufs, XD
     return (VIDDEC3_process(codec, inBufs, outBufs, inArgs, outArgs));
 }
 
+static void viddec3_delete(VIDDEC3_Handle codec)
+{
+    Dpb_data   *dpb = dpb_lookup(codec);
+
+    if( dpb ) {
+        dpb_delete(dpb);
+        return;
+    }
+
+    VIDDEC3_delete(codec);
+}
+
+/* The codec instance behind a client handle, as seen by CE */
+static void *codec_instance(Uint32 codec_id, void *codec)
+{
+    if( codec_id == OMAP_DCE_VIDDEC3 ) {
+        return ((void *)dpb_codec((VIDDEC3_Handle)codec));
+    }
+    return (codec);
+}
+
+/* What the IVA-HD has to switch context for, the codec of an instance */
+static void *codec_class(Uint32 codec_id, void *codec)
+{
+    IALG_Fxns      *fxns = NULL;
+    IALG_Handle     alg = NULL;
+
+    VISA_getAlgFxns((VISA_Handle)codec_instance(codec_id, codec), &fxns, &alg);
+
+    return ((void *)fxns);
+}
+
+/* Priority of an instance, see hdvicp_prio_set() */
+static Int codec_prio(Uint32 codec_id, void *codec)
+{
+    return (hdvicp_prio_get(instance_alg(codec_instance(codec_id, codec))));
+}
+
 static int videnc2_reloc(VIDENC2_Handle handle, uint8_t *ptr, uint32_t len)
 {
     return (-1); // Not implemented
@@ -618,6 +1121,8 @@ static void dce_unregister_codec(Uint32 type, Uint32 mm_serv_id, Uint32 codec)
             for( i = 0; i < DIM(c->decode_codec); i++ ) {
                 if( c->decode_codec[i] == (VIDDEC3_Handle) codec ) {
                     c->decode_codec[i] = NULL;
+                    c->late_acquire[i] = 0;
+                    c->decode_busy[i] = 0;
                     DEBUG("unregistered decode_codec[%d] type Decoder codec=%p", i, codec);
                     break;
                 }
@@ -627,6 +1132,7 @@ static void dce_unregister_codec(Uint32 type, Uint32 mm_serv_id, Uint32 codec)
             for( i = 0; i < DIM(c->encode_codec); i++ ) {
                 if( c->encode_codec[i] == (VIDENC2_Handle) codec ) {
                     c->encode_codec[i] = NULL;
+                    c->encode_busy[i] = 0;
                     DEBUG("unregistered encode_codec[%d] type Encoder codec=%p", i, codec);
                     break;
                 }
@@ -646,17 +1152,27 @@ static Int32 engine_open(UInt32 size, UInt32 *data)
     Engine_Handle      eng_handle = NULL;
     Uint32             num_params = MmRpc_NUM_PARAMETERS(size);
     Int32              ret = 0;
+    Dce_Rpc_Prof       prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_ENGINE_OPEN, NULL);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    wait_ivahd_ready();
+    dce_init_stage(DCE_STAGE_FIRST_OPEN);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> engine_open");
 
     if( num_params != 1 ) {
         ERROR("Invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
     dce_inv(engine_open_msg);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     eng_handle = Engine_open(engine_open_msg->name, engine_open_msg->engine_attrs, &engine_open_msg->error_code);
 
@@ -673,8 +1189,11 @@ static Int32 engine_open(UInt32 size, UInt32 *data)
 
     DEBUG("<< engine=%08x, ec=%d", eng_handle, engine_open_msg->error_code);
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     dce_clean(engine_open_msg);
-    Semaphore_post(sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
 
     return ((Int32)eng_handle);
 }
@@ -688,13 +1207,19 @@ static Int32 engine_close(UInt32 size, UInt32 *data)
     Engine_Handle    eng_handle = (Engine_Handle)payload[0].data;
     Uint32           mm_serv_id = 0;
     Uint32           num_params = MmRpc_NUM_PARAMETERS(size);
+    Dce_Rpc_Prof     prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_ENGINE_CLOSE, NULL);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> engine_close %08x", eng_handle);
 
     if( num_params != 1 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
@@ -706,22 +1231,50 @@ static Int32 engine_close(UInt32 size, UInt32 *data)
     Engine_close(eng_handle);
     DEBUG("<<");
 
-    Semaphore_post(sync_process_sem);
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
 
     return (0);
 }
 
 
+static dce_adm *get_admission(void)
+{
+    if( !admission.capacity ) {
+        dce_adm_init(&admission, ivahd_max_mhz(), dce_admission_headroom);
+    }
+    admission.headroom = dce_admission_headroom;
+    return (&admission);
+}
+
 #define INFO_TYPE_CPU_LOAD 0
 #define INFO_TYPE_TOTAL_HEAP_SIZE 1
 #define INFO_TYPE_AVAILABLE_HEAP_SIZE 2
+#define INFO_TYPE_HEAP_HIGH_WATER 3
+#define INFO_TYPE_LARGEST_FREE_HEAP 4
+#define INFO_TYPE_IVA_AWAKE_MS 5
+#define INFO_TYPE_IVA_IDLE_MS 6
+#define INFO_TYPE_IVA_TRANSITIONS 7
+#define INFO_TYPE_IVA_BOOT_US 8
+#define INFO_TYPE_IVA_RESET_US 9
+#define INFO_TYPE_CODEC_SWITCHES 10
+#define INFO_TYPE_CODEC_SWITCHES_SAVED 11
+#define INFO_TYPE_PROCESS_YIELDS 12
+#define INFO_TYPE_IVA_LOAD_REMAINING 13
+#define INFO_TYPE_IVA_LOAD_COMMITTED 14
 
 static Int32 get_rproc_info(UInt32 size, UInt32 *data)
 {
     MmType_Param    *payload = (MmType_Param *)data;
     Uint32           info_type = (Uint32)payload[0].data;
-    Memory_Stats     stats;
+    DceHeap_Stats    stats;
+    Ivahd_Residency  res;
+    Dce_Dispatch_Stats dispatch;
     Uint32           output = 0;
+    int              i;
+    Dce_Rpc_Prof     prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_GET_RPROC_INFO, NULL);
 
     switch(info_type)
     {
@@ -729,14 +1282,84 @@ static Int32 get_rproc_info(UInt32 size, UInt32 *data)
             output = Load_getCPULoad();
             break;
 
+        /* heap figures come from counters, only the largest free block
+         * walks the heaps, as it is only known exactly that way
+         */
         case INFO_TYPE_TOTAL_HEAP_SIZE:
-            Memory_getStats(NULL, &stats);
-            output = stats.totalSize;
+            for( i = 0; i < DCE_HEAP_NUM; i++ ) {
+                dce_heap_stats(i, &stats);
+                output += stats.total;
+            }
             break;
 
         case INFO_TYPE_AVAILABLE_HEAP_SIZE:
-            Memory_getStats(NULL, &stats);
-            output = stats.totalFreeSize;
+            for( i = 0; i < DCE_HEAP_NUM; i++ ) {
+                dce_heap_stats(i, &stats);
+                output += stats.total - stats.used;
+            }
+            break;
+
+        case INFO_TYPE_HEAP_HIGH_WATER:
+            for( i = 0; i < DCE_HEAP_NUM; i++ ) {
+                dce_heap_stats(i, &stats);
+                output += stats.high_water;
+            }
+            break;
+
+        case INFO_TYPE_LARGEST_FREE_HEAP:
+            for( i = 0; i < DCE_HEAP_NUM; i++ ) {
+                dce_heap_refresh(i);
+                dce_heap_stats(i, &stats);
+                if( stats.largest_free > output ) {
+                    output = stats.largest_free;
+                }
+            }
+            break;
+
+        case INFO_TYPE_IVA_AWAKE_MS:
+            ivahd_residency(&res);
+            output = (uint64_t)res.awake_ticks * Clock_tickPeriod / 1000;
+            break;
+
+        case INFO_TYPE_IVA_IDLE_MS:
+            ivahd_residency(&res);
+            output = (uint64_t)res.idle_ticks * Clock_tickPeriod / 1000;
+            break;
+
+        case INFO_TYPE_IVA_TRANSITIONS:
+            ivahd_residency(&res);
+            output = res.wakeups + res.gates;
+            break;
+
+        case INFO_TYPE_IVA_BOOT_US:
+            output = ivahd_boot_us;
+            break;
+
+        case INFO_TYPE_IVA_RESET_US:
+            output = ivahd_reset_us;
+            break;
+
+        case INFO_TYPE_CODEC_SWITCHES:
+            dce_dispatch_stats(&dispatch);
+            output = dispatch.switches;
+            break;
+
+        case INFO_TYPE_CODEC_SWITCHES_SAVED:
+            dce_dispatch_stats(&dispatch);
+            output = dispatch.saved;
+            break;
+
+        case INFO_TYPE_PROCESS_YIELDS:
+            output = process_yields;
+            break;
+
+        case INFO_TYPE_IVA_LOAD_REMAINING:
+            /* in MHz, as the capacity */
+            output = dce_adm_remaining(get_admission()) / 1000;
+            break;
+
+        case INFO_TYPE_IVA_LOAD_COMMITTED:
+            output = get_admission()->committed / 1000;
             break;
 
         default:
@@ -744,11 +1367,95 @@ static Int32 get_rproc_info(UInt32 size, UInt32 *data)
             break;
     }
 
+    dce_rpc_end(&prof);
+
     return output;
 }
 
 
 
+/* Check a new instance of codec_name against the IVA-HD capacity, and
+ * commit its load once created (codec_handle set).  Returns -1 if it has
+ * to be refused.
+ */
+static int admit_codec(Uint32 codec_id, void *codec_handle, char *codec_name,
+                       void *static_params)
+{
+    dce_adm     *adm;
+    uint32_t     width, height, load;
+    Int32        profile = 0;
+
+    if( !dce_admission ) {
+        return (0);
+    }
+
+    if( codec_id == OMAP_DCE_VIDENC2 ) {
+        width = ((VIDENC2_Params *)static_params)->maxWidth;
+        height = ((VIDENC2_Params *)static_params)->maxHeight;
+        profile = ((VIDENC2_Params *)static_params)->profile;
+    } else if( codec_id == OMAP_DCE_VIDDEC3 ) {
+        width = ((VIDDEC3_Params *)static_params)->maxWidth;
+        height = ((VIDDEC3_Params *)static_params)->maxHeight;
+    } else {
+        return (0);
+    }
+
+    adm = get_admission();
+
+    if( codec_handle ) {
+        dce_adm_admit(adm, codec_handle, codec_name, profile, width, height,
+                      dce_admission_fps * 1000, FALSE);
+        return (0);
+    }
+
+    load = dce_adm_cost_of(adm, codec_name, profile, width, height,
+                           dce_admission_fps * 1000);
+    if( load <= dce_adm_remaining(adm)) {
+        return (0);
+    }
+
+    ERROR("%s %dx%d needs %d kcycles/s of IVA-HD, %d left%s", codec_name,
+          width, height, load, dce_adm_remaining(adm),
+          (dce_admission > 1) ? ", refused" : "");
+
+    return ((dce_admission > 1) ? -1 : 0);
+}
+
+/* Size of the frame a process call worked on, 0 x 0 if unknown */
+static void frame_size(Uint32 codec_id, void *inBufs, void *outArgs,
+                       uint32_t *width, uint32_t *height)
+{
+    XDM_Rect    *r;
+
+    *width = *height = 0;
+
+    if( codec_id == OMAP_DCE_VIDENC2 ) {
+        r = &((IVIDEO2_BufDesc *)inBufs)->activeFrameRegion;
+    } else if( codec_id == OMAP_DCE_VIDDEC3 ) {
+        r = &((VIDDEC3_OutArgs *)outArgs)->decodedBufs.activeFrameRegion;
+    } else {
+        return;
+    }
+
+    if((r->bottomRight.x > r->topLeft.x) && (r->bottomRight.y > r->topLeft.y)) {
+        *width = r->bottomRight.x - r->topLeft.x;
+        *height = r->bottomRight.y - r->topLeft.y;
+    }
+}
+
+static void trace_heaps(void)
+{
+    DceHeap_Stats    stats;
+    int              i;
+
+    for( i = 0; i < DCE_HEAP_NUM; i++ ) {
+        dce_heap_stats(i, &stats);
+        INFO("Heap %d Total: %d\tFree: %d\tLargest: ~%d\tPeak used: %d", i,
+             stats.total, stats.total - stats.used, stats.largest_free,
+             stats.high_water);
+    }
+}
+
 /*
   * codec_create
   */
@@ -764,22 +1471,25 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
     void            *codec_handle;
     Int32            ret = 0;
     Client*          c;
+    Dce_Rpc_Prof     prof;
 
-#ifdef MEMORYSTATS_DEBUG
-    Memory_Stats    stats;
-#endif
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_CREATE, NULL);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> codec_create on engine %08x", engine);
 
     if( num_params != 4 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
     dce_inv(codec_name);
     dce_inv(static_params);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     /* The next source code statement shouldn't get executed in real world as the client should send */
     /* the correct width and height for the video resolution to be decoded.                          */
@@ -791,10 +1501,22 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
         System_printf("Crashing the IPU2 after divided by zero num_params %d", num_params);
     }
 
+    if( admit_codec(codec_id, NULL, codec_name, static_params) < 0 ) {
+        dce_clean(static_params);
+        dce_clean(codec_name);
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        return (0);
+    }
+
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     ivahd_acquire();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
 
     codec_handle = (void *)codec_fxns[codec_id].create(engine, codec_name, static_params);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
     ivahd_release();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
 
     if( codec_handle ) {
         mm_serv_id = MmServiceMgr_getId();
@@ -804,8 +1526,19 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
             codec_fxns[codec_id].delete((void *)codec_handle);
             codec_handle = NULL;
         } else {
+            admit_codec(codec_id, codec_handle, codec_name, static_params);
+            dce_latency_add(codec_handle);
+
             if( codec_id == OMAP_DCE_VIDDEC3 ) {
                 DEBUG("codec_create for VIDDEC3 codec_handle 0x%x mm_serv_id 0x%x", codec_handle, mm_serv_id);
+                c = get_client_instance((Uint32) codec_handle);
+                int i;
+                for( i = 0; i < DIM(c->decode_codec); i++ ) {
+                    if( c->decode_codec[i] == codec_handle ) {
+                        c->late_acquire[i] = dce_late_acquire && !strcmp(codec_name, "ivahd_h264dec") &&
+                            (((VIDDEC3_Params*)static_params)->outputDataMode != IVIDEO_NUMROWS);
+                    }
+                }
                 if( ((VIDDEC3_Params*)static_params)->outputDataMode == IVIDEO_NUMROWS ) {
                     c = get_client_instance((Uint32) codec_handle);
                     int i;
@@ -813,6 +1546,7 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
                         if( c->decode_codec[i] == codec_handle ) {
                             c->decode_callback[i].row_mode = 1;
                             pthread_mutex_init(&(c->decode_callback[i].callback_mutex), NULL);
+                            c->decode_callback[i].lock = dce_lock_register("callback_mutex", codec_handle);
                             pthread_cond_init(&(c->decode_callback[i].synch_callback), NULL);
                             DEBUG("codec_create client 0x%x c->decode_callback[%d].callback_mutex 0x%x c->decode_callback[%d].row_mode %d",
                                 c, i, c->decode_callback[i].callback_mutex, i, c->decode_callback[i].row_mode);
@@ -828,6 +1562,7 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
                         if( c->encode_codec[i] == codec_handle ) {
                             c->encode_callback[i].row_mode = 1;
                             pthread_mutex_init(&(c->encode_callback[i].callback_mutex), NULL);
+                            c->encode_callback[i].lock = dce_lock_register("callback_mutex", codec_handle);
                             pthread_cond_init(&(c->encode_callback[i].synch_callback), NULL);
                             DEBUG("codec_create client 0x%x c->encode_callback[%d].callback_mutex 0x%x c->encode_callback[%d].row_mode %d",
                                 c, i, c->encode_callback[i].callback_mutex, i, c->encode_callback[i].row_mode);
@@ -839,22 +1574,38 @@ static Int32 codec_create(UInt32 size, UInt32 *data)
     }
     DEBUG("<< codec_handle=%08x on engine %08x", codec_handle, engine);
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     dce_clean(static_params);
     dce_clean(codec_name);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
-    Semaphore_post(sync_process_sem);
-
-#ifdef MEMORYSTATS_DEBUG
-    Memory_getStats(NULL, &stats);
-    INFO("Total: %d\tFree: %d\tLargest: %d", stats.totalSize,
-         stats.totalFreeSize, stats.largestFreeSize);
-#endif
 #ifdef PSI_KPI
         kpi_comp_init(codec_handle);
 #endif /*PSI_KPI*/
+    prof.codec = codec_handle;
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
+    trace_heaps();
     return ((Int32)codec_handle);
 }
 
+/* With sync_process_sem held: wait for a process call of codec which
+ * yielded it mid frame (see dce_yield()) to be done, so that the instance
+ * is not changed or deleted under it.  The lock is given up meanwhile.
+ */
+static void codec_wait_idle(Uint32 codec)
+{
+    Uint32    *busy = codec_busy(codec);
+
+    while( busy && *busy ) {
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        Task_sleep(1);
+        dce_lock_pend(sync_process_lock, sync_process_sem);
+        busy = codec_busy(codec);
+    }
+}
+
 /*
   * codec_control
   */
@@ -868,31 +1619,70 @@ static int codec_control(UInt32 size, UInt32 *data)
     void           *status              = (void *)payload[4].data;
     Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
     Int32           ret = 0;
+    Dce_Rpc_Prof    prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_CONTROL, codec_handle);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> codec_control on codec_handle %08x", codec_handle);
 
     if( num_params != 5 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
+    codec_wait_idle((Uint32)codec_handle);
+
+    if( dce_is_hibernated(codec_instance(codec_id, codec_handle))) {
+        ERROR("codec_handle %08x is hibernated", codec_handle);
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        return (XDM_EFAIL);
+    }
+
     dce_inv(dyn_params);
     dce_inv(status);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+
+    /* a new frame rate changes the load the encoder commits */
+    if( dce_admission && (codec_id == OMAP_DCE_VIDENC2) && (cmd_id == XDM_SETPARAMS) &&
+        ((VIDENC2_DynamicParams *)dyn_params)->targetFrameRate ) {
+        if( dce_adm_set_fps(get_admission(), codec_handle,
+                            ((VIDENC2_DynamicParams *)dyn_params)->targetFrameRate,
+                            dce_admission > 1) < 0 ) {
+            ERROR("codec_handle %08x at %d fps goes over the IVA-HD capacity%s", codec_handle,
+                  ((VIDENC2_DynamicParams *)dyn_params)->targetFrameRate / 1000,
+                  (dce_admission > 1) ? ", refused" : "");
+            if( dce_admission > 1 ) {
+                dce_rpc_end(&prof);
+                dce_lock_post(sync_process_lock, sync_process_sem);
+                return (XDM_EFAIL);
+            }
+        }
+    }
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     /* Only for cmd_id == XDM_FLUSH/XDM_MOVEBUF ? */
     ivahd_acquire();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
 
     ret = (uint32_t) codec_fxns[codec_id].control(codec_handle, cmd_id, dyn_params, status);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
     ivahd_release();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
 
     DEBUG("<< codec_control on codec_handle %08x result=%d", codec_handle, ret);
 
     dce_clean(dyn_params);
     dce_clean(status);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
-    Semaphore_post(sync_process_sem);
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
 
     return (ret);
 }
@@ -910,16 +1700,24 @@ static int codec_get_version(UInt32 size, UInt32 *data)
     Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
     void           *version_buf = NULL;
     Int32           ret = 0;
+    Dce_Rpc_Prof    prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_GET_VERSION, codec_handle);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> codec_get_version on codec_handle %08x", codec_handle);
 
     if( num_params != 4 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
+    codec_wait_idle((Uint32)codec_handle);
+
     dce_inv(dyn_params);
     dce_inv(status);
 
@@ -930,18 +1728,24 @@ static int codec_get_version(UInt32 size, UInt32 *data)
     }
 
     dce_inv(version_buf);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     ivahd_acquire();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
     ret = (uint32_t) codec_fxns[codec_id].control(codec_handle, XDM_GETVERSION, dyn_params, status);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
     ivahd_release();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
 
     DEBUG("<< codec_get_version on codec_handle %08x result=%d", codec_handle, ret);
 
     dce_clean(dyn_params);
     dce_clean(status);
     dce_clean(version_buf);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
-    Semaphore_post(sync_process_sem);\
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
 
     return (ret);
 }
@@ -1013,6 +1817,94 @@ XDAS_Int32 VIDENC2_process(VIDENC2_Handle handle, IVIDEO2_BufDesc *inBufs,
                                9-89
  */
 
+/* RMAN yield function (RMAN.yieldFxn in the cfg), also called by the
+ * HDVICP IRESMAN when the IVA-HD is released mid frame.
+ *
+ * A codec calls it from within its process call when it has to wait for
+ * a resource, typically an H.264 decoder which has done its M4 side
+ * parsing and wants the IVA-HD another instance is using.  The codec
+ * state is saved and the process lock given up, so that other process
+ * calls can get on with their own M4 side work meanwhile, then it is
+ * taken back and the state restored.  The IVA-HD is released meanwhile
+ * too, and the time spent yielded left out of the frame's busy time.
+ * The instance stays marked as in process, so that control, delete,
+ * hibernate and the like wait for the frame to be done (codec_wait_idle()).
+ *
+ * Without dce_late_acquire, this only happens when a higher priority
+ * process call is waiting.
+ */
+Void dce_yield(IRES_YieldResourceType resource, IRES_YieldContextHandle ctxt,
+               IRES_YieldArgs args)
+{
+    Task_Handle     self;
+    Uint32          codec;
+    void           *cls;
+    Int             prio;
+    Dce_Rpc_Prof   *prof;
+    Ivahd_Frame    *frame;
+    uint32_t        t_yield;
+
+    if( BIOS_getThreadType() != BIOS_ThreadType_Task ) {
+        return;
+    }
+
+    /* only yield process calls, the others do not go through the gate */
+    self = Task_self();
+    if( self != process_task ) {
+        return;
+    }
+
+    codec = process_codec;
+    cls = process_cls;
+    prio = process_prio;
+    prof = process_prof;
+    frame = process_frame;
+
+    if( !dce_late_acquire && !dce_dispatch_preempt(prio)) {
+        return;
+    }
+
+    if( ctxt && ctxt->contextSave ) {
+        ctxt->contextSave(ctxt->algHandle, ctxt->contextArgs);
+    }
+
+    process_task = NULL;
+    process_yields++;
+    dce_timeline(DCE_TL_YIELD, codec, 0);
+#ifdef PSI_KPI
+    kpi_yield_codec((void *)codec);
+#endif /*PSI_KPI*/
+    ivahd_dvfs_yield(frame);
+    ivahd_release();
+    t_yield = Timestamp_get32();
+    dce_lock_post(sync_process_lock, sync_process_sem);
+    dce_dispatch_exit();
+
+    Task_yield();
+
+    dce_dispatch_enter(cls, prio);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    ivahd_acquire();
+    ivahd_dvfs_resume(frame);
+#ifdef PSI_KPI
+    kpi_resume_codec((void *)codec);
+#endif /*PSI_KPI*/
+    process_task = self;
+    process_codec = codec;
+    process_cls = cls;
+    process_prio = prio;
+    process_prof = prof;
+    process_frame = frame;
+    dce_timeline(DCE_TL_RESUME, codec, 0);
+    if( prof ) {
+        dce_rpc_add(prof, DCE_PHASE_LOCK, Timestamp_get32() - t_yield);
+    }
+
+    if( ctxt && ctxt->contextRestore ) {
+        ctxt->contextRestore(ctxt->algHandle, ctxt->contextArgs);
+    }
+}
+
 static int codec_process(UInt32 size, UInt32 *data)
 {
     MmType_Param   *payload = (MmType_Param *)data;
@@ -1024,44 +1916,131 @@ static int codec_process(UInt32 size, UInt32 *data)
     void           *inArgs   = (void *) payload[4].data;
     void           *outArgs  = (void *) payload[5].data;
     Int32           ret = 0;
-
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
-
-    DEBUG(">> codec_process codec=%p", codec);
+    UInt32          arrival = Clock_getTicks();
+    uint32_t        t_arrival = Timestamp_get32();
+    uint32_t        t_locked, t_proc;
+    void           *cls;
+    Int             prio;
+    uint32_t        cycles, width, height;
+    Dce_Rpc_Prof    prof;
+    Ivahd_Frame     frame;
+    IALG_Handle     alg;
+    Hdvicp_Runs     runs;
+    Uint32         *busy;
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_PROCESS, (void *)codec);
 
     if( num_params != 6 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
         return (-1);
     }
 
+    /* more urgent calls, then calls for the codec which just ran go first */
+    cls = codec_class(codec_id, (void *)codec);
+    prio = codec_prio(codec_id, (void *)codec);
+    dce_timeline(DCE_TL_QUEUE_ENTER, codec, prio);
+    dce_dispatch_enter(cls, prio);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_timeline(DCE_TL_QUEUE_EXIT, codec, 0);
+    t_locked = Timestamp_get32();
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
+
+    DEBUG(">> codec_process codec=%p", codec);
+
+    codec_wait_idle(codec);
+
+    if( dce_is_hibernated(codec_instance(codec_id, (void *)codec))) {
+        ERROR("codec %p is hibernated", codec);
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        dce_dispatch_exit();
+        return (XDM_EFAIL);
+    }
+
     dce_inv(inBufs);
     dce_inv(outBufs);
     dce_inv(inArgs);
     dce_inv(outArgs);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     DEBUG(">> codec=%p, inBufs=%p, outBufs=%p, inArgs=%p, outArgs=%p codec_id=%d LOCK sync_process_sem 0x%x",
         codec, inBufs, outBufs, inArgs, outArgs, codec_id, sync_process_sem);
 
+    ivahd_frame_arrival((void *)codec, arrival);
+
+    /* the decoder does its slice header parsing before it claims the IVA-HD */
+    if( dce_late_acquire && (codec_id == OMAP_DCE_VIDDEC3) &&
+       (((VIDDEC3_InArgs *)inArgs)->size == sizeof(IH264VDEC_InArgs))) {
+        ((IH264VDEC_InArgs *)inArgs)->lateAcquireArg = late_acquire_channel(codec);
+    }
+    busy = codec_busy(codec);
+    if( busy ) {
+        *busy = 1;
+    }
+    process_task = Task_self();
+    process_codec = codec;
+    process_cls = cls;
+    process_prio = prio;
+    process_prof = &prof;
+    process_frame = &frame;
+
 #ifdef PSI_KPI
-        kpi_before_codec();
+        kpi_IVA_wake_state(ivahd_is_awake());
+        kpi_before_codec((void *)codec);
 #endif /*PSI_KPI*/
+    ivahd_dvfs_begin((void *)codec, &frame);
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     ivahd_acquire();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
+    dce_timeline(DCE_TL_ACQUIRE, codec, 0);
+    alg = instance_alg(codec_instance(codec_id, (void *)codec));
+    hdvicp_runs_begin(alg);
+    t_proc = Timestamp_get32();
     // do a reloc()
     ret = codec_fxns[codec_id].process((void *)codec, inBufs, outBufs, inArgs, outArgs);
 
+    t_proc = Timestamp_get32() - t_proc;
+    if( !hdvicp_runs_end(alg, &runs)) {
+        dce_latency_runs((void *)codec, &runs);
+    }
+    process_task = NULL;
+    process_prof = NULL;
+    process_frame = NULL;
+    if( busy ) {
+        *busy = 0;
+    }
+    dce_timeline(DCE_TL_RELEASE, codec, ret);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
     ivahd_release();
+    dce_rpc_phase(&prof, DCE_PHASE_POWER);
+    cycles = ivahd_dvfs_end((void *)codec, &frame);
+    if( dce_admission ) {
+        frame_size(codec_id, inBufs, outArgs, &width, &height);
+        dce_adm_frame(get_admission(), (void *)codec, width, height, cycles);
+    }
+
+    dce_init_stage(DCE_STAGE_FIRST_FRAME);
 
 #ifdef PSI_KPI
-        kpi_after_codec();
+        kpi_after_codec((void *)codec);
 #endif /*PSI_KPI*/
     DEBUG("<< codec=%p ret=%d extendedError=%08x", codec, ret, ((VIDDEC3_OutArgs *)outArgs)->extendedError);
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     dce_clean(inBufs);
     dce_clean(outBufs);
     dce_clean(inArgs);
     dce_clean(outArgs);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+
+    dce_latency_record((void *)codec, t_proc, Timestamp_get32() - t_arrival,
+                       t_locked - t_arrival);
+    dce_rpc_end(&prof);
 
-    Semaphore_post(sync_process_sem);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+    dce_dispatch_exit();
 
     return ((Int32)ret);
 }
@@ -1078,20 +2057,24 @@ static int codec_delete(UInt32 size, UInt32 *data)
     Uint32          codec    = (Uint32) payload[1].data;
     Uint32          mm_serv_id = 0;
     Client*          c;
+    Dce_Rpc_Prof    prof;
 
-#ifdef MEMORYSTATS_DEBUG
-    Memory_Stats    stats;
-#endif
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_DELETE, (void *)codec);
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
 
     DEBUG(">> codec_delete on codec 0x%x", codec);
 
     if( num_params != 2 ) {
         ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
         return (-1);
     }
 
+    codec_wait_idle(codec);
+
     if ( codec_id == OMAP_DCE_VIDDEC3 ) {
         DEBUG("codec_delete for VIDDEC3 codec_handle 0x%x", codec);
         c = get_client_instance((Uint32) codec);
@@ -1101,6 +2084,8 @@ static int codec_delete(UInt32 size, UInt32 *data)
                 if (c->decode_callback[i].row_mode) {
                     c->decode_callback[i].row_mode = 0;
                     pthread_mutex_destroy(&(c->decode_callback[i].callback_mutex));
+                    dce_lock_unregister(c->decode_callback[i].lock);
+                    c->decode_callback[i].lock = NULL;
                     pthread_cond_destroy(&(c->decode_callback[i].synch_callback));
                 }
                 DEBUG("codec_delete client 0x%x c->decode_callback[%d].callback_mutex 0x%x", c, i, c->decode_callback[i].callback_mutex);
@@ -1115,6 +2100,8 @@ static int codec_delete(UInt32 size, UInt32 *data)
                 if (c->encode_callback[i].row_mode) {
                     c->encode_callback[i].row_mode = 0;
                     pthread_mutex_destroy(&(c->encode_callback[i].callback_mutex));
+                    dce_lock_unregister(c->encode_callback[i].lock);
+                    c->encode_callback[i].lock = NULL;
                     pthread_cond_destroy(&(c->encode_callback[i].synch_callback));
                 }
                 DEBUG("codec_delete client 0x%x c->encode_callback[%d].callback_mutex 0x%x", c, i, c->encode_callback[i].callback_mutex);
@@ -1122,28 +2109,212 @@ static int codec_delete(UInt32 size, UInt32 *data)
         }
     }
 
+    if( dce_is_hibernated(codec_instance(codec_id, (void *)codec))) {
+        dce_restore(codec_instance(codec_id, (void *)codec), NULL);
+    }
+
+    ivahd_stream_remove((void *)codec);
+    ivahd_dvfs_remove((void *)codec);
+    dce_adm_remove(&admission, (void *)codec);
+#ifdef PSI_KPI
+    if( kpi_control & KPI_END_SUMMARY ) {
+        dce_latency_print((void *)codec);
+        dce_lock_report();
+    }
+#endif /*PSI_KPI*/
+    dce_latency_remove((void *)codec);
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     codec_fxns[codec_id].delete((void *)codec);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
 
     mm_serv_id = MmServiceMgr_getId();
     DEBUG("codec_delete mm_serv_id 0x%x", mm_serv_id);
     dce_unregister_codec(codec_id, mm_serv_id, codec);
 
-#ifdef MEMORYSTATS_DEBUG
-    Memory_getStats(NULL, &stats);
-    INFO("Total: %d\tFree: %d\tLargest: %d", stats.totalSize,
-         stats.totalFreeSize, stats.largestFreeSize);
-#endif
+    trace_heaps();
 
     DEBUG("<< codec_delete");
 
-    Semaphore_post(sync_process_sem);
-
+    /* process calls on other server tasks look it up with the lock held */
 #ifdef PSI_KPI
         kpi_comp_deinit((void*)codec);
 #endif /*PSI_KPI*/
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
+    return (0);
+}
+
+/*
+  * codec hibernate: save the instance state into a host buffer and give its
+  * memory back.  With no buffer, returns the size the buffer needs to be.
+  */
+static int codec_hibernate(UInt32 size, UInt32 *data)
+{
+    MmType_Param   *payload = (MmType_Param *)data;
+    Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
+    Uint32          codec_id = (Uint32) payload[0].data;
+    Uint32          codec    = (Uint32) payload[1].data;
+    void           *buf      = (void *) payload[2].data;
+    Int32           ret;
+    Dce_Rpc_Prof    prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_HIBERNATE, (void *)codec);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
+
+    DEBUG(">> codec_hibernate on codec 0x%x buf %p", codec, buf);
+
+    if( num_params != 3 ) {
+        ERROR("invalid number of params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        return (-1);
+    }
+
+    codec_wait_idle(codec);
+
+    if( !buf ) {
+        ret = dce_hibernate_size(codec_instance(codec_id, (void *)codec));
+    } else {
+        /* the host wrote the size of buf in its header */
+        Cache_inv(P2H(buf), sizeof(MemHeader), Cache_Type_ALL, TRUE);
+        dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+        ivahd_acquire();
+        dce_rpc_phase(&prof, DCE_PHASE_POWER);
+        ret = dce_hibernate(codec_instance(codec_id, (void *)codec), buf, P2H(buf)->size);
+        dce_rpc_phase(&prof, DCE_PHASE_CODEC);
+        ivahd_release();
+        dce_rpc_phase(&prof, DCE_PHASE_POWER);
+        dce_clean(buf);
+        dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+    }
+
+    DEBUG("<< codec_hibernate ret=%d", ret);
+
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
+    return (ret);
+}
+
+/*
+  * codec resume: bring back a hibernated instance from the host buffer
+  */
+static int codec_resume(UInt32 size, UInt32 *data)
+{
+    MmType_Param   *payload = (MmType_Param *)data;
+    Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
+    Uint32          codec_id = (Uint32) payload[0].data;
+    Uint32          codec    = (Uint32) payload[1].data;
+    void           *buf      = (void *) payload[2].data;
+    Int32           ret;
+    Dce_Rpc_Prof    prof;
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_RESUME, (void *)codec);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
+
+    DEBUG(">> codec_resume on codec 0x%x buf %p", codec, buf);
+
+    if( num_params != 3 || !buf ) {
+        ERROR("invalid params sent");
+        dce_rpc_end(&prof);
+        dce_lock_post(sync_process_lock, sync_process_sem);
+        return (-1);
+    }
+
+    codec_wait_idle(codec);
+
+    Cache_inv(P2H(buf), sizeof(MemHeader), Cache_Type_ALL, TRUE);
+    dce_inv(buf);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+
+    ret = dce_restore(codec_instance(codec_id, (void *)codec), buf);
+    dce_rpc_phase(&prof, DCE_PHASE_CODEC);
+
+    DEBUG("<< codec_resume ret=%d", ret);
+
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
+    return (ret);
+}
+
+/*
+  * codec priority: how urgent the instance is when several want the
+  * IVA-HD, higher first.  0 is the default.
+  */
+static int codec_priority(UInt32 size, UInt32 *data)
+{
+    MmType_Param   *payload = (MmType_Param *)data;
+    Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
+    Uint32          codec_id = (Uint32) payload[0].data;
+    Uint32          codec    = (Uint32) payload[1].data;
+    Int32           prio     = (Int32) payload[2].data;
+    Dce_Rpc_Prof    prof;
+
+    if( num_params != 3 ) {
+        ERROR("invalid number of params sent");
+        return (-1);
+    }
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_PRIORITY, (void *)codec);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
+
+    DEBUG(">> codec_priority on codec 0x%x prio %d", codec, prio);
+
+    codec_wait_idle(codec);
+    hdvicp_prio_set(instance_alg(codec_instance(codec_id, (void *)codec)), prio);
+
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
     return (0);
 }
 
+/*
+  * codec latency: p50/p95/p99/max of the instance process calls, into a
+  * host dce_latency
+  */
+static int codec_latency(UInt32 size, UInt32 *data)
+{
+    MmType_Param   *payload = (MmType_Param *)data;
+    Uint32          num_params = MmRpc_NUM_PARAMETERS(size);
+    Uint32          codec    = (Uint32) payload[1].data;
+    dce_latency    *lat      = (dce_latency *) payload[2].data;
+    Int32           ret;
+    Dce_Rpc_Prof    prof;
+
+    if( num_params != 3 || !lat ) {
+        ERROR("invalid params sent");
+        return (-1);
+    }
+
+    dce_rpc_begin(&prof, DCE_RPC_CODEC_LATENCY, (void *)codec);
+
+    dce_lock_pend(sync_process_lock, sync_process_sem);
+    dce_rpc_phase(&prof, DCE_PHASE_LOCK);
+
+    DEBUG(">> codec_latency on codec 0x%x", codec);
+
+    ret = dce_latency_get((void *)codec, lat);
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
+    dce_clean(lat);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+
+    DEBUG("<< codec_latency ret=%d", ret);
+
+    dce_rpc_end(&prof);
+    dce_lock_post(sync_process_lock, sync_process_sem);
+
+    return (ret);
+}
+
 /*
  * get_DataFxn : Sync/transfer the input data information from MPU side to DCE Server.
  * DCE Server will pass the information through the IVA-HD callback function:
@@ -1156,6 +2327,7 @@ static int get_DataFxn(UInt32 size, UInt32 *data)
     XDM_DataSyncHandle          dataSyncHandle = (XDM_DataSyncHandle) payload[0].data;
     XDM_DataSyncDesc            *dataSyncDesc    = (void *) payload[1].data;
     Client* c;
+    Dce_Rpc_Prof prof;
 
     DEBUG(">> get_DataFxn dataSyncHandle 0x%x", dataSyncHandle);
 
@@ -1164,14 +2336,17 @@ static int get_DataFxn(UInt32 size, UInt32 *data)
         return (-1);
     }
 
+    dce_rpc_begin(&prof, DCE_STATS_RPC_GET_DATA, dataSyncHandle);
+
     dce_inv(dataSyncDesc);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     c = get_client_instance((Uint32) dataSyncHandle);
     if (c) {
         int i;
         for (i = 0; i < DIM(c->encode_codec); i++) {
             if (c->encode_codec[i] == dataSyncHandle) {
-                pthread_mutex_lock(&(c->encode_callback[i].callback_mutex));
+                dce_mutex_lock(c->encode_callback[i].lock, &(c->encode_callback[i].callback_mutex));
                 c->encode_callback[i].dataSyncHandle = dataSyncHandle;
                 c->encode_callback[i].dataSyncDesc = dataSyncDesc;
 
@@ -1185,16 +2360,21 @@ static int get_DataFxn(UInt32 size, UInt32 *data)
                     // consumed by the codec.
                     c->encode_callback[i].getdata_ready = 1;
                     DEBUG("Case#2 get_DataFxn is received but codec has not request H264E_GetDataFxn. Wait conditionally.");
-                    pthread_cond_wait(&(c->encode_callback[i].synch_callback), &(c->encode_callback[i].callback_mutex));
+                    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
+                    dce_cond_wait(c->encode_callback[i].lock, &(c->encode_callback[i].synch_callback), &(c->encode_callback[i].callback_mutex));
+                    dce_rpc_phase(&prof, DCE_PHASE_CALLBACK);
                     DEBUG("Case#2 get_DataFxn finally gets H264E_GetDataFxn, and the data has been consumed, continue.");
                     c->encode_callback[i].getdata_ready = 0;
                 }
-                pthread_mutex_unlock(&(c->encode_callback[i].callback_mutex));
+                dce_mutex_unlock(c->encode_callback[i].lock, &(c->encode_callback[i].callback_mutex));
             }
         }
     }
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     dce_clean(dataSyncDesc);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+    dce_rpc_end(&prof);
     return (0);
 }
 
@@ -1210,6 +2390,7 @@ static int put_DataFxn(UInt32 size, UInt32 *data)
     XDM_DataSyncHandle          dataSyncHandle = (XDM_DataSyncHandle) payload[0].data;
     XDM_DataSyncDesc            *dataSyncDesc    = (void *) payload[1].data;
     Client* c;
+    Dce_Rpc_Prof prof;
 
     DEBUG(">> put_DataFxn dataSyncHandle 0x%x dataSyncDesc 0x%x", dataSyncHandle, dataSyncDesc);
 
@@ -1218,14 +2399,17 @@ static int put_DataFxn(UInt32 size, UInt32 *data)
         return (-1);
     }
 
+    dce_rpc_begin(&prof, DCE_STATS_RPC_PUT_DATA, dataSyncHandle);
+
     dce_inv(dataSyncDesc);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
 
     c = get_client_instance((Uint32) dataSyncHandle);
     if (c) {
         int i;
         for (i = 0; i < DIM(c->decode_codec); i++) {
             if (c->decode_codec[i] == dataSyncHandle) {
-                pthread_mutex_lock(&(c->decode_callback[i].callback_mutex));
+                dce_mutex_lock(c->decode_callback[i].lock, &(c->decode_callback[i].callback_mutex));
                 // Found the corresponding entry, check if IVA-HD has already called the callback (codec_request == 1).
 
                 if ((c->decode_callback[i].codec_request) && ((c->decode_callback[i].putdata_toclient) == 0)) {
@@ -1241,9 +2425,10 @@ static int put_DataFxn(UInt32 size, UInt32 *data)
                     dataSyncDesc->blockSizes = (c->decode_callback[i].dataSyncDesc)->blockSizes;
 
                     (c->decode_callback[i].putdata_toclient)++;
-                    pthread_mutex_unlock(&(c->decode_callback[i].callback_mutex));
+                    dce_mutex_unlock(c->decode_callback[i].lock, &(c->decode_callback[i].callback_mutex));
 
                     dce_clean(dataSyncDesc);
+                    dce_rpc_end(&prof);
                     return (0);
                 } else if ((c->decode_callback[i].codec_request) && (c->decode_callback[i].putdata_toclient)) {
                     // Check if put_data_toclient are set; Otherwise send the data to MPU.
@@ -1258,7 +2443,9 @@ static int put_DataFxn(UInt32 size, UInt32 *data)
                 c->decode_callback[i].putdata_ready = 1;
                 DEBUG("Case#2 put_DataFxn is received. Wait for H264D_PutDataFxn to come; set putdata_ready = 1 c->decode_callback[%d].callback_mutex 0x%x", i, c->decode_callback[i].callback_mutex);
                 DEBUG("Case#2 c->decode_callback[i].dataSyncDesc 0x%x dataSyncDesc 0x%x", c->decode_callback[i].dataSyncDesc, dataSyncDesc);
-                pthread_cond_wait(&(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
+                dce_rpc_phase(&prof, DCE_PHASE_OTHER);
+                dce_cond_wait(c->decode_callback[i].lock, &(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
+                dce_rpc_phase(&prof, DCE_PHASE_CALLBACK);
 
                 DEBUG("put_DataFxn FINALLY gets H264D_PutDataFxn, and the data has been provided, continue.");
                 // Signal is received; check if it is from VIDDEC3_process or from H264D_PutDataFxn
@@ -1283,17 +2470,25 @@ static int put_DataFxn(UInt32 size, UInt32 *data)
                 DEBUG("From client dataSyncDesc->blockSizes %d ", dataSyncDesc->blockSizes);
 
                 (c->decode_callback[i].putdata_toclient)++;
-                pthread_mutex_unlock(&(c->decode_callback[i].callback_mutex));
+                dce_mutex_unlock(c->decode_callback[i].lock, &(c->decode_callback[i].callback_mutex));
             }
         }
     }
 
+    dce_rpc_phase(&prof, DCE_PHASE_OTHER);
     dce_clean(dataSyncDesc);
+    dce_rpc_phase(&prof, DCE_PHASE_CACHE);
+    dce_rpc_end(&prof);
     return (0);
 }
 
 static int get_BufferFxn(UInt32 size, UInt32 *data)
 {
+    Dce_Rpc_Prof    prof;
+
+    dce_rpc_begin(&prof, DCE_STATS_RPC_GET_BUFFER, NULL);
+    dce_rpc_end(&prof);
+
     return (0);
 }
 
@@ -1311,7 +2506,11 @@ static RcmServer_FxnDesc    DCEServerFxnAry[] =
     { "codec_get_version",    (RcmServer_MsgFxn) codec_get_version },
     { "codec_process",   (RcmServer_MsgFxn) codec_process },
     { "codec_delete",    (RcmServer_MsgFxn) codec_delete },
-    { "get_rproc_info", (RcmServer_MsgFxn) get_rproc_info }
+    { "get_rproc_info", (RcmServer_MsgFxn) get_rproc_info },
+    { "codec_hibernate", (RcmServer_MsgFxn) codec_hibernate },
+    { "codec_resume",    (RcmServer_MsgFxn) codec_resume },
+    { "codec_priority",  (RcmServer_MsgFxn) codec_priority },
+    { "codec_latency",   (RcmServer_MsgFxn) codec_latency }
 
 };
 
@@ -1381,6 +2580,34 @@ static MmType_FxnSig    DCEServer_sigAry[] =
       {
          { MmType_Dir_Out, MmType_Param_S32, 1 }, // return
           { MmType_Dir_In, MmType_Param_U32, 1 }
+      } },
+    { "codec_hibernate", 4,
+      {
+          { MmType_Dir_Out, MmType_Param_S32, 1 }, // return
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_Bi, MmType_PtrType(MmType_Param_VOID), 1 }
+      } },
+    { "codec_resume", 4,
+      {
+          { MmType_Dir_Out, MmType_Param_S32, 1 }, // return
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_PtrType(MmType_Param_VOID), 1 }
+      } },
+    { "codec_priority", 4,
+      {
+          { MmType_Dir_Out, MmType_Param_S32, 1 }, // return
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_Param_S32, 1 }
+      } },
+    { "codec_latency", 4,
+      {
+          { MmType_Dir_Out, MmType_Param_S32, 1 }, // return
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_In, MmType_Param_U32, 1 },
+          { MmType_Dir_Bi, MmType_PtrType(MmType_Param_VOID), 1 }
       } }
 
 };
@@ -1439,7 +2666,7 @@ Void dce_SrvDelNotification(Void)
     int i;
     uint32_t mm_serv_id = 0;
 
-    Semaphore_pend(sync_process_sem, BIOS_WAIT_FOREVER);
+    dce_lock_pend(sync_process_lock, sync_process_sem);
 
     DEBUG("dce_SrvDelNotification: cleanup existing codec and engine\n");
 
@@ -1468,20 +2695,33 @@ Void dce_SrvDelNotification(Void)
         }
 
         /* Make sure IVAHD and SL2 are idle before proceeding */
+        ivahd_idle_flush();
         ivahd_idle_check();
 
         /* delete all codecs first */
         for( i = 0; i < DIM(c->decode_codec); i++ ) {
             DEBUG("dce_SrvDelNotification: test c->decode_codec[%d] 0x%x", i, c->decode_codec[i]);
+            if( c->decode_codec[i] ) {
+                codec_wait_idle((Uint32)c->decode_codec[i]);
+            }
             if( c->decode_codec[i] ) {
                 DEBUG("dce_SrvDelNotification: delete decoder codec handle 0x%x c->decode_callback[i] 0x%x c->decode_callback[i].row_mode %d\n",
                     c->decode_codec[i], c->decode_callback[i], c->decode_callback[i].row_mode);
                 if (c->decode_callback[i].row_mode) {
                     pthread_mutex_destroy(&(c->decode_callback[i].callback_mutex));
+                    dce_lock_unregister(c->decode_callback[i].lock);
+                    c->decode_callback[i].lock = NULL;
                     pthread_cond_destroy(&(c->decode_callback[i].synch_callback));
                     c->decode_callback[i].row_mode = 0;
                     c->decode_callback[i].mpu_crash_indication = FALSE;
                 }
+                if( dce_is_hibernated(codec_instance(OMAP_DCE_VIDDEC3, c->decode_codec[i]))) {
+                    dce_restore(codec_instance(OMAP_DCE_VIDDEC3, c->decode_codec[i]), NULL);
+                }
+                ivahd_stream_remove(c->decode_codec[i]);
+                ivahd_dvfs_remove(c->decode_codec[i]);
+                dce_adm_remove(&admission, c->decode_codec[i]);
+                dce_latency_remove(c->decode_codec[i]);
                 codec_fxns[OMAP_DCE_VIDDEC3].delete((void *)c->decode_codec[i]);
                 c->decode_codec[i] = NULL;
             }
@@ -1489,15 +2729,27 @@ Void dce_SrvDelNotification(Void)
 
         for( i = 0; i < DIM(c->encode_codec); i++ ) {
             DEBUG("dce_SrvDelNotification: test c->encode_codec[%d] 0x%x", i, c->encode_codec[i]);
+            if( c->encode_codec[i] ) {
+                codec_wait_idle((Uint32)c->encode_codec[i]);
+            }
             if( c->encode_codec[i] ) {
                 DEBUG("dce_SrvDelNotification: delete encoder codec handle 0x%x c->encode_callback[i] 0x%x \n",
                     c->encode_codec[i], c->encode_callback[i]);
                 if (c->encode_callback[i].row_mode) {
                     pthread_mutex_destroy(&(c->encode_callback[i].callback_mutex));
+                    dce_lock_unregister(c->encode_callback[i].lock);
+                    c->encode_callback[i].lock = NULL;
                     pthread_cond_destroy(&(c->encode_callback[i].synch_callback));
                     c->encode_callback[i].row_mode = 0;
                     c->encode_callback[i].mpu_crash_indication = FALSE;
                 }
+                if( dce_is_hibernated(c->encode_codec[i])) {
+                    dce_restore(c->encode_codec[i], NULL);
+                }
+                ivahd_stream_remove(c->encode_codec[i]);
+                ivahd_dvfs_remove(c->encode_codec[i]);
+                dce_adm_remove(&admission, c->encode_codec[i]);
+                dce_latency_remove(c->encode_codec[i]);
                 codec_fxns[OMAP_DCE_VIDENC2].delete((void *)c->encode_codec[i]);
                 c->encode_codec[i] = NULL;
             }
@@ -1520,7 +2772,7 @@ Void dce_SrvDelNotification(Void)
     }
     DEBUG("dce_SrvDelNotification: COMPLETE exit function \n");
 
-    Semaphore_post(sync_process_sem);
+    dce_lock_post(sync_process_lock, sync_process_sem);
 }
 
 Void dceCallback_SrvDelNotification(Void)
@@ -1529,14 +2781,17 @@ Void dceCallback_SrvDelNotification(Void)
 }
 
 /*
- * dce_main : main function for dce-server thread.
- * Registering to MmServiceMgr.
+ * ivahd_init_main : main function for ivahd-init thread.
+ * Brings up CE, RMAN and IVA-HD right at boot, while the IPC is being
+ * set up and the servers register, rather than on the first client
+ * request.
  */
-static void dce_main(uint32_t arg0, uint32_t arg1)
+static void ivahd_init_main(uint32_t arg0, uint32_t arg1)
 {
-    int            err = 0;
     dce_connect    dce_connect_msg;
 
+    dce_init_stage(DCE_STAGE_IVAHD_START);
+
     /* Read the register for ID_CODE to figure out the correct configuration: */
     /* CONTROL_STD_FUSE_ID_CODE[31:0] ID_CODE STD_FUSE_IDCODE */
     /* physical address: 0x4A00 2204 Address offset: 0x204                       */
@@ -1550,6 +2805,21 @@ static void dce_main(uint32_t arg0, uint32_t arg1)
     dce_connect_msg.debug = dce_debug;
     connect(&dce_connect_msg);
 
+    ivahd_ready = TRUE;
+    Semaphore_post(ivahd_ready_sem);
+
+    INFO("IVA-HD ready %d us after IPUMM_Main",
+         dce_init_us[DCE_STAGE_IVAHD_BOOT] - dce_init_us[DCE_STAGE_MAIN]);
+}
+
+/*
+ * dce_main : main function for dce-server thread.
+ * Registering to MmServiceMgr.
+ */
+static void dce_main(uint32_t arg0, uint32_t arg1)
+{
+    int            err = 0;
+
     err = MmServiceMgr_init();  // MmServiceMgr_init() will always return MmServiceMgr_S_SUCCESS.
 
     // setup the RCM Server create params
@@ -1567,6 +2837,7 @@ static void dce_main(uint32_t arg0, uint32_t arg1)
         DEBUG("failed to start " SERVER_NAME " \n");
     } else {
         DEBUG(SERVER_NAME " running through MmServiceMgr");
+        dce_init_stage(DCE_STAGE_SERVER);
     }
 
     MmServiceMgr_exit();
@@ -1619,10 +2890,21 @@ Bool dce_init(void)
 {
     Task_Params    params;
     Task_Params    callback_params;
+    Task_Params    ivahd_params;
     Semaphore_Params semParams;
 
     INFO("Creating DCE server and DCE callback server thread...");
 
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    ivahd_ready_sem = Semaphore_create(0, &semParams, NULL);
+
+    /* Create IVA-HD bring-up task, first so it gets going first */
+    Task_Params_init(&ivahd_params);
+    ivahd_params.instance->name = "ivahd-init";
+    ivahd_params.priority = Thread_Priority_ABOVE_NORMAL;
+    Task_create(ivahd_init_main, &ivahd_params, NULL);
+
     /* Create DCE task. */
     Task_Params_init(&params);
     params.instance->name = "dce-server";
@@ -1635,9 +2917,13 @@ Bool dce_init(void)
     callback_params.priority = Thread_Priority_ABOVE_NORMAL;
     Task_create(dce_callback_main, &callback_params, NULL);
 
+    /* Keep the statistics page up to date */
+    dce_stats_init();
+
     Semaphore_Params_init(&semParams);
     semParams.mode = Semaphore_Mode_BINARY;
     sync_process_sem = Semaphore_create(1, &semParams, NULL);
+    sync_process_lock = dce_lock_register("sync_process_sem", NULL);
 
     return (TRUE);
 }
@@ -1650,9 +2936,21 @@ void dce_deinit(void)
 {
     DEBUG("dce_deinit");
 
+    dce_lock_unregister(sync_process_lock);
+    sync_process_lock = NULL;
     Semaphore_delete(&sync_process_sem);
 }
 
+/* Time a process call spent in a row mode callback of its codec, from
+ * t_start.  The callbacks are run by the codec, from the process call.
+ */
+static void process_callback(uint32_t t_start)
+{
+    if( process_prof && (Task_self() == process_task)) {
+        dce_rpc_add(process_prof, DCE_PHASE_CALLBACK, Timestamp_get32() - t_start);
+    }
+}
+
 /*
  * H264E_GetDataFxn
  * This is callback function provided for IVA-HD codec to callback for more input data.
@@ -1664,6 +2962,7 @@ XDM_DataSyncGetFxn H264E_GetDataFxn(XDM_DataSyncHandle dataSyncHandle,
     XDM_DataSyncDesc *dataSyncDesc)
 {
     Client* c;
+    uint32_t t_start = Timestamp_get32();
 
     dce_inv(dataSyncDesc);
 
@@ -1674,7 +2973,7 @@ XDM_DataSyncGetFxn H264E_GetDataFxn(XDM_DataSyncHandle dataSyncHandle,
         int i;
         for (i = 0; i < DIM(c->encode_codec); i++) {
             if (c->encode_codec[i] == dataSyncHandle) {
-                pthread_mutex_lock(&(c->encode_callback[i].callback_mutex));
+                dce_mutex_lock(c->encode_callback[i].lock, &(c->encode_callback[i].callback_mutex));
                 DEBUG("H264E_GetDataFxn dataSyncHandle 0x%x c->encode_callback[%d].callback_mutex 0x%x", dataSyncHandle, i, c->encode_callback[i].callback_mutex);
                 // Check if H264E_GetDataFxn from codec and get_DataFxn from MPU side. Which comes first.
                 // Check if MPU has crashed c->encode_callback[i].mpu_crash_indication, if it is then send the highest numBlock to codec so that VIDENC2_process will be returned and IVA back to IDLE.
@@ -1710,7 +3009,7 @@ XDM_DataSyncGetFxn H264E_GetDataFxn(XDM_DataSyncHandle dataSyncHandle,
 
                         DEBUG("H264E_GetDataFxn wait Case#1");
                         // Wait until get_DataFxn is received from MPU client side. Need the information to be passed to codec as currently not available.
-                        pthread_cond_wait(&(c->encode_callback[i].synch_callback), &(c->encode_callback[i].callback_mutex));
+                        dce_cond_wait(c->encode_callback[i].lock, &(c->encode_callback[i].synch_callback), &(c->encode_callback[i].callback_mutex));
 
                         // Once get_DataFxn is received from MPU side continue by providing it to IVA-HD codec.
                         DEBUG("H264E_GetDataFxn Case#1 c->encode_callback[%d].dataSyncHandle 0x%x c->encode_callback[%d].dataSyncDesc 0x%x",
@@ -1726,13 +3025,14 @@ XDM_DataSyncGetFxn H264E_GetDataFxn(XDM_DataSyncHandle dataSyncHandle,
                         c->encode_callback[i].codec_request = 0;
                     }
                 }
-                pthread_mutex_unlock(&(c->encode_callback[i].callback_mutex));
+                dce_mutex_unlock(c->encode_callback[i].lock, &(c->encode_callback[i].callback_mutex));
             }
         }
     }
 
     DEBUG("********************H264E_GetDataFxn END*************************** dataSyncHandle 0x%x", dataSyncHandle);
     dce_clean(dataSyncDesc);
+    process_callback(t_start);
     return (0);
 }
 
@@ -1749,6 +3049,7 @@ XDM_DataSyncPutFxn H264D_PutDataFxn(XDM_DataSyncHandle dataSyncHandle,
     XDM_DataSyncDesc *dataSyncDesc)
 {
     Client* c;
+    uint32_t t_start = Timestamp_get32();
 
     dce_inv(dataSyncDesc);
     DEBUG("********************H264D_PutDataFxn START*************************** dataSyncHandle 0x%x dataSyncDesc->numBlocks %d",
@@ -1759,7 +3060,7 @@ XDM_DataSyncPutFxn H264D_PutDataFxn(XDM_DataSyncHandle dataSyncHandle,
         int i;
         for (i = 0; i < DIM(c->decode_codec); i++) {
             if (c->decode_codec[i] == dataSyncHandle) {
-                pthread_mutex_lock(&(c->decode_callback[i].callback_mutex));
+                dce_mutex_lock(c->decode_callback[i].lock, &(c->decode_callback[i].callback_mutex));
                 DEBUG("H264D_PutDataFxn dataSyncHandle 0x%x c->decode_codec[%d].callback_mutex 0x%x", dataSyncHandle, i, c->decode_callback[i].callback_mutex);
                 c->decode_callback[i].codec_request = 1;
                 // Save the data from IVA-HD codec into local structure for put_DataFxn to pick up.
@@ -1793,19 +3094,20 @@ XDM_DataSyncPutFxn H264D_PutDataFxn(XDM_DataSyncHandle dataSyncHandle,
 
                         DEBUG("H264D_PutDataFxn Case#2 wait on pthread_cond_wait");
                         // After signal put_DataFxn, needs to wait for put_DataFxn return from A15 before returning to codec.
-                        pthread_cond_wait(&(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
+                        dce_cond_wait(c->decode_callback[i].lock, &(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
                     } else {
                         DEBUG("H264D_PutDataFxn Case#1 wait on pthread_cond_wait c->decode_codec[%d].callback_mutex 0x%x", i, c->decode_callback[i].callback_mutex);
-                        pthread_cond_wait(&(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
+                        dce_cond_wait(c->decode_callback[i].lock, &(c->decode_callback[i].synch_callback), &(c->decode_callback[i].callback_mutex));
                     }
                 }
                 c->decode_callback[i].codec_request = 0;
-                pthread_mutex_unlock(&(c->decode_callback[i].callback_mutex));
+                dce_mutex_unlock(c->decode_callback[i].lock, &(c->decode_callback[i].callback_mutex));
             }
         }
     }
 
     DEBUG("********************H264D_PutDataFxn END*************************** dataSyncHandle 0x%x", dataSyncHandle);
     dce_clean(dataSyncDesc);
+    process_callback(t_start);
     return (0);
 }
@@ -34,19 +34,149 @@
 #define __DCE_PRIV_H__
 #include <ti/utils/osal/trace.h>
 #include <ti/xdais/dm/xdm.h>
+#include <ti/xdais/ires.h>
 #include <ti/sdo/ce/video3/viddec3.h>
 #include <ti/sdo/ce/video2/videnc2.h>
 
 Bool dce_init(void);
 
+/* Firmware bring-up stages, timestamped in dce_init_us[] (us, from
+ * ivahd_now_us()) the first time they are reached.
+ */
+typedef enum {
+    DCE_STAGE_MAIN,             /* IPUMM_Main() entered */
+    DCE_STAGE_RPMSG,            /* RPMessage_init() done */
+    DCE_STAGE_IVAHD_START,      /* ivahd-init task started */
+    DCE_STAGE_IVAHD_RMAN,       /* CE and RMAN up */
+    DCE_STAGE_IVAHD_BOOT,       /* IVA-HD booted, codecs can be created */
+    DCE_STAGE_SERVER,           /* dce-server registered */
+    DCE_STAGE_FIRST_OPEN,       /* first engine_open */
+    DCE_STAGE_FIRST_FRAME,      /* first process call done */
+    DCE_STAGE_NUM
+} Dce_Stage;
+
+extern uint32_t    dce_init_us[DCE_STAGE_NUM];
+
+void dce_init_stage(Dce_Stage stage);
+UInt32 ivahd_now_us(void);
+int ivahd_poll_reg(const char *name, volatile unsigned int *reg,
+                   unsigned int mask, unsigned int val, Bool equal,
+                   UInt32 timeout_us);
+
 /* these acquire/release functions should be implemented by the platform.
  * These are called from dce.c before/after the process() call.
  */
 void ivahd_acquire(void);
 void ivahd_release(void);
 void ivahd_idle_check(void);
+void ivahd_idle_flush(void);
+Bool ivahd_is_awake(void);
+void ivahd_frame_arrival(void *codec, UInt32 ticks);
+void ivahd_stream_remove(void *codec);
+
+/* IVA-HD busy time of a frame, kept by the process call running it */
+typedef struct Ivahd_Frame {
+    UInt32    start;      /* us */
+    UInt32    paused;     /* us spent yielded, see dce_yield() */
+    UInt32    yielded;    /* when it last yielded */
+} Ivahd_Frame;
+
+void ivahd_dvfs_begin(void *codec, Ivahd_Frame *frame);
+void ivahd_dvfs_yield(Ivahd_Frame *frame);
+void ivahd_dvfs_resume(Ivahd_Frame *frame);
+uint32_t ivahd_dvfs_end(void *codec, Ivahd_Frame *frame);
+uint32_t ivahd_max_mhz(void);
+void ivahd_dvfs_remove(void *codec);
+
+/* IVA-HD clock domain residency, in Clock ticks, since boot */
+typedef struct Ivahd_Residency {
+    uint32_t    awake_ticks;    /* in SW_WAKEUP, idle hold included */
+    uint32_t    idle_ticks;     /* in HW_AUTO */
+    uint32_t    wakeups;        /* HW_AUTO -> SW_WAKEUP */
+    uint32_t    gates;          /* SW_WAKEUP -> HW_AUTO */
+    uint32_t    hold_hits;      /* acquires which found it still held awake */
+    uint32_t    predict_wakeups; /* woken ahead of an expected frame */
+    uint32_t    predict_hits;   /* ... and the frame came in time */
+    uint32_t    predict_misses; /* ... and it was gated again unused */
+} Ivahd_Residency;
+
+void ivahd_residency(Ivahd_Residency *res);
 void ivahd_init(uint32_t chipset_id);
-void ivahd_boot();
+int ivahd_boot(void);
+
+/* duration of the last IVA-HD boot and reset sequences, us */
+extern uint32_t    ivahd_boot_us;
+extern uint32_t    ivahd_reset_us;
+
+/* process call ordering, see dispatch.c */
+typedef struct Dce_Dispatch_Stats {
+    uint32_t    runs;       /* process calls through the gate */
+    uint32_t    switches;   /* calls for another codec than the previous */
+    uint32_t    saved;      /* calls run ahead of an older one to save a switch */
+    uint32_t    expired;    /* batching given up, oldest waited too long */
+    uint32_t    waiting;    /* calls waiting for the gate, right now */
+} Dce_Dispatch_Stats;
+
+extern uint32_t    dce_batch_window_ms;
+
+void dce_dispatch_enter(void *cls, Int prio);
+void dce_dispatch_exit(void);
+Bool dce_dispatch_preempt(Int prio);
+void dce_dispatch_stats(Dce_Dispatch_Stats *stats);
+
+/* latency histograms, see latency.c */
+struct dce_latency;
+
+void dce_latency_add(void *codec);
+void dce_latency_remove(void *codec);
+void dce_latency_record(void *codec, uint32_t proc, uint32_t rpc, uint32_t wait);
+void dce_latency_phases(void *codec, const uint32_t *phase);
+struct Hdvicp_Runs;
+void dce_latency_runs(void *codec, const struct Hdvicp_Runs *runs);
+Int dce_latency_get(void *codec, struct dce_latency *lat);
+void dce_latency_print(void *codec);
+struct Dce_Stats_Codec;
+Int dce_latency_totals(struct Dce_Stats_Codec *codecs, Int max);
+
+/* live statistics page, see dce_stats.h */
+extern uint32_t    dce_stats_period_ms;
+
+void dce_stats_init(void);
+/* wake the statistics task up if the host switched the updates on */
+void dce_stats_kick(void);
+
+/* instance hibernation, see hibernate.c */
+Bool dce_is_hibernated(void *codec);
+Int dce_hibernate_size(void *codec);
+Int dce_hibernate(void *codec, void *buf, uint32_t size);
+Int dce_restore(void *codec, const void *buf);
+
+/* implemented by the tiled memory IRESMAN of the platform */
+int tiledmemory_hibernate_size(IALG_Handle alg);
+int tiledmemory_hibernate(IALG_Handle alg, uint8_t *save);
+int tiledmemory_resume(IALG_Handle alg, const uint8_t *save);
+
+/* implemented by the HDVICP IRESMAN of the platform, priorities are per
+ * algorithm instance, higher is more urgent, 0 by default.
+ */
+void hdvicp_prio_set(IALG_Handle alg, Int prio);
+Int hdvicp_prio_get(IALG_Handle alg);
+void hdvicp_prio_remove(IALG_Handle alg);
+
+/* IVA-HD runs of a process call, in Timestamp counts */
+typedef struct Hdvicp_Runs {
+    uint32_t    pre;        /* host, before the first run */
+    uint32_t    iva;        /* host blocked waiting for the IVA-HD */
+    uint32_t    post;       /* host, after the last run */
+    uint32_t    runs;
+} Hdvicp_Runs;
+
+void hdvicp_runs_begin(IALG_Handle alg);
+Int hdvicp_runs_end(IALG_Handle alg, Hdvicp_Runs *runs);
+
+/* RMAN yield function, see dce.c */
+Void dce_yield(IRES_YieldResourceType resource, IRES_YieldContextHandle ctxt,
+               IRES_YieldArgs args);
 
 XDM_DataSyncGetFxn H264E_GetDataFxn(XDM_DataSyncHandle dataSyncHandle, XDM_DataSyncDesc *dataSyncDesc);
 XDM_DataSyncPutFxn H264D_PutDataFxn(XDM_DataSyncHandle dataSyncHandle, XDM_DataSyncDesc *dataSyncDesc);
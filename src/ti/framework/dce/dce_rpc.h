@@ -51,7 +51,12 @@ typedef enum dce_rpc_call {
     DCE_RPC_CODEC_CONTROL,
     DCE_RPC_CODEC_GET_VERSION,
     DCE_RPC_CODEC_PROCESS,
-    DCE_RPC_CODEC_DELETE
+    DCE_RPC_CODEC_DELETE,
+    DCE_RPC_GET_RPROC_INFO,
+    DCE_RPC_CODEC_HIBERNATE,
+    DCE_RPC_CODEC_RESUME,
+    DCE_RPC_CODEC_PRIORITY,
+    DCE_RPC_CODEC_LATENCY
 } dce_rpc_call;
 
 
@@ -75,5 +80,20 @@ typedef struct dce_engine_open {
     Engine_Error  error_code;                 /* error code (out) */
 } dce_engine_open;
 
+/* Latencies of a codec instance process calls, in us (codec_latency) */
+typedef struct dce_latency_stats {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t max;
+} dce_latency_stats;
+
+typedef struct dce_latency {
+    dce_latency_stats proc;                   /* in the codec process(), yields included */
+    dce_latency_stats rpc;                    /* arrival to reply */
+    dce_latency_stats wait;                   /* waiting for the process lock */
+} dce_latency;
+
 #endif /* __DCE_RPC_H__ */
 
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __DCE_STATS_H__
+#define __DCE_STATS_H__
+
+#include <stdint.h>
+
+/* Live statistics page.
+ *
+ * A page the firmware keeps up to date every dce_stats_period_ms, which
+ * the host can read at any time without an RPC.  The updates are off by
+ * default, the host patches the period in when it starts reading, and
+ * they start within a second (with the next RPC or load report).  It is
+ * a carveout of the resource table at DCE_STATS_DA, its PA and the one of
+ * the period are printed at boot.  This header is shared with the host
+ * reader (tools/dcestats), keep it in sync.
+ *
+ * Updates follow a sequence lock: seq is odd while the page is being
+ * written.  A reader copies the page, and keeps the copy only if seq was
+ * even and the same before and after the copy.  The firmware writes the
+ * page back from its cache before and after changing it, so the host has
+ * to map it uncached.
+ *
+ * All times are in us of the KPI timebase (see ti/utils/timebase.h) and
+ * all counters are cumulative, 32 bits wrapping: the host takes the
+ * difference between two samples, and divides by the difference of their
+ * time_us for a load.
+ *
+ * The contexts of cores[] are only filled while the instrumentation
+ * measures the CPU load (DCE_STATS_CPU_KPI set in flags).  A context's
+ * time is accounted when it gets switched out.
+ *
+ * rpcs[] splits the time of the RPCs served into phases, see rpcprof.h.
+ * It is indexed by dce_rpc_call (see dce_rpc.h), then the callback server
+ * calls from DCE_STATS_RPC_GET_DATA.  A call is accounted once replied.
+ */
+
+#define DCE_STATS_DA            0x9F100000
+#define DCE_STATS_SIZE          0x1000      /* one page, what the carveout is */
+
+#define DCE_STATS_MAGIC         0x54534344  /* "DCST" */
+#define DCE_STATS_VERSION       5
+
+#define DCE_STATS_CORES         2
+#define DCE_STATS_MAX_CTX       32          /* per core */
+#define DCE_STATS_MAX_CODECS    16
+#define DCE_STATS_HEAPS         2           /* DCE_HEAP_NUM */
+#define DCE_STATS_RPCS          16
+
+/* flags */
+#define DCE_STATS_CPU_KPI       (1 << 0)    /* cores[] contexts are valid */
+
+/* type of a context */
+#define DCE_STATS_TASK          0
+#define DCE_STATS_SWI           1
+#define DCE_STATS_HWI           2
+
+/* rpcs[] index of the callback server calls */
+#define DCE_STATS_RPC_GET_DATA      12
+#define DCE_STATS_RPC_PUT_DATA      13
+#define DCE_STATS_RPC_GET_BUFFER    14
+
+/* phase_us[] index */
+#define DCE_STATS_PHASE_LOCK        0   /* waiting for the process lock */
+#define DCE_STATS_PHASE_CACHE       1   /* cache maintenance of the buffers */
+#define DCE_STATS_PHASE_POWER       2   /* ivahd_acquire()/release() */
+#define DCE_STATS_PHASE_CODEC       3   /* in the codec */
+#define DCE_STATS_PHASE_CALLBACK    4   /* blocked on a row mode callback */
+#define DCE_STATS_PHASE_OTHER       5   /* the rest, DCE bookkeeping */
+#define DCE_STATS_PHASES            6
+
+typedef struct Dce_Stats_Ctx {
+    uint32_t    handle;
+    uint32_t    type;           /* DCE_STATS_TASK, _SWI or _HWI */
+    uint32_t    time_us;        /* spent running it */
+    uint32_t    switches;       /* times it got activated */
+    char        name[16];
+} Dce_Stats_Ctx;
+
+typedef struct Dce_Stats_Core {
+    uint32_t         nctx;
+    Dce_Stats_Ctx    ctx[DCE_STATS_MAX_CTX];
+} Dce_Stats_Core;
+
+/* A codec instance, from its process calls */
+typedef struct Dce_Stats_Codec {
+    uint32_t    handle;         /* as returned by codec_create */
+    uint32_t    calls;
+    uint32_t    proc_us;        /* in the codec process(), yields included */
+    uint32_t    wait_us;        /* waiting for the process lock */
+    uint32_t    rpc_us;         /* arrival to reply */
+    uint32_t    proc_max_us;    /* longest process() */
+    uint32_t    phase_us[DCE_STATS_PHASES]; /* of the process calls */
+    uint32_t    pre_iva_us;     /* in process(), before the 1st IVA-HD run */
+    uint32_t    hdvicp_us;      /* in process(), waiting for the IVA-HD */
+    uint32_t    post_iva_us;    /* in process(), after the last IVA-HD run */
+    uint32_t    hdvicp_runs;
+    uint32_t    iva_p50_us;     /* IVA-HD time of a frame, since the create */
+    uint32_t    iva_p99_us;
+    uint32_t    iva_max_us;
+} Dce_Stats_Codec;
+
+/* One RPC, over all the instances */
+typedef struct Dce_Stats_Rpc {
+    uint32_t    calls;
+    uint32_t    total_us;       /* arrival to reply */
+    uint32_t    max_us;
+    uint32_t    p50_us;
+    uint32_t    p99_us;
+    uint32_t    phase_us[DCE_STATS_PHASES];
+} Dce_Stats_Rpc;
+
+/* In bytes, see dce_heap.h */
+typedef struct Dce_Stats_Heap {
+    uint32_t    total;
+    uint32_t    used;
+    uint32_t    high_water;
+    uint32_t    alloc_count;
+    uint32_t    largest_free;
+    uint32_t    failures;
+} Dce_Stats_Heap;
+
+/* Process calls ordering, see dispatch.c */
+typedef struct Dce_Stats_Queue {
+    uint32_t    waiting;        /* queue depth, at the update */
+    uint32_t    runs;
+    uint32_t    switches;
+    uint32_t    saved;
+    uint32_t    expired;
+} Dce_Stats_Queue;
+
+typedef struct Dce_Stats_Page {
+    uint32_t           magic;
+    uint32_t           version;
+    uint32_t           size;        /* sizeof(Dce_Stats_Page) */
+    volatile uint32_t  seq;
+    uint32_t           time_us;     /* of the update */
+    uint32_t           updates;
+    uint32_t           flags;
+    uint32_t           cpu_load;    /* %, from the BIOS Load module */
+    Dce_Stats_Queue    queue;
+    uint32_t           nheaps;
+    Dce_Stats_Heap     heaps[DCE_STATS_HEAPS];
+    uint32_t           ncodecs;
+    Dce_Stats_Codec    codecs[DCE_STATS_MAX_CODECS];
+    uint32_t           nrpcs;
+    Dce_Stats_Rpc      rpcs[DCE_STATS_RPCS];
+    Dce_Stats_Core     cores[DCE_STATS_CORES];
+} Dce_Stats_Page;
+
+/* fails to build if the page outgrows its carveout */
+typedef char    Dce_Stats_Page_Fits[(sizeof(Dce_Stats_Page) <= DCE_STATS_SIZE) ? 1 : -1];
+
+#endif /* __DCE_STATS_H__ */
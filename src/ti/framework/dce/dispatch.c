@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Ordering of process calls by priority and codec.
+ *
+ * Every switch between codecs makes the IVA-HD reload a different ICONT
+ * firmware and codec context, so when several streams of different codecs
+ * are interleaved frame by frame, much of the IVA-HD time goes into these
+ * switches.
+ *
+ * Process calls go through this gate, one at a time.  When the gate is
+ * handed over, it goes to the highest priority waiters (see
+ * hdvicp_prio_set()).  Among those, a waiter of the codec which just ran
+ * is preferred over older waiters of other codecs, as long as the oldest
+ * has not been waiting for more than dce_batch_window_ms.  With the
+ * default of 0, equal priority waiters are served FIFO.
+ *
+ * The codec is identified by its IALG_Fxns, which is the same for all
+ * instances of a given codec.
+ */
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "dce_priv.h"
+
+/* Bound on the extra latency batching may add to a process call, in ms.
+ * 0 disables batching.
+ */
+uint32_t    dce_batch_window_ms = 0;
+
+typedef struct Dispatch_Waiter {
+    void                      *cls;
+    Int                        prio;
+    UInt32                     arrival;     /* in Clock ticks */
+    Semaphore_Struct           sem;
+    struct Dispatch_Waiter    *next;
+} Dispatch_Waiter;
+
+static Dispatch_Waiter    *waiters = NULL;  /* oldest first */
+static Bool                busy = FALSE;
+static void               *last_cls = NULL;
+static Dce_Dispatch_Stats  stats;
+
+/* Called with the Task scheduler disabled */
+static void dispatch_run(void *cls)
+{
+    stats.runs++;
+    if( last_cls && (cls != last_cls)) {
+        stats.switches++;
+    }
+    last_cls = cls;
+}
+
+/* Called with the Task scheduler disabled */
+static Dispatch_Waiter *dispatch_pick(void)
+{
+    Dispatch_Waiter    *oldest = waiters;
+    Dispatch_Waiter    *w;
+    UInt32              window;
+
+    /* oldest of the highest priority */
+    for( w = waiters; w; w = w->next ) {
+        if( w->prio > oldest->prio ) {
+            oldest = w;
+        }
+    }
+
+    if( !oldest || !dce_batch_window_ms || (oldest->cls == last_cls)) {
+        return (oldest);
+    }
+
+    window = (dce_batch_window_ms * 1000 + (Clock_tickPeriod - 1)) / Clock_tickPeriod;
+    if( Clock_getTicks() - oldest->arrival >= window ) {
+        stats.expired++;
+        return (oldest);
+    }
+
+    for( w = oldest->next; w; w = w->next ) {
+        if((w->prio == oldest->prio) && (w->cls == last_cls)) {
+            stats.saved++;
+            return (w);
+        }
+    }
+
+    return (oldest);
+}
+
+void dce_dispatch_enter(void *cls, Int prio)
+{
+    Dispatch_Waiter     w;
+    Dispatch_Waiter   **p;
+    UInt                key;
+
+    key = Task_disable();
+
+    if( !busy ) {
+        busy = TRUE;
+        dispatch_run(cls);
+        Task_restore(key);
+        return;
+    }
+
+    w.cls = cls;
+    w.prio = prio;
+    w.arrival = Clock_getTicks();
+    w.next = NULL;
+    Semaphore_construct(&w.sem, 0, NULL);
+
+    for( p = &waiters; *p; p = &(*p)->next ) {
+        ;
+    }
+    *p = &w;
+    stats.waiting++;
+
+    Task_restore(key);
+
+    /* dce_dispatch_exit() takes us off the list before posting */
+    Semaphore_pend(Semaphore_handle(&w.sem), BIOS_WAIT_FOREVER);
+    Semaphore_destruct(&w.sem);
+}
+
+void dce_dispatch_exit(void)
+{
+    Dispatch_Waiter     *w;
+    Dispatch_Waiter    **p;
+    UInt                 key;
+
+    key = Task_disable();
+
+    w = dispatch_pick();
+    if( !w ) {
+        busy = FALSE;
+        Task_restore(key);
+        return;
+    }
+
+    if((w != waiters) && (w->prio == waiters->prio)) {
+        DEBUG("batched %p ahead of %p", w->cls, waiters->cls);
+    }
+
+    for( p = &waiters; *p != w; p = &(*p)->next ) {
+        ;
+    }
+    *p = w->next;
+    stats.waiting--;
+
+    dispatch_run(w->cls);
+    Semaphore_post(Semaphore_handle(&w->sem));
+
+    Task_restore(key);
+}
+
+/* Whether a process call of priority prio should give way */
+Bool dce_dispatch_preempt(Int prio)
+{
+    Dispatch_Waiter    *w;
+    Bool                ret = FALSE;
+    UInt                key = Task_disable();
+
+    for( w = waiters; w; w = w->next ) {
+        if( w->prio > prio ) {
+            ret = TRUE;
+            break;
+        }
+    }
+    Task_restore(key);
+
+    return (ret);
+}
+
+void dce_dispatch_stats(Dce_Dispatch_Stats *out)
+{
+    UInt    key = Task_disable();
+
+    *out = stats;
+    Task_restore(key);
+}
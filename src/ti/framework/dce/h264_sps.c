@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Minimal H.264 sequence parameter set parser (ITU-T H.264 7.3.2.1 and
+ * E.1.1), only going as far as what is needed to size a decoder.
+ */
+
+#include <string.h>
+
+#include "h264_sps.h"
+
+#define NAL_TYPE_SPS      7
+#define SPS_MAX_RBSP      512
+#define SPS_MAX_MBS       512     /* per row or column, 8192 pixels */
+
+typedef struct bits {
+    const uint8_t   *buf;
+    uint32_t         len;   /* in bits */
+    uint32_t         pos;   /* in bits */
+    int              err;
+} bits;
+
+static uint32_t get_bit(bits *b)
+{
+    uint32_t    v;
+
+    if( b->pos >= b->len ) {
+        b->err = 1;
+        return (0);
+    }
+    v = (b->buf[b->pos >> 3] >> (7 - (b->pos & 7))) & 1;
+    b->pos++;
+    return (v);
+}
+
+static uint32_t get_bits(bits *b, int n)
+{
+    uint32_t    v = 0;
+
+    while( n-- ) {
+        v = (v << 1) | get_bit(b);
+    }
+    return (v);
+}
+
+/* ue(v) */
+static uint32_t get_ue(bits *b)
+{
+    int    zeros = 0;
+
+    while( !get_bit(b)) {
+        if( b->err || ++zeros > 31 ) {
+            b->err = 1;
+            return (0);
+        }
+    }
+    return ((1u << zeros) - 1 + get_bits(b, zeros));
+}
+
+/* se(v), only ever skipped here */
+static void skip_se(bits *b)
+{
+    (void)get_ue(b);
+}
+
+static void skip_scaling_list(bits *b, int size)
+{
+    int    i, last = 8, next = 8;
+
+    for( i = 0; i < size && !b->err; i++ ) {
+        if( next ) {
+            int    delta;
+            uint32_t    k = get_ue(b);
+
+            /* se(v) mapping: k odd -> positive */
+            delta = (k & 1) ? (int)((k + 1) >> 1) : -(int)(k >> 1);
+            next = (last + delta + 256) % 256;
+        }
+        last = next ? next : last;
+    }
+}
+
+static void skip_hrd(bits *b)
+{
+    uint32_t    i, cpb_cnt;
+
+    cpb_cnt = get_ue(b) + 1;
+    get_bits(b, 4);     /* bit_rate_scale */
+    get_bits(b, 4);     /* cpb_size_scale */
+    for( i = 0; i < cpb_cnt && !b->err; i++ ) {
+        get_ue(b);      /* bit_rate_value_minus1 */
+        get_ue(b);      /* cpb_size_value_minus1 */
+        get_bit(b);     /* cbr_flag */
+    }
+    get_bits(b, 5);     /* initial_cpb_removal_delay_length_minus1 */
+    get_bits(b, 5);     /* cpb_removal_delay_length_minus1 */
+    get_bits(b, 5);     /* dpb_output_delay_length_minus1 */
+    get_bits(b, 5);     /* time_offset_length */
+}
+
+/* Parses the VUI up to bitstream_restriction, returns max_dec_frame_buffering
+ * or -1 if the stream does not say.
+ */
+static int parse_vui(bits *b)
+{
+    uint32_t    nal_hrd, vcl_hrd;
+
+    if( get_bit(b)) {                   /* aspect_ratio_info_present_flag */
+        if( get_bits(b, 8) == 255 ) {   /* Extended_SAR */
+            get_bits(b, 16);
+            get_bits(b, 16);
+        }
+    }
+    if( get_bit(b)) {                   /* overscan_info_present_flag */
+        get_bit(b);
+    }
+    if( get_bit(b)) {                   /* video_signal_type_present_flag */
+        get_bits(b, 4);
+        if( get_bit(b)) {               /* colour_description_present_flag */
+            get_bits(b, 24);
+        }
+    }
+    if( get_bit(b)) {                   /* chroma_loc_info_present_flag */
+        get_ue(b);
+        get_ue(b);
+    }
+    if( get_bit(b)) {                   /* timing_info_present_flag */
+        get_bits(b, 32);
+        get_bits(b, 32);
+        get_bit(b);
+    }
+    nal_hrd = get_bit(b);
+    if( nal_hrd ) {
+        skip_hrd(b);
+    }
+    vcl_hrd = get_bit(b);
+    if( vcl_hrd ) {
+        skip_hrd(b);
+    }
+    if( nal_hrd || vcl_hrd ) {
+        get_bit(b);                     /* low_delay_hrd_flag */
+    }
+    get_bit(b);                         /* pic_struct_present_flag */
+    if( !get_bit(b) || b->err ) {       /* bitstream_restriction_flag */
+        return (-1);
+    }
+    get_bit(b);     /* motion_vectors_over_pic_boundaries_flag */
+    get_ue(b);      /* max_bytes_per_pic_denom */
+    get_ue(b);      /* max_bits_per_mb_denom */
+    get_ue(b);      /* log2_max_mv_length_horizontal */
+    get_ue(b);      /* log2_max_mv_length_vertical */
+    get_ue(b);      /* max_num_reorder_frames */
+
+    return (b->err ? -1 : (int)get_ue(b));
+}
+
+/* MaxDpbMbs from table A-1 */
+static uint32_t max_dpb_mbs(uint32_t level_idc)
+{
+    switch( level_idc ) {
+        case 9 :
+        case 10 :
+            return (396);
+        case 11 :
+            return (900);
+        case 12 :
+        case 13 :
+        case 20 :
+            return (2376);
+        case 21 :
+            return (4752);
+        case 22 :
+        case 30 :
+            return (8100);
+        case 31 :
+            return (18000);
+        case 32 :
+            return (20480);
+        case 40 :
+        case 41 :
+            return (32768);
+        case 42 :
+            return (34816);
+        case 50 :
+            return (110400);
+        default :
+            return (184320);
+    }
+}
+
+static int parse_sps(const uint8_t *rbsp, uint32_t len, h264_sps_info *info)
+{
+    bits        b = { rbsp, len * 8, 0, 0 };
+    uint32_t    i, poc_type, frame_mbs_only, mbs_w, map_units_h, cs3;
+    uint32_t    chroma_format_idc = 1;
+    int         max_dec_frame_buffering = -1;
+
+    info->profile_idc = get_bits(&b, 8);
+    cs3 = (get_bits(&b, 8) >> 4) & 1;   /* constraint_set3_flag */
+    info->level_idc = get_bits(&b, 8);
+    get_ue(&b);                         /* seq_parameter_set_id */
+
+    if( info->level_idc == 11 && cs3 &&
+        (info->profile_idc == 66 || info->profile_idc == 77)) {
+        info->level_idc = 9;            /* level 1b */
+    }
+
+    switch( info->profile_idc ) {
+        case 100 : case 110 : case 122 : case 244 : case 44 :
+        case 83 : case 86 : case 118 : case 128 : case 138 :
+        case 139 : case 134 : case 135 :
+            chroma_format_idc = get_ue(&b);
+            if( chroma_format_idc == 3 ) {
+                get_bit(&b);            /* separate_colour_plane_flag */
+            }
+            get_ue(&b);                 /* bit_depth_luma_minus8 */
+            get_ue(&b);                 /* bit_depth_chroma_minus8 */
+            get_bit(&b);                /* qpprime_y_zero_transform_bypass */
+            if( get_bit(&b)) {          /* seq_scaling_matrix_present_flag */
+                for( i = 0; i < ((chroma_format_idc != 3) ? 8 : 12); i++ ) {
+                    if( get_bit(&b)) {
+                        skip_scaling_list(&b, (i < 6) ? 16 : 64);
+                    }
+                }
+            }
+            break;
+        default :
+            break;
+    }
+
+    get_ue(&b);                         /* log2_max_frame_num_minus4 */
+    poc_type = get_ue(&b);
+    if( poc_type == 0 ) {
+        get_ue(&b);                     /* log2_max_pic_order_cnt_lsb_minus4 */
+    } else if( poc_type == 1 ) {
+        uint32_t    n;
+
+        get_bit(&b);                    /* delta_pic_order_always_zero_flag */
+        skip_se(&b);                    /* offset_for_non_ref_pic */
+        skip_se(&b);                    /* offset_for_top_to_bottom_field */
+        n = get_ue(&b);
+        for( i = 0; i < n && !b.err; i++ ) {
+            skip_se(&b);
+        }
+    }
+
+    info->max_num_ref_frames = get_ue(&b);
+    get_bit(&b);                        /* gaps_in_frame_num_allowed */
+    mbs_w = get_ue(&b);                 /* pic_width_in_mbs_minus1 */
+    map_units_h = get_ue(&b);           /* pic_height_in_map_units_minus1 */
+    if((mbs_w >= SPS_MAX_MBS) || (map_units_h >= SPS_MAX_MBS)) {
+        return (-1);
+    }
+    mbs_w++;
+    map_units_h++;
+    frame_mbs_only = get_bit(&b);
+    if( !frame_mbs_only ) {
+        get_bit(&b);                    /* mb_adaptive_frame_field_flag */
+    }
+    get_bit(&b);                        /* direct_8x8_inference_flag */
+    if( get_bit(&b)) {                  /* frame_cropping_flag */
+        get_ue(&b);
+        get_ue(&b);
+        get_ue(&b);
+        get_ue(&b);
+    }
+    if( b.err ) {
+        return (-1);
+    }
+
+    info->width = mbs_w * 16;
+    info->height = map_units_h * (2 - frame_mbs_only) * 16;
+
+    if( get_bit(&b)) {                  /* vui_parameters_present_flag */
+        max_dec_frame_buffering = parse_vui(&b);
+    }
+
+    if( max_dec_frame_buffering >= 0 ) {
+        info->dpb_frames = max_dec_frame_buffering;
+    } else {
+        /* not signalled, so it is inferred to be MaxDpbFrames (A.3.1) */
+        info->dpb_frames = max_dpb_mbs(info->level_idc) /
+                           (mbs_w * map_units_h * (2 - frame_mbs_only));
+    }
+
+    if( info->dpb_frames < info->max_num_ref_frames ) {
+        info->dpb_frames = info->max_num_ref_frames;
+    }
+    if( info->dpb_frames < 1 ) {
+        info->dpb_frames = 1;
+    }
+    if( info->dpb_frames > 16 ) {
+        info->dpb_frames = 16;
+    }
+
+    return (0);
+}
+
+int h264_find_sps(const uint8_t *buf, uint32_t len, h264_sps_info *info)
+{
+    uint8_t     rbsp[SPS_MAX_RBSP];
+    uint32_t    i, n, zeros;
+    uint8_t     type;
+
+    for( i = 0; i + 3 < len; i++ ) {
+        if( buf[i] || buf[i + 1] || buf[i + 2] != 1 ) {
+            continue;
+        }
+
+        i += 3;
+        type = buf[i] & 0x1f;
+
+        /* a slice means the headers of this access unit are over */
+        if( type >= 1 && type <= 5 ) {
+            return (-1);
+        }
+        if( type != NAL_TYPE_SPS ) {
+            continue;
+        }
+
+        /* strip emulation prevention bytes up to the next start code */
+        for( i++, n = 0, zeros = 0; i < len && n < SPS_MAX_RBSP; i++ ) {
+            if( zeros >= 2 && buf[i] == 3 ) {
+                zeros = 0;
+                continue;
+            }
+            if( zeros >= 2 && buf[i] <= 1 ) {
+                break;
+            }
+            zeros = buf[i] ? 0 : zeros + 1;
+            rbsp[n++] = buf[i];
+        }
+
+        memset(info, 0, sizeof(*info));
+        return (parse_sps(rbsp, n, info));
+    }
+
+    return (-1);
+}
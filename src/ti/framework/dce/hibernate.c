@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Codec instance hibernation.
+ *
+ * An idle instance gives its memory back while keeping its state, which
+ * is saved into a buffer provided by the host:
+ *
+ *  - the pages behind its TILER buffers (see tiledmemory_hibernate()),
+ *    which is where the bulk of the IVA-HD codecs persistent memory is,
+ *  - its persistent memTabs, but only when the algorithm implements
+ *    algMoved(), as there is no way to get the same heap blocks back.
+ *    Otherwise they stay resident.
+ *
+ * The instance object (memTab[0]) and the IVA-HD handles are small and
+ * are kept, so the codec handle is still valid while hibernated, only
+ * process/control calls are refused until it is resumed.
+ *
+ * Layout of the host buffer:
+ *   Hibernate_Hdr
+ *   uint32_t size of memTab[i], then its content, for each released memTab
+ *   TILER backing, as laid out by tiledmemory_hibernate()
+ */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/Memory.h>
+#include <xdc/runtime/Error.h>
+#include <ti/sysbios/hal/Cache.h>
+#include <ti/sdo/ce/visa.h>
+#include <ti/sdo/fc/dskt2/dskt2.h>
+#include <ti/xdais/ialg.h>
+
+#include <platform/ti/dce/baselib/dce_heap.h>
+
+#include "dce_priv.h"
+
+#define HIBERNATE_MAGIC    0x48424e54  /* "HBNT" */
+
+typedef struct Hibernate_Hdr {
+    uint32_t    magic;
+    uint32_t    size;       /* bytes used, header included */
+    uint32_t    nrecs;      /* memTabs released */
+    uint32_t    tiled;      /* bytes of TILER backing */
+} Hibernate_Hdr;
+
+typedef struct Hibernated {
+    void                 *codec;
+    IALG_Handle           alg;
+    Int                   nalloc;
+    Int                   nrecs;
+    IALG_MemRec          *memTab;
+    uint8_t              *released; /* per memTab, given back to the heap */
+    Bool                  moved;    /* some memTabs were released */
+    struct Hibernated    *next;
+} Hibernated;
+
+static Hibernated    *hibernated = NULL;
+
+static IALG_Handle get_alg(void *codec)
+{
+    IALG_Fxns      *fxns = NULL;
+    IALG_Handle     alg = NULL;
+
+    VISA_getAlgFxns((VISA_Handle)codec, &fxns, &alg);
+
+    return (alg);
+}
+
+static Hibernated *find(void *codec)
+{
+    Hibernated    *h;
+
+    for( h = hibernated; h; h = h->next ) {
+        if( h->codec == codec ) {
+            return (h);
+        }
+    }
+
+    return (NULL);
+}
+
+/* Persistent memTabs which can be given back while hibernated */
+static Bool releasable(IALG_Handle alg, IALG_MemRec *rec, Int i)
+{
+    return ((i > 0) && alg->fxns->algMoved && (rec->attrs == IALG_PERSIST) &&
+            rec->base && rec->size);
+}
+
+/* memTabs come from DSKT2, which picks the heap from the memory space */
+static IHeap_Handle memtab_heap(const IALG_MemRec *rec)
+{
+    return (dce_heap_handle(dce_heap_space(rec->space)));
+}
+
+/* memTab[] of alg as reported by algFree(), nalloc entries are allocated */
+static IALG_MemRec *get_memtab(IALG_Handle alg, Int *nalloc, Int *nrecs)
+{
+    IALG_MemRec    *memTab;
+
+    *nalloc = alg->fxns->algNumAlloc ? alg->fxns->algNumAlloc() : IALG_DEFMEMRECS;
+
+    memTab = Memory_calloc(NULL, *nalloc * sizeof(IALG_MemRec), 0, NULL);
+    if( !memTab ) {
+        return (NULL);
+    }
+
+    *nrecs = alg->fxns->algFree(alg, memTab);
+
+    return (memTab);
+}
+
+static void free_hibernated(Hibernated *h)
+{
+    if( h->memTab ) {
+        Memory_free(NULL, h->memTab, h->nalloc * sizeof(IALG_MemRec));
+    }
+    if( h->released ) {
+        Memory_free(NULL, h->released, h->nalloc);
+    }
+    Memory_free(NULL, h, sizeof(Hibernated));
+}
+
+Bool dce_is_hibernated(void *codec)
+{
+    return (find(codec) != NULL);
+}
+
+/* Size of the host buffer needed to hibernate codec, or -1 */
+Int dce_hibernate_size(void *codec)
+{
+    IALG_Handle     alg = get_alg(codec);
+    IALG_MemRec    *memTab;
+    Int             i, nalloc, nrecs, size = sizeof(Hibernate_Hdr);
+
+    if( !alg ) {
+        return (-1);
+    }
+
+    memTab = get_memtab(alg, &nalloc, &nrecs);
+    if( !memTab ) {
+        return (-1);
+    }
+
+    for( i = 0; i < nrecs; i++ ) {
+        if( releasable(alg, &memTab[i], i)) {
+            size += sizeof(uint32_t) + memTab[i].size;
+        }
+    }
+
+    Memory_free(NULL, memTab, nalloc * sizeof(IALG_MemRec));
+
+    return (size + tiledmemory_hibernate_size(alg));
+}
+
+/* Save codec's state into buf (of size bytes) and release its memory.
+ * Returns the number of bytes used in buf, or -1.
+ */
+Int dce_hibernate(void *codec, void *buf, uint32_t size)
+{
+    Hibernate_Hdr    *hdr = buf;
+    uint8_t          *p = (uint8_t *)&hdr[1];
+    Hibernated       *h;
+    IALG_Handle       alg = get_alg(codec);
+    Int               i, needed, tiled;
+
+    if( !alg || find(codec)) {
+        ERROR("codec %p can not be hibernated", codec);
+        return (-1);
+    }
+
+    needed = dce_hibernate_size(codec);
+    if((needed < 0) || (size < (uint32_t)needed)) {
+        ERROR("hibernation buffer too small: %d < %d", size, needed);
+        return (-1);
+    }
+
+    h = Memory_calloc(NULL, sizeof(Hibernated), 0, NULL);
+    if( !h ) {
+        return (-1);
+    }
+
+    h->memTab = get_memtab(alg, &h->nalloc, &h->nrecs);
+    if( h->memTab ) {
+        h->released = Memory_calloc(NULL, h->nalloc, 0, NULL);
+    }
+    if( !h->released ) {
+        free_hibernated(h);
+        return (-1);
+    }
+
+    /* get the state out of scratch memory and the IVA */
+    DSKT2_deactivateAll();
+
+    hdr->magic = HIBERNATE_MAGIC;
+    hdr->nrecs = 0;
+
+    for( i = 0; i < h->nrecs; i++ ) {
+        if( !releasable(alg, &h->memTab[i], i)) {
+            continue;
+        }
+
+        *(uint32_t *)p = h->memTab[i].size;
+        p += sizeof(uint32_t);
+
+        Cache_wbInv(h->memTab[i].base, h->memTab[i].size, Cache_Type_ALL, TRUE);
+        memcpy(p, h->memTab[i].base, h->memTab[i].size);
+        p += h->memTab[i].size;
+
+        Memory_free(memtab_heap(&h->memTab[i]), h->memTab[i].base,
+                    h->memTab[i].size);
+        h->memTab[i].base = NULL;
+        h->released[i] = TRUE;
+        h->moved = TRUE;
+        hdr->nrecs++;
+    }
+
+    tiled = tiledmemory_hibernate(alg, p);
+    hdr->tiled = tiled;
+    hdr->size = (p - (uint8_t *)buf) + tiled;
+
+    h->codec = codec;
+    h->alg = alg;
+    h->next = hibernated;
+    hibernated = h;
+
+    INFO("hibernated codec %p: %d memTabs, %d bytes total", codec,
+         hdr->nrecs, hdr->size);
+
+    return (hdr->size);
+}
+
+/* Bring back a hibernated codec from buf.  buf may be NULL when the state
+ * is not wanted anymore (codec about to be deleted), in which case only
+ * the memory is brought back.
+ */
+Int dce_restore(void *codec, const void *buf)
+{
+    const Hibernate_Hdr    *hdr = buf;
+    const uint8_t          *p = NULL;
+    Hibernated             *h = find(codec);
+    Hibernated            **prev;
+    Error_Block             eb;
+    Int                     i;
+
+    if( !h ) {
+        ERROR("codec %p is not hibernated", codec);
+        return (-1);
+    }
+
+    if( hdr ) {
+        if( hdr->magic != HIBERNATE_MAGIC ) {
+            ERROR("bad hibernation buffer for codec %p", codec);
+            return (-1);
+        }
+        p = (const uint8_t *)&hdr[1];
+    }
+
+    for( i = 0; i < h->nrecs; i++ ) {
+        if( !h->released[i] || h->memTab[i].base ) {
+            continue;
+        }
+
+        Error_init(&eb);
+        h->memTab[i].base = Memory_alloc(memtab_heap(&h->memTab[i]),
+                                         h->memTab[i].size,
+                                         h->memTab[i].alignment, &eb);
+        if( !h->memTab[i].base ) {
+            ERROR("could not allocate memTab[%d] (%d bytes)", i, h->memTab[i].size);
+            goto fail;
+        }
+
+        if( p ) {
+            p += sizeof(uint32_t);
+            memcpy(h->memTab[i].base, p, h->memTab[i].size);
+            Cache_wbInv(h->memTab[i].base, h->memTab[i].size, Cache_Type_ALL, TRUE);
+            p += h->memTab[i].size;
+        }
+    }
+
+    if( h->moved ) {
+        h->alg->fxns->algMoved(h->alg, h->memTab, NULL, NULL);
+    }
+
+    if( p && (tiledmemory_resume(h->alg, p) < 0)) {
+        goto fail;
+    }
+
+    for( prev = &hibernated; *prev; prev = &(*prev)->next ) {
+        if( *prev == h ) {
+            *prev = h->next;
+            break;
+        }
+    }
+
+    INFO("resumed codec %p", codec);
+
+    free_hibernated(h);
+
+    return (0);
+
+fail:
+    /* leave it hibernated, the host may retry once memory is available */
+    for( i = 0; i < h->nrecs; i++ ) {
+        if( h->released[i] && h->memTab[i].base ) {
+            Memory_free(memtab_heap(&h->memTab[i]), h->memTab[i].base,
+                        h->memTab[i].size);
+            h->memTab[i].base = NULL;
+        }
+    }
+    return (-1);
+}
@@ -31,11 +31,16 @@
  */
 
 
+#include <string.h>
+
 #include <xdc/std.h>
 #include <xdc/runtime/System.h>
 #include <xdc/runtime/Memory.h>
 #include <xdc/runtime/IHeap.h>
 #include <xdc/runtime/Error.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/hal/Hwi.h>
@@ -45,6 +50,9 @@
 #include <xdc/cfg/global.h>
 
 #include "dce_priv.h"
+#include "ivahd_gov.h"
+#include "timeline.h"
+#include "ti/utils/profile.h"
 
 #include <ti/xdais/ires.h>
 #include <ti/sdo/fc/ires/hdvicp/iresman_hdvicp.h>
@@ -55,9 +63,13 @@
 #include <ti/sdo/fc/ires/hdvicp/hdvicp2.h>
 
 #include <ti/ipc/remoteproc/Resource.h>
+#include <platform/ti/dce/baselib/dce_heap.h>
 
 //#define MEMORYSTATS_DEBUG
 
+/* IRESMAN_HDVICP with instance priorities, see iresman_hdvicp_prio.c */
+extern IRESMAN_Fxns    IRESMAN_HDVICP_PRIO;
+
 static uint32_t    ivahd_base = 0;
 static uint32_t    ivahd_cm_base = 0;
 static uint32_t    ivahd_config_base = 0;
@@ -163,9 +175,141 @@ static inline void sleepms(int ms)
 }
 #endif
 
-void ivahd_boot(void)
+/* Microseconds since boot, from Timestamp.  Keeps counting across the
+ * 32-bit Timestamp wrap as long as it is called at least once per wrap.
+ */
+static UInt32    ivahd_ts_freq = 0;
+static UInt32    ivahd_ts_last = 0;
+static UInt32    ivahd_ts_rem = 0;     /* us * freq not counted yet */
+static UInt32    ivahd_us = 0;
+
+UInt32 ivahd_now_us(void)
+{
+    UInt32      ts;
+    uint64_t    delta;
+    UInt        hwiKey;
+
+    if( !ivahd_ts_freq ) {
+        Types_FreqHz    freq;
+
+        Timestamp_getFreq(&freq);
+        ivahd_ts_freq = freq.lo ? freq.lo : 1;
+        ivahd_ts_last = Timestamp_get32();
+    }
+
+    hwiKey = Hwi_disable();
+    ts = Timestamp_get32();
+    delta = (uint64_t)(ts - ivahd_ts_last) * 1000000 + ivahd_ts_rem;
+    ivahd_ts_last = ts;
+    ivahd_us += (UInt32)(delta / ivahd_ts_freq);
+    ivahd_ts_rem = (UInt32)(delta % ivahd_ts_freq);
+    ts = ivahd_us;
+    Hwi_restore(hwiKey);
+
+    return (ts);
+}
+
+/* Register polling with a deadline, for the IVA-HD PRCM sequences.
+ *
+ * The first few microseconds are spent spinning, as most transitions are
+ * that fast, then the CPU is given away with Task_yield() and finally
+ * Task_sleep() so the other RPCs keep being served.  Outside of a Task it
+ * only spins, still bounded.
+ *
+ * Every step keeps its last and worst duration and its timeout count in
+ * ivahd_poll_steps[].
+ */
+#define IVAHD_POLL_SPIN_US       20
+#define IVAHD_POLL_YIELD_US      1000
+#define IVAHD_POLL_TIMEOUT_US    10000
+#define IVAHD_RESET_TIMEOUT_US   100000  /* standby waits for the codec */
+#define IVAHD_MAX_POLL_STEPS     24
+
+typedef struct Ivahd_Poll_Step {
+    const char   *name;
+    uint32_t      last_us;
+    uint32_t      max_us;
+    uint32_t      count;
+    uint32_t      timeouts;
+} Ivahd_Poll_Step;
+
+Ivahd_Poll_Step    ivahd_poll_steps[IVAHD_MAX_POLL_STEPS];
+
+/* Duration of the last full sequences, us */
+uint32_t    ivahd_boot_us = 0;
+uint32_t    ivahd_reset_us = 0;
+
+static void ivahd_poll_record(const char *name, UInt32 us, Bool timeout)
+{
+    Ivahd_Poll_Step    *step = NULL;
+    int                 i;
+
+    for( i = 0; i < IVAHD_MAX_POLL_STEPS; i++ ) {
+        if( ivahd_poll_steps[i].name == name || !ivahd_poll_steps[i].name ) {
+            step = &ivahd_poll_steps[i];
+            break;
+        }
+    }
+
+    if( !step ) {
+        return;
+    }
+
+    step->name = name;
+    step->last_us = us;
+    if( us > step->max_us ) {
+        step->max_us = us;
+    }
+    step->count++;
+    if( timeout ) {
+        step->timeouts++;
+    }
+}
+
+/* Wait for ((*reg & mask) == val) when equal, ((*reg & mask) != val)
+ * otherwise.  Returns 0, or -1 after timeout_us.  Also used for the DMM
+ * PAT refills of the tiled memory IRESMAN.
+ */
+int ivahd_poll_reg(const char *name, volatile unsigned int *reg,
+                   unsigned int mask, unsigned int val, Bool equal,
+                   UInt32 timeout_us)
+{
+    Bool      task = (BIOS_getThreadType() == BIOS_ThreadType_Task);
+    UInt32    start = ivahd_now_us();
+    UInt32    elapsed = 0;
+
+    while( ((*reg & mask) == val) != equal ) {
+        elapsed = ivahd_now_us() - start;
+
+        if( elapsed > timeout_us ) {
+            ivahd_poll_record(name, elapsed, TRUE);
+            ERROR("%s: timeout after %d us, reg 0x%x", name, elapsed, *reg);
+            return (-1);
+        }
+
+        if( task && (elapsed > IVAHD_POLL_YIELD_US)) {
+            Task_sleep(1);
+        } else if( task && (elapsed > IVAHD_POLL_SPIN_US)) {
+            Task_yield();
+        }
+    }
+
+    ivahd_poll_record(name, ivahd_now_us() - start, FALSE);
+
+    return (0);
+}
+
+#define POLL_SET(name, reg, mask, timeout) \
+    ivahd_poll_reg(name, &(reg), mask, 0, FALSE, timeout)
+#define POLL_CLEAR(name, reg, mask, timeout) \
+    ivahd_poll_reg(name, &(reg), mask, 0, TRUE, timeout)
+#define POLL_EQ(name, reg, mask, val, timeout) \
+    ivahd_poll_reg(name, &(reg), mask, val, TRUE, timeout)
+
+int ivahd_boot(void)
 {
     int                      i;
+    UInt32                   start;
     volatile unsigned int   *icont1_itcm_base_addr =
         (unsigned int *)ICONT1_ITCM_BASE;
     volatile unsigned int   *icont2_itcm_base_addr =
@@ -177,6 +321,8 @@ void ivahd_boot(void)
 
     DEBUG("Booting IVAHD...");
 
+    start = ivahd_now_us();
+
 
     /* Sequence - J6 system address
      * Apply Reset on IVA-HD (0x4AE06F10 = 0x7)
@@ -191,49 +337,49 @@ void ivahd_boot(void)
 
     /* RESET RST_LOGIC, RST_SEQ2, and RST_SEQ1*/
     RM_IVAHD_RSTCTRL = 0x00000007;
-    while(! (RM_IVAHD_RSTCTRL & 0x00000007) ) {
-        ;
+    if( POLL_SET("boot: reset", RM_IVAHD_RSTCTRL, 0x00000007, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /*POWERSTATE : IVAHD_PRM:PM_IVAHD_PWRSTCTRL to ON state*/
     PM_IVAHD_PWRSTCTRL = 0x00000003;
-    while(! (PM_IVAHD_PWRSTCTRL & 0x00000003) ) {
-        ;
+    if( POLL_SET("boot: power on", PM_IVAHD_PWRSTCTRL, 0x00000003, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /*IVAHD_CM2:CM_IVAHD_CLKSTCTRL = SW_WKUP*/
     CM_IVAHD_CLKSTCTRL = 0x00000002;
-    while(! (CM_IVAHD_CLKSTCTRL & 0x00000002) ) {
-        ;
+    if( POLL_SET("boot: SW_WKUP", CM_IVAHD_CLKSTCTRL, 0x00000002, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /*IVAHD_CM2:CM_IVAHD_IVAHD_CLKCTRL - IVA managed by HW*/
     CM_IVAHD_CLKCTRL = 0x00000001;
-    while(! (CM_IVAHD_CLKCTRL & 0x00000001) ) {
-        ;
+    if( POLL_SET("boot: IVA clock auto", CM_IVAHD_CLKCTRL, 0x00000001, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /*IVAHD_CM2:CM_IVAHD_SL2_CLKCTRL - SL2 managed by HW*/
     CM_IVAHD_SL2_CLKCTRL = 0x00000001;
-    while(! (CM_IVAHD_SL2_CLKCTRL & 0x00000001) ) {
-        ;
+    if( POLL_SET("boot: SL2 clock auto", CM_IVAHD_SL2_CLKCTRL, 0x00000001, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* put ICONT1 & ICONT2 in reset and clear IVA logic and SL2 reset */
     DEBUG("Putting [ICONTI ICONT2]: RESET and SL2:OutOfRESET...");
     RM_IVAHD_RSTCTRL = 0x00000003;
-    while(! (RM_IVAHD_RSTCTRL & 0x00000003) ) {
-        ;
+    if( POLL_SET("boot: ICONT reset", RM_IVAHD_RSTCTRL, 0x00000003, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Check IVA Clock IDLEST to be functional and STBYST to be standby */
-    while( (CM_IVAHD_CLKCTRL & 0x00030001) != 0x00001 ) {
-        DEBUG("ivahd_boot waiting for IVA Clock IDLEST to functional and STBYST CM_IVAHD_CLKCTRL 0x%x", CM_IVAHD_CLKCTRL);
+    if( POLL_EQ("boot: IVA functional", CM_IVAHD_CLKCTRL, 0x00030001, 0x00001, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Check SL2 Clock IDLEST to be functional */
-    while( (CM_IVAHD_SL2_CLKCTRL & 0x00030001) != 0x00001 ) {
-        DEBUG("ivahd_boot waiting for SL2 Clock IDLEST to functional\n");
+    if( POLL_EQ("boot: SL2 functional", CM_IVAHD_SL2_CLKCTRL, 0x00030001, 0x00001, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Copy boot code to ICONT1 & ICONT2 memory - Initialized the TCM memory */
@@ -244,22 +390,26 @@ void ivahd_boot(void)
 
     /* Release Reset - clear SEQ2 and SEQ1 */
     RM_IVAHD_RSTCTRL = 0x00000000;
-    while( RM_IVAHD_RSTCTRL != 0x00000000 ) {
-        ;
+    if( POLL_EQ("boot: out of reset", RM_IVAHD_RSTCTRL, 0xffffffff, 0x00000000, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
-    /*Read CM IVAHD CLOCK STATE CONTROL is running or gating/ungating transition is on-going*/
-    DEBUG("Waiting for IVAHD to go out of reset\n");
-
-    while(((CM_IVAHD_CLKSTCTRL) & 0x100) & ~0x100 ) {
-        ;
-    }
+    ivahd_boot_us = ivahd_now_us() - start;
 
     DEBUG("ivahd_boot() CM_IVAHD_CLKCTRL 0x%x CM_IVAHD_CLKSTCTRL 0x%x", CM_IVAHD_CLKCTRL, CM_IVAHD_CLKSTCTRL);
+    INFO("IVAHD booted in %d us", ivahd_boot_us);
+    return (0);
+
+fail:
+    ERROR("ivahd_boot() failed CM_IVAHD_CLKCTRL 0x%x CM_IVAHD_CLKSTCTRL 0x%x RM_IVAHD_RSTCTRL 0x%x",
+          CM_IVAHD_CLKCTRL, CM_IVAHD_CLKSTCTRL, RM_IVAHD_RSTCTRL);
+    return (-1);
 }
 
 int ivahd_reset(void *handle, void *iresHandle)
 {
+    UInt32    start = ivahd_now_us();
+
     /*
      * Reset IVA HD, SL2 and ICONTs
      */
@@ -271,8 +421,8 @@ int ivahd_reset(void *handle, void *iresHandle)
     CM_IVAHD_CLKSTCTRL |= 0x00000003;
 
     /* Wait for IVA HD to standby */
-    while( !((CM_IVAHD_CLKCTRL) & 0x00040000)) {
-        ;
+    if( POLL_SET("reset: standby", CM_IVAHD_CLKCTRL, 0x00040000, IVAHD_RESET_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Disable IVAHD and SL2 modules */
@@ -280,27 +430,24 @@ int ivahd_reset(void *handle, void *iresHandle)
     CM_IVAHD_SL2_CLKCTRL = 0x00000000;
 
     /* Ensure that IVAHD and SL2 are enabled */
-    while( !(CM_IVAHD_CLKCTRL & 0x00030000)) {
-        ;
-    }
-
-    while( !(CM_IVAHD_SL2_CLKCTRL & 0x00030000)) {
-        ;
+    if( POLL_SET("reset: IVA disabled", CM_IVAHD_CLKCTRL, 0x00030000, IVAHD_POLL_TIMEOUT_US) ||
+        POLL_SET("reset: SL2 disabled", CM_IVAHD_SL2_CLKCTRL, 0x00030000, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Precondition - TRM DRA7xx Sec. 3.5.6.5 IVA Subsystem Software Warm Reset Sequence
      * 1. IVA Sequencer CPUS are in IDLE state: CM_IVAHD_CLKCTRL[17:16] IDLEST - has a value 0x2.
      * 2. IVA subsystem is in STANDBY state: CM_IVAHD_CLKCTRL[18] STBYST - has a value of 0x1.
      */
-    while( !(CM_IVAHD_CLKCTRL & 0x00060000) ) {
-        ;
+    if( POLL_SET("reset: IVA idle", CM_IVAHD_CLKCTRL, 0x00060000, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* 3. The functional clock to the IVA subsystem has been gated by the PRCM module
      * CM_IVA_CLKSTCTRL[8] - has a value of 0x0
      */
-    while( CM_IVAHD_CLKSTCTRL & 0x100) {
-        ;
+    if( POLL_CLEAR("reset: IVA clock gated", CM_IVAHD_CLKSTCTRL, 0x100, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
     /* Reset IVAHD sequencers and SL2 */
@@ -329,16 +476,21 @@ int ivahd_reset(void *handle, void *iresHandle)
     RM_IVAHD_RSTCTRL &= 0xFFFFFFFB;
 
     /* Ensure that IVAHD and SL2 are enabled */
-    while( CM_IVAHD_CLKCTRL & 0x00030000 ) {
-        ;
+    if( POLL_CLEAR("reset: IVA enabled", CM_IVAHD_CLKCTRL, 0x00030000, IVAHD_POLL_TIMEOUT_US) ||
+        POLL_CLEAR("reset: SL2 enabled", CM_IVAHD_SL2_CLKCTRL, 0x00030000, IVAHD_POLL_TIMEOUT_US)) {
+        goto fail;
     }
 
-    while( CM_IVAHD_SL2_CLKCTRL & 0x00030000 ) {
-        ;
-    }
+    ivahd_reset_us = ivahd_now_us() - start;
 
-    DEBUG("Resetting IVAHD COMPLETED");
+    DEBUG("Resetting IVAHD COMPLETED in %d us", ivahd_reset_us);
     return (TRUE);
+
+fail:
+    /* the caller is the HDVICP acquire of a process call, which fails */
+    ERROR("Resetting IVAHD FAILED CM_IVAHD_CLKCTRL 0x%x CM_IVAHD_CLKSTCTRL 0x%x", CM_IVAHD_CLKCTRL, CM_IVAHD_CLKSTCTRL);
+    CM_IVAHD_CLKSTCTRL = 0x00000002;
+    return (FALSE);
 }
 
 void crash_reset() {
@@ -352,10 +504,10 @@ void crash_reset() {
         ERROR("RMAN_unregister on IRESMAN_TILEDMEMORY fail with ret %d", ret);
     }
 
-    /* RMAN_unregister IRESMAN_HDVICP */
-    ret = RMAN_unregister(&IRESMAN_HDVICP);
+    /* RMAN_unregister IRESMAN_HDVICP_PRIO */
+    ret = RMAN_unregister(&IRESMAN_HDVICP_PRIO);
     if( ret != IRES_OK ) {
-        ERROR("RMAN_unregister on IRESMAN_HDVICP fail with ret %d", ret);
+        ERROR("RMAN_unregister on IRESMAN_HDVICP_PRIO fail with ret %d", ret);
     }
 
     /* RMAN_exit */
@@ -382,7 +534,25 @@ void crash_reset() {
 
 static int    ivahd_use_cnt = 0;
 
-#ifdef ENABLE_DEAD_CODE
+/* IVA-HD DVFS: the governor (ivahd_gov.c) picks between OPP50 and OPP100
+ * from the measured busy time of each stream's frames.  Only the DPLL_IVA
+ * divider is changed, the voltage is left to the host.  Off by default,
+ * can be patched at runtime, its PA is printed at boot.
+ */
+uint32_t    ivahd_dvfs = 0;
+
+#if ((defined OMAP5430_ES10) || (defined OMAP5432_ES20))
+ #define IVAHD_OPP100_MHZ    388
+#else
+ #define IVAHD_OPP100_MHZ    532
+#endif
+
+static const int         ivahd_opps[] = { 50, 100 };
+static const uint32_t    ivahd_opp_mhz[] = { IVAHD_OPP100_MHZ / 2, IVAHD_OPP100_MHZ };
+
+static uint32_t     ivahd_m5div = 0;    /* divider set by the bootloader */
+static ivahd_gov    ivahd_governor;
+
 static inline void set_ivahd_opp(int opp)
 {
     unsigned int    val;
@@ -392,7 +562,7 @@ static inline void set_ivahd_opp(int opp)
             val = 0x010e;
             break;
         case 50 :
-            val = 0x000e;
+            val = (ivahd_m5div * 2 > 0x1f) ? 0x1f : ivahd_m5div * 2;
             break;
         case 100 :
             val = ivahd_m5div;
@@ -408,14 +578,335 @@ static inline void set_ivahd_opp(int opp)
     DEBUG("CM_DIV_DPLL_IVA=%08x", CM_DIV_DPLL_IVA);
 }
 
-#endif //ENABLE_DEAD_CODE
+/* Called before a frame of codec is processed, with IVA-HD not in use */
+void ivahd_dvfs_begin(void *codec, Ivahd_Frame *frame)
+{
+    int    cur = ivahd_governor.cur;
+    int    opp;
+
+    frame->start = ivahd_now_us();
+    frame->paused = 0;
+
+    if( !ivahd_m5div ) {
+        return;
+    }
+
+    if( !ivahd_dvfs ) {
+        opp = ivahd_governor.nopps - 1;
+        ivahd_governor.cur = opp;
+    } else {
+        opp = ivahd_gov_select(&ivahd_governor, ivahd_now_us());
+    }
+
+    if( opp != cur ) {
+        set_ivahd_opp(ivahd_opps[opp]);
+        dce_timeline(DCE_TL_OPP, 0, ivahd_opp_mhz[opp]);
+        DEBUG("IVA-HD now at %d MHz", ivahd_opp_mhz[opp]);
+#ifdef PSI_KPI
+        kpi_IVA_new_freq(ivahd_opp_mhz[opp]);
+#endif /*PSI_KPI*/
+    }
+}
+
+/* The process call running frame gives up the IVA-HD for a while, other
+ * frames may begin and end meanwhile.  The time until it resumes is not
+ * counted as busy.
+ */
+void ivahd_dvfs_yield(Ivahd_Frame *frame)
+{
+    frame->yielded = ivahd_now_us();
+}
+
+void ivahd_dvfs_resume(Ivahd_Frame *frame)
+{
+    frame->paused += ivahd_now_us() - frame->yielded;
+}
+
+/* Called once the frame started by ivahd_dvfs_begin() is done, returns
+ * the IVA-HD cycles it took.
+ */
+uint32_t ivahd_dvfs_end(void *codec, Ivahd_Frame *frame)
+{
+    UInt32    busy = ivahd_now_us() - frame->start - frame->paused;
+
+    if( !ivahd_m5div ) {
+        return (busy * IVAHD_OPP100_MHZ);
+    }
+
+    ivahd_gov_frame(&ivahd_governor, codec, frame->start, busy);
+
+    return (busy * ivahd_opp_mhz[ivahd_governor.cur]);
+}
+
+uint32_t ivahd_max_mhz(void)
+{
+    return (IVAHD_OPP100_MHZ);
+}
+
+void ivahd_dvfs_remove(void *codec)
+{
+    ivahd_gov_remove(&ivahd_governor, codec);
+}
+
+static void ivahd_dvfs_init(void)
+{
+    if( !ivahd_cm_base ) {
+        return;
+    }
+
+    if( !ivahd_m5div ) {
+        ivahd_m5div = CM_DIV_DPLL_IVA & 0x1f;
+        ivahd_gov_init(&ivahd_governor, ivahd_opp_mhz, DIM(ivahd_opp_mhz), 20, 30);
+#ifdef PSI_KPI
+        kpi_IVA_new_freq(IVAHD_OPP100_MHZ);
+#endif /*PSI_KPI*/
+    } else if( ivahd_governor.cur != ivahd_governor.nopps - 1 ) {
+        /* back from suspend, start over from OPP100 */
+        ivahd_governor.cur = ivahd_governor.nopps - 1;
+        set_ivahd_opp(100);
+#ifdef PSI_KPI
+        kpi_IVA_new_freq(IVAHD_OPP100_MHZ);
+#endif /*PSI_KPI*/
+    }
+}
+
+/* Idle hold: IVA-HD is left in SW_WAKEUP for ivahd_idle_hold_ms after the
+ * last release, so back to back frames do not pay the clock domain wake-up
+ * each time.  0 gates it as soon as it is released.  Can be patched at
+ * runtime, its PA is printed at boot.
+ */
+uint32_t    ivahd_idle_hold_ms = 0;
+
+/* Predictive wake-up: for streams with a regular frame rate, IVA-HD is
+ * woken ivahd_wake_lead_ms before the next frame is expected, and gated
+ * again if it does not come.  0 disables it.
+ */
+uint32_t    ivahd_wake_lead_ms = 0;
+
+#define IVAHD_MAX_STREAMS    16
+#define IVAHD_MIN_SAMPLES    4
+
+/* Inter-arrival predictor of one codec instance, in Clock ticks.  period
+ * and jitter are moving averages (1/8 weight), kept << 4 for precision.
+ */
+typedef struct Ivahd_Stream {
+    void      *codec;
+    UInt32     last;        /* last arrival */
+    UInt32     period;      /* inter-arrival << 4 */
+    UInt32     jitter;      /* mean deviation from period << 4 */
+    UInt32     samples;
+} Ivahd_Stream;
+
+static Ivahd_Stream       ivahd_streams[IVAHD_MAX_STREAMS];
+
+static Clock_Handle       ivahd_hold_clock = NULL;
+static Clock_Handle       ivahd_wake_clock = NULL;
+static Bool               ivahd_awake = FALSE;
+static Bool               ivahd_predicted = FALSE; /* awake on a prediction */
+static UInt32             ivahd_last_change = 0;   /* Clock ticks */
+static Ivahd_Residency    ivahd_res;
+
+static UInt32 ms_to_ticks(uint32_t ms)
+{
+    return ((ms * 1000 + (Clock_tickPeriod - 1)) / Clock_tickPeriod);
+}
+
+/* Called with interrupts disabled */
+static void ivahd_account(void)
+{
+    UInt32    now = Clock_getTicks();
+
+    if( ivahd_awake ) {
+        ivahd_res.awake_ticks += now - ivahd_last_change;
+    } else {
+        ivahd_res.idle_ticks += now - ivahd_last_change;
+    }
+    ivahd_last_change = now;
+}
+
+/* Called with interrupts disabled */
+static void ivahd_set_awake(Bool awake)
+{
+    if( awake == ivahd_awake ) {
+        return;
+    }
+
+    ivahd_account();
+    ivahd_awake = awake;
+
+    if( awake ) {
+        /* switch SW_WAKEUP mode */
+        CM_IVAHD_CLKSTCTRL = 0x00000002;
+        ivahd_res.wakeups++;
+        dce_timeline(DCE_TL_IVA_AWAKE, 0, 0);
+    } else {
+        /* switch HW_AUTO mode */
+        CM_IVAHD_CLKSTCTRL = 0x00000003;
+        ivahd_res.gates++;
+        dce_timeline(DCE_TL_IVA_GATED, 0, 0);
+        if( ivahd_predicted ) {
+            ivahd_res.predict_misses++;
+            ivahd_predicted = FALSE;
+        }
+    }
+}
+
+/* (Re)start clk to expire in ticks, from Task or Swi context */
+static void ivahd_clock_arm(Clock_Handle clk, UInt32 ticks)
+{
+    Clock_stop(clk);
+    Clock_setTimeout(clk, ticks ? ticks : 1);
+    Clock_start(clk);
+}
+
+static Clock_Handle ivahd_clock_create(Clock_FuncPtr fxn)
+{
+    Clock_Params    params;
+    Clock_Handle    clk;
+    Error_Block     eb;
+
+    Error_init(&eb);
+    Clock_Params_init(&params);
+    params.startFlag = FALSE;
+    params.period = 0;
+    clk = Clock_create(fxn, 1, &params, &eb);
+    if( !clk ) {
+        ERROR("could not create an IVA-HD power clock");
+    }
+
+    return (clk);
+}
+
+static void ivahd_hold_expired(UArg arg)
+{
+    UInt    hwiKey = Hwi_disable();
+
+    if( !ivahd_use_cnt ) {
+        ivahd_set_awake(FALSE);
+    }
+    Hwi_restore(hwiKey);
+}
+
+static void ivahd_wake_expired(UArg arg)
+{
+    UInt    hwiKey = Hwi_disable();
+
+    if( !ivahd_use_cnt && !ivahd_awake ) {
+        ivahd_set_awake(TRUE);
+        ivahd_predicted = TRUE;
+        ivahd_res.predict_wakeups++;
+
+        /* gate it again if the frame does not show up */
+        if( ivahd_hold_clock ) {
+            ivahd_clock_arm(ivahd_hold_clock, 2 * ms_to_ticks(ivahd_wake_lead_ms));
+        }
+    }
+    Hwi_restore(hwiKey);
+}
+
+/* Record a frame of codec arriving at ticks (Clock_getTicks()) */
+void ivahd_frame_arrival(void *codec, UInt32 ticks)
+{
+    Ivahd_Stream    *s = NULL, *slot = NULL;
+    Int32            delta, err;
+    int              i;
+
+    for( i = 0; i < IVAHD_MAX_STREAMS; i++ ) {
+        if( ivahd_streams[i].codec == codec ) {
+            s = &ivahd_streams[i];
+            break;
+        }
+        if( !slot && !ivahd_streams[i].codec ) {
+            slot = &ivahd_streams[i];
+        }
+    }
+
+    if( !s ) {
+        if( !slot ) {
+            return;
+        }
+        memset(slot, 0, sizeof(*slot));
+        slot->codec = codec;
+        slot->last = ticks;
+        return;
+    }
+
+    delta = (Int32)(ticks - s->last) << 4;
+    s->last = ticks;
+
+    if( !s->samples++ ) {
+        s->period = delta;
+        return;
+    }
+
+    err = delta - (Int32)s->period;
+    s->period = (Int32)s->period + err / 8;
+    s->jitter = (Int32)s->jitter + ((err < 0 ? -err : err) - (Int32)s->jitter) / 8;
+}
+
+void ivahd_stream_remove(void *codec)
+{
+    int    i;
+
+    for( i = 0; i < IVAHD_MAX_STREAMS; i++ ) {
+        if( ivahd_streams[i].codec == codec ) {
+            ivahd_streams[i].codec = NULL;
+        }
+    }
+}
+
+/* Ticks from now until IVA-HD should be woken for the next expected frame,
+ * or 0 if no stream is regular enough to be predicted.
+ */
+static UInt32 ivahd_next_wake(void)
+{
+    UInt32    now = Clock_getTicks();
+    UInt32    lead = ms_to_ticks(ivahd_wake_lead_ms);
+    UInt32    best = 0;
+    Int32     wait;
+    int       i;
+
+    for( i = 0; i < IVAHD_MAX_STREAMS; i++ ) {
+        Ivahd_Stream    *s = &ivahd_streams[i];
+
+        if( !s->codec || (s->samples < IVAHD_MIN_SAMPLES) ||
+            (s->jitter > s->period / 4)) {
+            continue;
+        }
+
+        /* stream paused, or stopped without being deleted yet */
+        if((Int32)(now - s->last) > (Int32)(2 * (s->period >> 4))) {
+            continue;
+        }
+
+        wait = (Int32)(s->last + ((s->period + s->jitter) >> 4) - now) -
+               (Int32)(lead + (s->jitter >> 4));
+        if((wait > 0) && (!best || ((UInt32)wait < best))) {
+            best = wait;
+        }
+    }
+
+    return (best);
+}
+
 void ivahd_acquire(void)
 {
     if( ++ivahd_use_cnt == 1 ) {
         DEBUG("ivahd acquire");
+        if( ivahd_hold_clock ) {
+            Clock_stop(ivahd_hold_clock);
+        }
+        if( ivahd_wake_clock ) {
+            Clock_stop(ivahd_wake_clock);
+        }
         UInt hwiKey = Hwi_disable();
-        /* switch SW_WAKEUP mode */
-        CM_IVAHD_CLKSTCTRL = 0x00000002;
+        if( ivahd_predicted ) {
+            ivahd_res.predict_hits++;
+            ivahd_predicted = FALSE;
+        } else if( ivahd_awake ) {
+            ivahd_res.hold_hits++;
+        }
+        ivahd_set_awake(TRUE);
         Hwi_restore(hwiKey);
     } else {
         DEBUG("ivahd already acquired");
@@ -424,29 +915,78 @@ void ivahd_acquire(void)
 
 void ivahd_release(void)
 {
+    UInt32    wake;
+
     if( ivahd_use_cnt-- == 1 ) {
         DEBUG("ivahd release");
-        UInt hwiKey = Hwi_disable();
-        /* switch HW_AUTO mode */
-        CM_IVAHD_CLKSTCTRL = 0x00000003;
-        Hwi_restore(hwiKey);
+        if((ivahd_idle_hold_ms || ivahd_wake_lead_ms) && !ivahd_hold_clock ) {
+            ivahd_hold_clock = ivahd_clock_create(ivahd_hold_expired);
+        }
+        if( ivahd_wake_lead_ms && !ivahd_wake_clock ) {
+            ivahd_wake_clock = ivahd_clock_create(ivahd_wake_expired);
+        }
+
+        if( ivahd_idle_hold_ms && ivahd_hold_clock ) {
+            ivahd_clock_arm(ivahd_hold_clock, ms_to_ticks(ivahd_idle_hold_ms));
+        } else {
+            UInt hwiKey = Hwi_disable();
+            ivahd_set_awake(FALSE);
+            Hwi_restore(hwiKey);
+        }
+
+        /* the wake clock does nothing if the hold is still running then */
+        wake = ivahd_wake_lead_ms ? ivahd_next_wake() : 0;
+        if( wake && ivahd_wake_clock ) {
+            ivahd_clock_arm(ivahd_wake_clock, wake);
+        }
     } else {
         DEBUG("ivahd still in use");
     }
 }
 
+/* Gate IVA-HD now if it is only kept awake by the idle hold or a
+ * predicted wake-up, and cancel pending wake-ups.
+ */
+void ivahd_idle_flush(void)
+{
+    if( ivahd_hold_clock ) {
+        Clock_stop(ivahd_hold_clock);
+    }
+    if( ivahd_wake_clock ) {
+        Clock_stop(ivahd_wake_clock);
+    }
+
+    UInt hwiKey = Hwi_disable();
+    if( !ivahd_use_cnt ) {
+        ivahd_set_awake(FALSE);
+    }
+    Hwi_restore(hwiKey);
+}
+
+Bool ivahd_is_awake(void)
+{
+    return (ivahd_awake);
+}
+
+void ivahd_residency(Ivahd_Residency *res)
+{
+    UInt hwiKey = Hwi_disable();
+
+    ivahd_account();
+    *res = ivahd_res;
+    Hwi_restore(hwiKey);
+}
+
 /* This function is to check IVA clocks to make sure IVAHD is idle */
 void ivahd_idle_check(void)
 {
     DEBUG("ivahd_idle check CM_IVAHD_CLKCTRL=0x%x CM_IVAHD_SL2_CLKCTRL=0x%x\n", CM_IVAHD_CLKCTRL, CM_IVAHD_SL2_CLKCTRL);
 
     /* Ensure that IVAHD and SL2 idle */
-    while( !(CM_IVAHD_CLKCTRL & 0x00020000)) {
-        ;
-    }
-
-    while( !(CM_IVAHD_SL2_CLKCTRL & 0x00020000)) {
-        ;
+    if( POLL_SET("idle: IVA", CM_IVAHD_CLKCTRL, 0x00020000, IVAHD_RESET_TIMEOUT_US) ||
+        POLL_SET("idle: SL2", CM_IVAHD_SL2_CLKCTRL, 0x00020000, IVAHD_RESET_TIMEOUT_US)) {
+        /* codecs can not be deleted safely, let the host restart us */
+        crash_reset();
     }
 
     DEBUG("ivahd_idle_check DONE - IVAHD and SL2 are in IDLE state\n");
@@ -529,6 +1069,8 @@ void ivahd_init(uint32_t chipset_id)
     /* bit of a hack.. not sure if there is a better way for this: */
     HDVICP2_PARAMS.resetControlAddress[0] = ivahd_base + 0x10;
 
+    ivahd_dvfs_init();
+
     ivahd_acquire();
 
     CERuntime_init();
@@ -541,9 +1083,9 @@ void ivahd_init(uint32_t chipset_id)
     }
 
     /* Register HDVICP with RMAN if not already registered */
-    ret = RMAN_register(&IRESMAN_HDVICP, &rman_params);
+    ret = RMAN_register(&IRESMAN_HDVICP_PRIO, &rman_params);
     if((ret != IRES_OK) && (ret != IRES_EEXISTS)) {
-        ERROR("could not register IRESMAN_HDVICP: %d", ret);
+        ERROR("could not register IRESMAN_HDVICP_PRIO: %d", ret);
         RMAN_exit();
         CERuntime_exit();
         goto end;
@@ -557,17 +1099,22 @@ void ivahd_init(uint32_t chipset_id)
     ret = RMAN_register(&IRESMAN_TILEDMEMORY, &rman_params);
     if((ret != IRES_OK) && (ret != IRES_EEXISTS)) {
         ERROR("could not register IRESMAN_TILEDMEMORY: %d", ret);
-        ret = RMAN_unregister(&IRESMAN_HDVICP);
+        ret = RMAN_unregister(&IRESMAN_HDVICP_PRIO);
         if( ret != IRES_OK ) {
-            ERROR("RMAN_unregister on IRESMAN_HDVICP fail with ret %d", ret);
+            ERROR("RMAN_unregister on IRESMAN_HDVICP_PRIO fail with ret %d", ret);
         }
         RMAN_exit();
         CERuntime_exit();
         goto end;
     }
 
+    dce_init_stage(DCE_STAGE_IVAHD_RMAN);
+
+    if( ivahd_boot()) {
+        crash_reset();
+    }
 
-    ivahd_boot();
+    dce_init_stage(DCE_STAGE_IVAHD_BOOT);
 
     DEBUG("RMAN_register() for HDVICP is successful");
 
@@ -581,7 +1128,7 @@ static Bool allocFxn(IALG_MemRec memTab[], Int n)
     Int    i;
 
 #ifdef MEMORYSTATS_DEBUG
-    Memory_Stats    stats;
+    DceHeap_Stats    stats;
 #endif
 
     for( i = 0; i < n; i++ ) {
@@ -589,6 +1136,7 @@ static Bool allocFxn(IALG_MemRec memTab[], Int n)
         Uns            pad, size;
         void          *blk;
         MemHeader     *hdr;
+        int            heap = dce_heap_select(&memTab[i]);
 
         if( memTab[i].alignment > sizeof(MemHeader)) {
             pad = memTab[i].alignment;
@@ -599,12 +1147,12 @@ static Bool allocFxn(IALG_MemRec memTab[], Int n)
         size = memTab[i].size + pad;
 
 #ifdef MEMORYSTATS_DEBUG
-        Memory_getStats(NULL, &stats);
-        INFO("Total: %d\tFree: %d\tLargest: %d", stats.totalSize,
-             stats.totalFreeSize, stats.largestFreeSize);
+        dce_heap_stats(heap, &stats);
+        INFO("Heap %d Total: %d\tFree: %d\tLargest: ~%d", heap, stats.total,
+             stats.total - stats.used, stats.largest_free);
 #endif
 
-        blk = Memory_alloc(NULL, size, memTab[i].alignment, &eb);
+        blk = Memory_alloc(dce_heap_handle(heap), size, memTab[i].alignment, &eb);
 
         if( !blk ) {
             ERROR("MemTab Allocation failed at %d", i);
@@ -615,6 +1163,7 @@ static Bool allocFxn(IALG_MemRec memTab[], Int n)
             hdr = P2H(memTab[i].base);
             hdr->size = size;
             hdr->ptr  = blk;
+            hdr->region = heap;
             DEBUG("%d: alloc: %p/%p (%d)", i, hdr->ptr,
                   memTab[i].base, hdr->size);
         }
@@ -629,7 +1178,7 @@ static void freeFxn(IALG_MemRec memTab[], Int n)
     Int    i;
 
 #ifdef MEMORYSTATS_DEBUG
-    Memory_Stats    stats;
+    DceHeap_Stats    stats;
 #endif
 
     for( i = 0; i < n; i++ ) {
@@ -640,13 +1189,13 @@ static void freeFxn(IALG_MemRec memTab[], Int n)
             DEBUG("%d: free: %p/%p (%d)", n, hdr->ptr,
                   memTab[i].base, hdr->size);
 #endif
-            Memory_free(NULL, hdr->ptr, hdr->size);
-        }
+            Memory_free(dce_heap_handle(hdr->region), hdr->ptr, hdr->size);
 #ifdef MEMORYSTATS_DEBUG
-        Memory_getStats(NULL, &stats);
-        INFO("Total: %d\tFree: %d\tLargest: %d", stats.totalSize,
-             stats.totalFreeSize, stats.largestFreeSize);
+            dce_heap_stats(hdr->region, &stats);
+            INFO("Heap %d Total: %d\tFree: %d\tLargest: ~%d", hdr->region,
+                 stats.total, stats.total - stats.used, stats.largest_free);
 #endif
+        }
     }
 }
 
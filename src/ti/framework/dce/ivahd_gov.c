@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "ivahd_gov.h"
+
+#define GOV_MIN_SAMPLES    3
+#define GOV_STALE_PERIODS  4
+
+void ivahd_gov_init(ivahd_gov *gov, const uint32_t *mhz, int nopps,
+                    uint32_t headroom, uint32_t down_frames)
+{
+    memset(gov, 0, sizeof(*gov));
+
+    if( nopps > IVAHD_GOV_MAX_OPPS ) {
+        nopps = IVAHD_GOV_MAX_OPPS;
+    }
+    memcpy(gov->mhz, mhz, nopps * sizeof(mhz[0]));
+    gov->nopps = nopps;
+    gov->cur = nopps - 1;
+    gov->headroom = headroom;
+    gov->down_frames = down_frames;
+}
+
+static ivahd_gov_stream *find_stream(ivahd_gov *gov, void *id, int create)
+{
+    ivahd_gov_stream    *free_slot = NULL;
+    int                  i;
+
+    for( i = 0; i < IVAHD_GOV_MAX_STREAMS; i++ ) {
+        if( gov->streams[i].id == id ) {
+            return (&gov->streams[i]);
+        }
+        if( !free_slot && !gov->streams[i].id ) {
+            free_slot = &gov->streams[i];
+        }
+    }
+
+    if( create && free_slot ) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->id = id;
+        return (free_slot);
+    }
+
+    return (NULL);
+}
+
+/* moving average, 1/4 weight */
+static uint32_t average(uint32_t avg, uint32_t v)
+{
+    return ((uint32_t)((int32_t)avg + ((int32_t)v - (int32_t)avg) / 4));
+}
+
+void ivahd_gov_frame(ivahd_gov *gov, void *id, uint32_t start, uint32_t busy)
+{
+    ivahd_gov_stream    *s = find_stream(gov, id, 1);
+    uint32_t             cycles = busy * gov->mhz[gov->cur];
+
+    if( !s ) {
+        return;
+    }
+
+    if( s->samples ) {
+        uint32_t    period = start - s->last;
+
+        s->period = (s->samples == 1) ? period : average(s->period, period);
+        s->cycles = average(s->cycles, cycles);
+    } else {
+        s->cycles = cycles;
+    }
+
+    s->last = start;
+    s->samples++;
+}
+
+void ivahd_gov_remove(ivahd_gov *gov, void *id)
+{
+    ivahd_gov_stream    *s = find_stream(gov, id, 0);
+
+    if( s ) {
+        s->id = NULL;
+    }
+}
+
+uint32_t ivahd_gov_demand(const ivahd_gov *gov, uint32_t now)
+{
+    uint64_t    demand = 0;
+    int         i;
+
+    for( i = 0; i < IVAHD_GOV_MAX_STREAMS; i++ ) {
+        const ivahd_gov_stream    *s = &gov->streams[i];
+
+        if( !s->id ) {
+            continue;
+        }
+
+        if( s->samples < GOV_MIN_SAMPLES || !s->period ) {
+            return (0xffffffff);
+        }
+
+        /* paused or gone without being deleted, it does not count */
+        if( now - s->last > GOV_STALE_PERIODS * s->period ) {
+            continue;
+        }
+
+        demand += s->cycles / s->period;
+    }
+
+    demand = demand * (100 + gov->headroom) / 100;
+
+    return ((demand > 0xfffffffe) ? 0xfffffffe : (uint32_t)demand);
+}
+
+int ivahd_gov_select(ivahd_gov *gov, uint32_t now)
+{
+    uint32_t    demand = ivahd_gov_demand(gov, now);
+    int         opp;
+
+    for( opp = 0; opp < gov->nopps - 1; opp++ ) {
+        if( gov->mhz[opp] >= demand ) {
+            break;
+        }
+    }
+
+    if( opp >= gov->cur ) {
+        gov->below = 0;
+        gov->cur = opp;
+    } else if( ++gov->below >= gov->down_frames ) {
+        gov->below = 0;
+        gov->cur = opp;
+    }
+
+    return (gov->cur);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __IVAHD_GOV_H__
+#define __IVAHD_GOV_H__
+
+#include <stdint.h>
+
+/* IVA-HD frequency governor policy.
+ *
+ * Picks the lowest OPP at which every active stream still gets its frames
+ * done within its frame period.  Each stream's work per frame is tracked
+ * in cycles (busy time x MHz it ran at), so what it would take at another
+ * OPP is known without having run there.  Streams whose period is not
+ * known yet keep the highest OPP.
+ *
+ * Plain C without any BIOS dependency, so it can be built and exercised
+ * on a host, see test/ivahd_gov_test.c.  Not reentrant, the caller
+ * serializes.
+ */
+
+#define IVAHD_GOV_MAX_OPPS       4
+#define IVAHD_GOV_MAX_STREAMS    16
+
+typedef struct ivahd_gov_stream {
+    void        *id;            /* codec handle, NULL when unused */
+    uint32_t     last;          /* start of the last frame, us */
+    uint32_t     period;        /* frame period, us, moving average */
+    uint32_t     cycles;        /* work per frame, MHz x us, moving average */
+    uint32_t     samples;
+} ivahd_gov_stream;
+
+typedef struct ivahd_gov {
+    uint32_t            mhz[IVAHD_GOV_MAX_OPPS];    /* ascending */
+    int                 nopps;
+    int                 cur;            /* index in mhz[] */
+    uint32_t            headroom;       /* % of margin on top of the demand */
+    uint32_t            down_frames;    /* frames below cur before going down */
+    uint32_t            below;
+    ivahd_gov_stream    streams[IVAHD_GOV_MAX_STREAMS];
+} ivahd_gov;
+
+void ivahd_gov_init(ivahd_gov *gov, const uint32_t *mhz, int nopps,
+                    uint32_t headroom, uint32_t down_frames);
+
+/* A frame of stream id started at start (us) and kept IVA-HD busy for
+ * busy us, at the current OPP.
+ */
+void ivahd_gov_frame(ivahd_gov *gov, void *id, uint32_t start, uint32_t busy);
+
+void ivahd_gov_remove(ivahd_gov *gov, void *id);
+
+/* MHz needed by the active streams at now (us), margin included, or
+ * 0xffffffff when a stream is not characterized yet.
+ */
+uint32_t ivahd_gov_demand(const ivahd_gov *gov, uint32_t now);
+
+/* OPP (index in mhz[]) to run the next frame at.  Going up is immediate,
+ * going down waits for down_frames consecutive frames asking for less.
+ */
+int ivahd_gov_select(ivahd_gov *gov, uint32_t now);
+
+#endif /* __IVAHD_GOV_H__ */
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* Latency histograms of each codec instance.
+ *
+ * For each process call, the time spent in the codec process() (M4 side
+ * work and yields included), the IVA-HD time alone (the HDVICP wait time
+ * below), the time waiting for the process lock, and the whole RPC, from
+ * its arrival to its reply.  Kept in Timestamp counts, converted to us
+ * only when read.
+ *
+ * The phases of the process calls (see rpcprof.h) are only summed up, as
+ * is their split around the IVA-HD runs (see hdvicp_runs_begin()).
+ *
+ * Called with sync_process_sem held, but for dce_latency_totals().
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Memory.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sdo/ce/Engine.h>
+
+#include <ti/utils/histogram.h>
+#include <ti/utils/timebase.h>
+
+#include "dce_priv.h"
+#include "dce_rpc.h"
+#include "dce_stats.h"
+
+typedef struct Latency {
+    void              *codec;
+    histogram          proc;
+    histogram          iva;
+    histogram          rpc;
+    histogram          wait;
+    uint64_t           proc_sum;
+    uint64_t           rpc_sum;
+    uint64_t           wait_sum;
+    uint64_t           phase_sum[DCE_STATS_PHASES];
+    uint64_t           pre_sum;
+    uint64_t           hdvicp_sum;
+    uint64_t           post_sum;
+    uint32_t           hdvicp_runs;
+    struct Latency    *next;
+} Latency;
+
+static Latency    *latencies = NULL;
+
+static Latency *find(void *codec)
+{
+    Latency    *l;
+
+    for( l = latencies; l; l = l->next ) {
+        if( l->codec == codec ) {
+            return (l);
+        }
+    }
+
+    return (NULL);
+}
+
+void dce_latency_add(void *codec)
+{
+    Latency    *l = Memory_calloc(NULL, sizeof(Latency), 0, NULL);
+
+    if( !l ) {
+        ERROR("no memory for codec %p latencies", codec);
+        return;
+    }
+
+    l->codec = codec;
+    l->next = latencies;
+    latencies = l;
+}
+
+void dce_latency_remove(void *codec)
+{
+    Latency    **prev, *l;
+    UInt         key;
+
+    for( prev = &latencies; *prev; prev = &(*prev)->next ) {
+        if( (*prev)->codec == codec ) {
+            /* dce_latency_totals() may be walking the list */
+            key = Task_disable();
+            l = *prev;
+            *prev = l->next;
+            Task_restore(key);
+            Memory_free(NULL, l, sizeof(Latency));
+            return;
+        }
+    }
+}
+
+/* Times in Timestamp counts */
+void dce_latency_record(void *codec, uint32_t proc, uint32_t rpc, uint32_t wait)
+{
+    Latency    *l = find(codec);
+
+    if( l ) {
+        hist_add(&l->proc, proc);
+        hist_add(&l->rpc, rpc);
+        hist_add(&l->wait, wait);
+        l->proc_sum += proc;
+        l->rpc_sum += rpc;
+        l->wait_sum += wait;
+    }
+}
+
+/* DCE_STATS_PHASES times, in Timestamp counts */
+void dce_latency_phases(void *codec, const uint32_t *phase)
+{
+    Latency    *l = find(codec);
+    Int         i;
+
+    if( l ) {
+        for( i = 0; i < DCE_STATS_PHASES; i++ ) {
+            l->phase_sum[i] += phase[i];
+        }
+    }
+}
+
+/* Times in Timestamp counts */
+void dce_latency_runs(void *codec, const Hdvicp_Runs *runs)
+{
+    Latency    *l = find(codec);
+
+    if( l ) {
+        hist_add(&l->iva, runs->iva);
+        l->pre_sum += runs->pre;
+        l->hdvicp_sum += runs->iva;
+        l->post_sum += runs->post;
+        l->hdvicp_runs += runs->runs;
+    }
+}
+
+static void get_stats(const histogram *h, dce_latency_stats *stats)
+{
+    stats->count = h->count;
+    stats->p50 = (uint32_t)kpi_ts_to_us(hist_percentile(h, 50));
+    stats->p95 = (uint32_t)kpi_ts_to_us(hist_percentile(h, 95));
+    stats->p99 = (uint32_t)kpi_ts_to_us(hist_percentile(h, 99));
+    stats->max = (uint32_t)kpi_ts_to_us(h->max);
+}
+
+/* In us, returns -1 for an unknown codec */
+Int dce_latency_get(void *codec, struct dce_latency *lat)
+{
+    Latency         *l = find(codec);
+
+    if( !l ) {
+        return (-1);
+    }
+
+    get_stats(&l->proc, &lat->proc);
+    get_stats(&l->rpc, &lat->rpc);
+    get_stats(&l->wait, &lat->wait);
+
+    return (0);
+}
+
+static void print_stats(const char *what, const dce_latency_stats *stats)
+{
+    System_printf("  %-5s p50 %6u p95 %6u p99 %6u max %6u us\n", what,
+                  stats->p50, stats->p95, stats->p99, stats->max);
+}
+
+void dce_latency_print(void *codec)
+{
+    dce_latency          lat;
+    dce_latency_stats    iva;
+    Latency             *l = find(codec);
+
+    if( dce_latency_get(codec, &lat) < 0 || !lat.rpc.count ) {
+        return;
+    }
+
+    System_printf("codec %p latencies over %u calls:\n", codec, lat.rpc.count);
+    print_stats("proc", &lat.proc);
+    get_stats(&l->iva, &iva);
+    print_stats("IVA", &iva);
+    print_stats("wait", &lat.wait);
+    print_stats("RPC", &lat.rpc);
+    System_printf("  host pre-IVA %u us, IVA-HD %u us, host post-IVA %u us, %u runs per call\n",
+                  (uint32_t)(kpi_ts_to_us(l->pre_sum) / lat.rpc.count),
+                  (uint32_t)(kpi_ts_to_us(l->hdvicp_sum) / lat.rpc.count),
+                  (uint32_t)(kpi_ts_to_us(l->post_sum) / lat.rpc.count),
+                  l->hdvicp_runs / lat.rpc.count);
+}
+
+/* Cumulative figures of up to max instances, in us, for the statistics
+ * page.  Returns the number of instances filled in.
+ */
+Int dce_latency_totals(struct Dce_Stats_Codec *codecs, Int max)
+{
+    Latency     *l;
+    Int          n = 0, i;
+    UInt         key = Task_disable();
+
+    for( l = latencies; l && (n < max); l = l->next, n++ ) {
+        codecs[n].handle = (uint32_t)l->codec;
+        codecs[n].calls = l->rpc.count;
+        codecs[n].proc_us = (uint32_t)kpi_ts_to_us(l->proc_sum);
+        codecs[n].wait_us = (uint32_t)kpi_ts_to_us(l->wait_sum);
+        codecs[n].rpc_us = (uint32_t)kpi_ts_to_us(l->rpc_sum);
+        codecs[n].proc_max_us = (uint32_t)kpi_ts_to_us(l->proc.max);
+        for( i = 0; i < DCE_STATS_PHASES; i++ ) {
+            codecs[n].phase_us[i] = (uint32_t)kpi_ts_to_us(l->phase_sum[i]);
+        }
+        codecs[n].pre_iva_us = (uint32_t)kpi_ts_to_us(l->pre_sum);
+        codecs[n].hdvicp_us = (uint32_t)kpi_ts_to_us(l->hdvicp_sum);
+        codecs[n].post_iva_us = (uint32_t)kpi_ts_to_us(l->post_sum);
+        codecs[n].hdvicp_runs = l->hdvicp_runs;
+        codecs[n].iva_p50_us = (uint32_t)kpi_ts_to_us(hist_percentile(&l->iva, 50));
+        codecs[n].iva_p99_us = (uint32_t)kpi_ts_to_us(hist_percentile(&l->iva, 99));
+        codecs[n].iva_max_us = (uint32_t)kpi_ts_to_us(l->iva.max);
+    }
+    Task_restore(key);
+
+    return (n);
+}
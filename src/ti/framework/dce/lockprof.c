@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* Lock contention profile, see lockprof.h */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include <ti/utils/timebase.h>
+
+#include "dce_priv.h"
+#include "lockprof.h"
+
+#define DCE_LOCKS_MAX    16
+#define DCE_LOCK_TASKS   6      /* per lock, the last one takes the others */
+
+/* Times in Timestamp counts */
+typedef struct Lock_Stats {
+    uint32_t    acquired;
+    uint32_t    contended;
+    uint64_t    wait;
+    uint32_t    wait_max;
+    uint64_t    hold;
+    uint32_t    hold_max;
+    uint32_t    cond_waits;
+    uint64_t    cond_wait;
+} Lock_Stats;
+
+typedef struct Lock_Task {
+    Task_Handle    task;
+    Lock_Stats     stats;
+} Lock_Task;
+
+struct Dce_Lock {
+    const char    *name;
+    void          *id;
+    Bool           used;
+    Bool           registered;
+    uint32_t       t_acquired;
+    Lock_Stats     stats;
+    Lock_Task      tasks[DCE_LOCK_TASKS];
+};
+
+static Dce_Lock    locks[DCE_LOCKS_MAX];
+
+Dce_Lock *dce_lock_register(const char *name, void *id)
+{
+    Dce_Lock    *lock = NULL;
+    Int          i;
+    UInt         key = Task_disable();
+
+    /* a slot never used, else one of an unregistered lock */
+    for( i = 0; i < DCE_LOCKS_MAX; i++ ) {
+        if( !locks[i].used ) {
+            lock = &locks[i];
+            break;
+        }
+        if( !locks[i].registered && !lock ) {
+            lock = &locks[i];
+        }
+    }
+
+    if( lock ) {
+        memset(lock, 0, sizeof(Dce_Lock));
+        lock->name = name;
+        lock->id = id;
+        lock->used = TRUE;
+        lock->registered = TRUE;
+    }
+    Task_restore(key);
+
+    if( !lock ) {
+        DEBUG("no slot left to profile lock %s %p", name, id);
+    }
+
+    return (lock);
+}
+
+void dce_lock_unregister(Dce_Lock *lock)
+{
+    if( lock ) {
+        lock->registered = FALSE;
+    }
+}
+
+static Lock_Stats *task_stats(Dce_Lock *lock)
+{
+    Task_Handle    self = Task_self();
+    Int            i;
+
+    for( i = 0; i < DCE_LOCK_TASKS - 1; i++ ) {
+        if( lock->tasks[i].task == self ) {
+            return (&lock->tasks[i].stats);
+        }
+        if( !lock->tasks[i].task ) {
+            lock->tasks[i].task = self;
+            return (&lock->tasks[i].stats);
+        }
+    }
+
+    return (&lock->tasks[DCE_LOCK_TASKS - 1].stats);
+}
+
+static void add_acquired(Lock_Stats *stats, Bool contended, uint32_t wait)
+{
+    stats->acquired++;
+    if( contended ) {
+        stats->contended++;
+    }
+    stats->wait += wait;
+    if( wait > stats->wait_max ) {
+        stats->wait_max = wait;
+    }
+}
+
+static void add_released(Lock_Stats *stats, uint32_t hold)
+{
+    stats->hold += hold;
+    if( hold > stats->hold_max ) {
+        stats->hold_max = hold;
+    }
+}
+
+static void add_cond_wait(Lock_Stats *stats, uint32_t wait)
+{
+    stats->cond_waits++;
+    stats->cond_wait += wait;
+}
+
+/* With the lock just taken, t_start when it was asked for */
+static void acquired(Dce_Lock *lock, Bool contended, uint32_t t_start)
+{
+    uint32_t    now = Timestamp_get32();
+
+    add_acquired(&lock->stats, contended, now - t_start);
+    add_acquired(task_stats(lock), contended, now - t_start);
+    lock->t_acquired = now;
+}
+
+/* With the lock still held */
+static void released(Dce_Lock *lock)
+{
+    uint32_t    hold = Timestamp_get32() - lock->t_acquired;
+
+    add_released(&lock->stats, hold);
+    add_released(task_stats(lock), hold);
+}
+
+void dce_lock_pend(Dce_Lock *lock, Semaphore_Handle sem)
+{
+    uint32_t    t_start;
+    Bool        contended = FALSE;
+
+    if( !lock ) {
+        Semaphore_pend(sem, BIOS_WAIT_FOREVER);
+        return;
+    }
+
+    t_start = Timestamp_get32();
+    if( !Semaphore_pend(sem, BIOS_NO_WAIT)) {
+        contended = TRUE;
+        Semaphore_pend(sem, BIOS_WAIT_FOREVER);
+    }
+    acquired(lock, contended, t_start);
+}
+
+void dce_lock_post(Dce_Lock *lock, Semaphore_Handle sem)
+{
+    if( lock ) {
+        released(lock);
+    }
+    Semaphore_post(sem);
+}
+
+int dce_mutex_lock(Dce_Lock *lock, pthread_mutex_t *mutex)
+{
+    uint32_t    t_start;
+    Bool        contended = FALSE;
+    int         ret;
+
+    if( !lock ) {
+        return (pthread_mutex_lock(mutex));
+    }
+
+    t_start = Timestamp_get32();
+    ret = pthread_mutex_trylock(mutex);
+    if( ret ) {
+        contended = TRUE;
+        ret = pthread_mutex_lock(mutex);
+    }
+    if( !ret ) {
+        acquired(lock, contended, t_start);
+    }
+
+    return (ret);
+}
+
+int dce_mutex_unlock(Dce_Lock *lock, pthread_mutex_t *mutex)
+{
+    if( lock ) {
+        released(lock);
+    }
+    return (pthread_mutex_unlock(mutex));
+}
+
+int dce_cond_wait(Dce_Lock *lock, pthread_cond_t *cond, pthread_mutex_t *mutex)
+{
+    uint32_t    t_start;
+    int         ret;
+
+    if( !lock ) {
+        return (pthread_cond_wait(cond, mutex));
+    }
+
+    released(lock);
+    t_start = Timestamp_get32();
+    ret = pthread_cond_wait(cond, mutex);
+    lock->t_acquired = Timestamp_get32();
+
+    add_cond_wait(&lock->stats, lock->t_acquired - t_start);
+    add_cond_wait(task_stats(lock), lock->t_acquired - t_start);
+
+    return (ret);
+}
+
+static void print_stats(const char *what, const Lock_Stats *stats)
+{
+    System_printf("  %-20s %6u acq %6u contended  wait %8u us (max %6u)"
+                  "  hold %8u us (max %6u)  cond %u waits %8u us\n", what,
+                  stats->acquired, stats->contended,
+                  (uint32_t)kpi_ts_to_us(stats->wait), (uint32_t)kpi_ts_to_us(stats->wait_max),
+                  (uint32_t)kpi_ts_to_us(stats->hold), (uint32_t)kpi_ts_to_us(stats->hold_max),
+                  stats->cond_waits, (uint32_t)kpi_ts_to_us(stats->cond_wait));
+}
+
+void dce_lock_report(void)
+{
+    Bool            done[DCE_LOCKS_MAX];
+    Dce_Lock       *lock;
+    String          name;
+    Int             i, j, n;
+
+    memset(done, 0, sizeof(done));
+
+    /* worst offenders first: most time waited for the lock, then held */
+    for( n = 0; n < DCE_LOCKS_MAX; n++ ) {
+        lock = NULL;
+        for( i = 0; i < DCE_LOCKS_MAX; i++ ) {
+            if( done[i] || !locks[i].used || !locks[i].stats.acquired ) {
+                continue;
+            }
+            if( !lock || (locks[i].stats.wait > lock->stats.wait) ||
+                ((locks[i].stats.wait == lock->stats.wait) &&
+                 (locks[i].stats.hold > lock->stats.hold))) {
+                lock = &locks[i];
+            }
+        }
+        if( !lock ) {
+            break;
+        }
+        done[lock - locks] = TRUE;
+
+        System_printf("lock %s %p%s:\n", lock->name, lock->id,
+                      lock->registered ? "" : " (gone)");
+        print_stats("all", &lock->stats);
+        for( j = 0; j < DCE_LOCK_TASKS; j++ ) {
+            if( !lock->tasks[j].stats.acquired && !lock->tasks[j].stats.cond_waits ) {
+                continue;
+            }
+            name = (j == DCE_LOCK_TASKS - 1) ? "others" :
+                   Task_Handle_name(lock->tasks[j].task);
+            print_stats(name ? name : "?", &lock->tasks[j].stats);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __LOCKPROF_H__
+#define __LOCKPROF_H__
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/posix/pthread.h>
+
+/* Lock contention profile.
+ *
+ * The serialization points of the server, sync_process_sem and the row
+ * mode callback mutexes, are taken through these wrappers.  For each lock,
+ * and each task taking it, they count:
+ *  - the acquisitions, and the contended ones, which found it taken,
+ *  - the time waiting for it, total and max,
+ *  - the time holding it, total and max,
+ *  - for a mutex, the time waiting on a condition with it.  The mutex is
+ *    not held meanwhile, and getting it back is part of that wait.
+ *
+ * A lock's figures only change with the lock held, so they need no lock
+ * of their own.  A lock which is not registered (NULL) is still taken,
+ * only not profiled.  The figures of an unregistered lock are kept for
+ * the report until its slot is needed again.
+ */
+
+typedef struct Dce_Lock    Dce_Lock;
+
+/* id tells the instances of name apart, e.g. a codec handle */
+Dce_Lock *dce_lock_register(const char *name, void *id);
+void dce_lock_unregister(Dce_Lock *lock);
+
+void dce_lock_pend(Dce_Lock *lock, Semaphore_Handle sem);
+void dce_lock_post(Dce_Lock *lock, Semaphore_Handle sem);
+
+int dce_mutex_lock(Dce_Lock *lock, pthread_mutex_t *mutex);
+int dce_mutex_unlock(Dce_Lock *lock, pthread_mutex_t *mutex);
+int dce_cond_wait(Dce_Lock *lock, pthread_cond_t *cond, pthread_mutex_t *mutex);
+
+/* Print the locks profiled, the most waited for first */
+void dce_lock_report(void);
+
+#endif /* __LOCKPROF_H__ */
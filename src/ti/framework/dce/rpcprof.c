@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* Phases of the RPCs served, see rpcprof.h */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sdo/ce/Engine.h>
+
+#include <ti/utils/histogram.h>
+#include <ti/utils/timebase.h>
+#include <ti/utils/osal/btrace.h>
+
+#include "dce_priv.h"
+#include "dce_rpc.h"
+#include "rpcprof.h"
+
+typedef struct Rpc_Totals {
+    uint64_t     total;
+    uint64_t     phase[DCE_STATS_PHASES];
+    histogram    hist;
+} Rpc_Totals;
+
+static Rpc_Totals    rpcs[DCE_STATS_RPCS];
+
+/* Set to log each call in the binary trace */
+uint32_t    dce_rpc_trace = 0;
+
+void dce_rpc_begin(Dce_Rpc_Prof *prof, uint32_t call, void *codec)
+{
+    memset(prof, 0, sizeof(Dce_Rpc_Prof));
+    prof->call = call;
+    prof->codec = codec;
+    prof->start = prof->mark = Timestamp_get32();
+
+    dce_stats_kick();
+}
+
+void dce_rpc_phase(Dce_Rpc_Prof *prof, Dce_Phase phase)
+{
+    uint32_t    now = Timestamp_get32();
+    uint32_t    elapsed = now - prof->mark;
+
+    if( elapsed > prof->nested ) {
+        prof->phase[phase] += elapsed - prof->nested;
+    }
+    prof->nested = 0;
+    prof->mark = now;
+}
+
+void dce_rpc_add(Dce_Rpc_Prof *prof, Dce_Phase phase, uint32_t ticks)
+{
+    prof->phase[phase] += ticks;
+    prof->nested += ticks;
+}
+
+void dce_rpc_end(Dce_Rpc_Prof *prof)
+{
+    Rpc_Totals    *t;
+    uint32_t       total;
+    Int            i;
+    UInt           key;
+
+    dce_rpc_phase(prof, DCE_PHASE_OTHER);
+    total = prof->mark - prof->start;
+
+    if( prof->call >= DCE_STATS_RPCS ) {
+        return;
+    }
+
+    /* the callback server runs along the dce-server */
+    t = &rpcs[prof->call];
+    key = Task_disable();
+    t->total += total;
+    for( i = 0; i < DCE_STATS_PHASES; i++ ) {
+        t->phase[i] += prof->phase[i];
+    }
+    hist_add(&t->hist, total);
+    Task_restore(key);
+
+    if( prof->codec && (prof->call == DCE_RPC_CODEC_PROCESS)) {
+        dce_latency_phases(prof->codec, prof->phase);
+    }
+
+    if( dce_rpc_trace ) {
+        dce_btrace_log("rpc %d codec 0x%x lock %u cache %u power %u codec %u callback %u other %u us",
+                       8, prof->call, (uint32_t)prof->codec,
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_LOCK]),
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_CACHE]),
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_POWER]),
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_CODEC]),
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_CALLBACK]),
+                       (uint32_t)kpi_ts_to_us(prof->phase[DCE_PHASE_OTHER]));
+    }
+}
+
+int dce_rpc_totals(Dce_Stats_Rpc *stats, int max)
+{
+    Rpc_Totals    *t;
+    Int            n, i;
+    UInt           key;
+
+    if( max > DCE_STATS_RPCS ) {
+        max = DCE_STATS_RPCS;
+    }
+
+    for( n = 0; n < max; n++ ) {
+        t = &rpcs[n];
+        key = Task_disable();
+        stats[n].total_us = (uint32_t)kpi_ts_to_us(t->total);
+        for( i = 0; i < DCE_STATS_PHASES; i++ ) {
+            stats[n].phase_us[i] = (uint32_t)kpi_ts_to_us(t->phase[i]);
+        }
+        Task_restore(key);
+
+        /* a call accounted meanwhile only makes the figures a bit off */
+        stats[n].calls = t->hist.count;
+        stats[n].max_us = (uint32_t)kpi_ts_to_us(t->hist.max);
+        stats[n].p50_us = (uint32_t)kpi_ts_to_us(hist_percentile(&t->hist, 50));
+        stats[n].p99_us = (uint32_t)kpi_ts_to_us(hist_percentile(&t->hist, 99));
+    }
+
+    return (n);
+}
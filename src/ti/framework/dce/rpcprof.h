@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __RPCPROF_H__
+#define __RPCPROF_H__
+
+#include <stdint.h>
+
+#include "dce_stats.h"
+
+/* Phases of the RPCs served.
+ *
+ * A handler starts the accounting of its call with dce_rpc_begin() and
+ * then marks the end of each phase as it goes: the time since the previous
+ * mark goes to the phase named.  A wait nested within a phase (a process
+ * call yielding the IVA-HD, or a codec blocked on a row mode callback) is
+ * added to its own phase with dce_rpc_add(), and taken out of the phase it
+ * is nested in.  dce_rpc_end() puts what is left in DCE_PHASE_OTHER and
+ * accounts the call, per RPC and for process calls per instance, see
+ * rpcs[] and codecs[] of the statistics page.
+ *
+ * With dce_rpc_trace set, each call is also logged in the binary trace
+ * (see osal/btrace.h), whether the TRACE macros go there or not.
+ */
+
+typedef enum {
+    DCE_PHASE_LOCK = DCE_STATS_PHASE_LOCK,
+    DCE_PHASE_CACHE = DCE_STATS_PHASE_CACHE,
+    DCE_PHASE_POWER = DCE_STATS_PHASE_POWER,
+    DCE_PHASE_CODEC = DCE_STATS_PHASE_CODEC,
+    DCE_PHASE_CALLBACK = DCE_STATS_PHASE_CALLBACK,
+    DCE_PHASE_OTHER = DCE_STATS_PHASE_OTHER
+} Dce_Phase;
+
+/* On the handler stack, times in Timestamp counts */
+typedef struct Dce_Rpc_Prof {
+    uint32_t    call;           /* rpcs[] index */
+    void       *codec;          /* or NULL */
+    uint32_t    start;
+    uint32_t    mark;
+    uint32_t    nested;         /* added since the mark */
+    uint32_t    phase[DCE_STATS_PHASES];
+} Dce_Rpc_Prof;
+
+extern uint32_t    dce_rpc_trace;
+
+void dce_rpc_begin(Dce_Rpc_Prof *prof, uint32_t call, void *codec);
+void dce_rpc_phase(Dce_Rpc_Prof *prof, Dce_Phase phase);
+void dce_rpc_add(Dce_Rpc_Prof *prof, Dce_Phase phase, uint32_t ticks);
+void dce_rpc_end(Dce_Rpc_Prof *prof);
+
+/* Cumulative figures of the RPCs, in us, for the statistics page.  Returns
+ * the number of entries filled in.
+ */
+int dce_rpc_totals(Dce_Stats_Rpc *rpcs, int max);
+
+#endif /* __RPCPROF_H__ */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Live statistics page, see dce_stats.h for the layout.
+ *
+ * A low priority task gathers the figures every dce_stats_period_ms, all
+ * of them from counters kept up to date elsewhere, nothing is walked but
+ * short lists.  While the period is 0 the task sleeps on a semaphore, so
+ * that it does not keep the IPU out of idle.  The host patches the period
+ * in, which dce_stats_kick() notices on the next RPC or load report.
+ */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Cache.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/utils/Load.h>
+
+#include <ti/utils/profile.h>
+#include <ti/utils/timebase.h>
+#include <platform/ti/dce/baselib/dce_heap.h>
+
+#include "dce_priv.h"
+#include "dce_stats.h"
+#include "rpcprof.h"
+
+/* Refresh period of the page, in ms.  0 stops the updates, which is the
+ * default so that the IPU is not woken up with no one reading.
+ */
+uint32_t    dce_stats_period_ms = 0;
+
+/* mapped by the resource table carveout */
+static Dce_Stats_Page * const    page = (Dce_Stats_Page *)DCE_STATS_DA;
+
+static kpi_context    contexts[DCE_STATS_MAX_CTX];
+
+static Semaphore_Handle    stats_sem;
+static volatile Bool       stats_idle = FALSE;  /* pending on stats_sem */
+
+static void stats_wb(volatile void *addr, uint32_t size)
+{
+    Cache_wb((Ptr)addr, size, Cache_Type_ALL, TRUE);
+}
+
+static void stats_cpu(Dce_Stats_Core *core, int id)
+{
+    int    i, n;
+
+    n = kpi_CPU_contexts(id, contexts, DCE_STATS_MAX_CTX);
+    for( i = 0; i < n; i++ ) {
+        core->ctx[i].handle = (uint32_t)contexts[i].handle;
+        core->ctx[i].type = contexts[i].type;
+        core->ctx[i].time_us = contexts[i].total_time;
+        core->ctx[i].switches = contexts[i].nb_switch;
+        memcpy(core->ctx[i].name, contexts[i].name, sizeof(core->ctx[i].name));
+    }
+    core->nctx = n;
+}
+
+static void stats_update(void)
+{
+    Dce_Dispatch_Stats    dispatch;
+    DceHeap_Stats         heap;
+    int                   i;
+
+    /* odd: being written */
+    page->seq++;
+    stats_wb(&page->seq, sizeof(page->seq));
+
+    page->time_us = kpi_time_us();
+    page->updates++;
+    page->cpu_load = Load_getCPULoad();
+
+    dce_dispatch_stats(&dispatch);
+    page->queue.waiting = dispatch.waiting;
+    page->queue.runs = dispatch.runs;
+    page->queue.switches = dispatch.switches;
+    page->queue.saved = dispatch.saved;
+    page->queue.expired = dispatch.expired;
+
+    for( i = 0; i < DCE_STATS_HEAPS; i++ ) {
+        dce_heap_stats(i, &heap);
+        page->heaps[i].total = heap.total;
+        page->heaps[i].used = heap.used;
+        page->heaps[i].high_water = heap.high_water;
+        page->heaps[i].alloc_count = heap.alloc_count;
+        page->heaps[i].largest_free = heap.largest_free;
+        page->heaps[i].failures = heap.failures;
+    }
+    page->nheaps = DCE_STATS_HEAPS;
+
+    page->ncodecs = dce_latency_totals(page->codecs, DCE_STATS_MAX_CODECS);
+    page->nrpcs = dce_rpc_totals(page->rpcs, DCE_STATS_RPCS);
+
+    page->flags = 0;
+    for( i = 0; i < DCE_STATS_CORES; i++ ) {
+        stats_cpu(&page->cores[i], i);
+        if( page->cores[i].nctx ) {
+            page->flags |= DCE_STATS_CPU_KPI;
+        }
+    }
+
+    /* the content has to be out before seq says it is complete */
+    stats_wb(page, sizeof(Dce_Stats_Page));
+    page->seq++;
+    stats_wb(&page->seq, sizeof(page->seq));
+}
+
+static void stats_main(UArg arg0, UArg arg1)
+{
+    memset(page, 0, sizeof(Dce_Stats_Page));
+    page->magic = DCE_STATS_MAGIC;
+    page->version = DCE_STATS_VERSION;
+    page->size = sizeof(Dce_Stats_Page);
+
+    while( TRUE ) {
+        if( dce_stats_period_ms ) {
+            stats_update();
+            Task_sleep((dce_stats_period_ms * 1000 + (Clock_tickPeriod - 1)) / Clock_tickPeriod);
+        } else {
+            stats_idle = TRUE;
+            Semaphore_pend(stats_sem, BIOS_WAIT_FOREVER);
+        }
+    }
+}
+
+void dce_stats_kick(void)
+{
+    if( stats_idle && dce_stats_period_ms ) {
+        stats_idle = FALSE;
+        Semaphore_post(stats_sem);
+    }
+}
+
+void dce_stats_init(void)
+{
+    Task_Params         params;
+    Semaphore_Params    sem_params;
+
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    stats_sem = Semaphore_create(0, &sem_params, NULL);
+    if( !stats_sem ) {
+        ERROR("could not create the statistics semaphore");
+        return;
+    }
+
+    Task_Params_init(&params);
+    params.instance->name = "dce-stats";
+    params.priority = 1;
+
+    if( !Task_create(stats_main, &params, NULL)) {
+        ERROR("could not create the statistics task");
+    }
+}
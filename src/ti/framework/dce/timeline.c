@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* IVA-HD occupancy timeline, see timeline.h for the layout */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "timeline.h"
+
+typedef struct Dce_Timeline {
+    Dce_Timeline_Hdr      hdr;
+    Dce_Timeline_Event    events[DCE_TIMELINE_SIZE];
+} Dce_Timeline;
+
+#pragma DATA_SECTION(dce_timeline_buf, ".timeline")
+Dce_Timeline    dce_timeline_buf =
+{
+    .hdr =
+    {
+        .magic = DCE_TIMELINE_MAGIC,
+        .version = DCE_TIMELINE_VERSION,
+        .size = DCE_TIMELINE_SIZE,
+        .enabled = 1,
+    },
+};
+
+/* Any context, interrupts included */
+void dce_timeline(Dce_Timeline_Type type, uint32_t id, uint32_t arg)
+{
+    Dce_Timeline_Event    *e;
+    Types_FreqHz           freq;
+    UInt                   key;
+
+    if( !dce_timeline_buf.hdr.enabled ) {
+        return;
+    }
+
+    if( !dce_timeline_buf.hdr.freq ) {
+        Timestamp_getFreq(&freq);
+        dce_timeline_buf.hdr.freq = freq.lo;
+    }
+
+    key = Hwi_disable();
+    e = &dce_timeline_buf.events[dce_timeline_buf.hdr.head++ & (DCE_TIMELINE_SIZE - 1)];
+    e->ts = Timestamp_get32();
+    e->type = type;
+    e->id = id;
+    e->arg = arg;
+    Hwi_restore(key);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __TIMELINE_H__
+#define __TIMELINE_H__
+
+#include <stdint.h>
+
+/* IVA-HD occupancy timeline.
+ *
+ * A binary ring of events placed in TRACE_BUF next to the SysMin trace
+ * (section ".timeline"), so it can be dumped from the host at any time,
+ * crash dumps included.  Its PA is printed at boot.  Recording is a few
+ * stores with interrupts off, there is no formatting on the target.
+ *
+ * Layout, all fields little endian:
+ *
+ *   Dce_Timeline_Hdr
+ *   Dce_Timeline_Event events[DCE_TIMELINE_SIZE]
+ *
+ * The event written n-th (from 0) is at events[n % DCE_TIMELINE_SIZE], the
+ * last one written is number head - 1, so the valid events are the
+ * min(head, DCE_TIMELINE_SIZE) before it.  ts is the raw 32-bit Timestamp
+ * count, at freq Hz, and wraps: it has to be unwrapped going forward from
+ * the oldest event.
+ *
+ * tools/dcetimeline turns it into a Chrome trace / Perfetto timeline, one
+ * track per id: QUEUE_ENTER..QUEUE_EXIT is the time spent waiting for
+ * the process lock, ACQUIRE..RELEASE the time holding the IVA-HD,
+ * YIELD..RESUME a process call giving way mid frame.  IVA_AWAKE..IVA_GATED
+ * go on a track of their own (id 0), OPP is a counter (arg in MHz).
+ */
+
+#define DCE_TIMELINE_MAGIC      0x4e4c5444  /* "DTLN" */
+#define DCE_TIMELINE_VERSION    1
+#define DCE_TIMELINE_SIZE       2048        /* events, power of 2 */
+
+typedef enum {
+    DCE_TL_QUEUE_ENTER = 1,     /* process call waits for its turn, arg: priority */
+    DCE_TL_QUEUE_EXIT,          /* ... got it */
+    DCE_TL_ACQUIRE,             /* IVA-HD acquired for a process call */
+    DCE_TL_RELEASE,             /* ... and released, arg: process() result */
+    DCE_TL_YIELD,               /* process call giving way mid frame */
+    DCE_TL_RESUME,              /* ... and back */
+    DCE_TL_IVA_AWAKE,           /* IVA-HD clock domain forced on */
+    DCE_TL_IVA_GATED,           /* ... back to HW_AUTO */
+    DCE_TL_OPP                  /* IVA-HD frequency change, arg: MHz */
+} Dce_Timeline_Type;
+
+typedef struct Dce_Timeline_Event {
+    uint32_t    ts;
+    uint32_t    type;           /* Dce_Timeline_Type */
+    uint32_t    id;             /* codec handle as seen by the host, or 0 */
+    uint32_t    arg;
+} Dce_Timeline_Event;
+
+typedef struct Dce_Timeline_Hdr {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    size;           /* DCE_TIMELINE_SIZE */
+    uint32_t    freq;           /* of ts, in Hz */
+    uint32_t    head;           /* events written since boot */
+    uint32_t    enabled;        /* can be cleared from the host */
+} Dce_Timeline_Hdr;
+
+void dce_timeline(Dce_Timeline_Type type, uint32_t id, uint32_t arg);
+
+#endif /* __TIMELINE_H__ */
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* Binary trace, see osal/btrace.h for the layout */
+
+#include <xdc/std.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/hal/Hwi.h>
+#ifdef  BUILD_FOR_SMP
+#include <ti/sysbios/hal/Core.h>
+#endif //BUILD_FOR_SMP
+
+#include "osal/btrace.h"
+
+/* Only the local core is kept out while a record is written, Hwi_disable()
+ * would also take the inter-core lock on SMP BIOS.
+ */
+#ifdef  BUILD_FOR_SMP
+#define local_disable()         Core_hwiDisable()
+#define local_restore(key)      Core_hwiRestore(key)
+#define local_core()            Core_getId()
+#else
+#define local_disable()         Hwi_disable()
+#define local_restore(key)      Hwi_restore(key)
+#define local_core()            0
+#endif //BUILD_FOR_SMP
+
+typedef struct Dce_BTrace {
+    Dce_BTrace_Hdr     hdr;
+    Dce_BTrace_Ring    rings[DCE_BTRACE_CORES];
+} Dce_BTrace;
+
+#pragma DATA_SECTION(dce_btrace_buf, ".btrace")
+Dce_BTrace    dce_btrace_buf =
+{
+    .hdr =
+    {
+        .magic = DCE_BTRACE_MAGIC,
+        .version = DCE_BTRACE_VERSION,
+        .size = DCE_BTRACE_SIZE,
+        .cores = DCE_BTRACE_CORES,
+    },
+};
+
+/* Set to have the TRACE macros log in dce_btrace_buf rather than format */
+uint32_t    dce_btrace = 0;
+
+void dce_btrace_vlog(const char *fmt, uint32_t nargs, va_list args)
+{
+    Dce_BTrace_Ring    *ring;
+    Dce_BTrace_Rec     *r;
+    Types_FreqHz        freq;
+    uint32_t            i;
+    UInt                key;
+
+    if( !dce_btrace_buf.hdr.freq ) {
+        Timestamp_getFreq(&freq);
+        dce_btrace_buf.hdr.freq = freq.lo;
+    }
+
+    if( nargs > DCE_BTRACE_MAX_ARGS ) {
+        nargs = DCE_BTRACE_MAX_ARGS;
+    }
+
+    /* no migration to the other core with interrupts off */
+    key = local_disable();
+    ring = &dce_btrace_buf.rings[local_core() & (DCE_BTRACE_CORES - 1)];
+    r = &ring->recs[ring->head++ & (DCE_BTRACE_SIZE - 1)];
+    r->ts = Timestamp_get32();
+    r->fmt = (uint32_t)fmt;
+    r->nargs = nargs;
+    for( i = 0; i < nargs; i++ ) {
+        r->args[i] = va_arg(args, uint32_t);
+    }
+    local_restore(key);
+}
+
+void dce_btrace_log(const char *fmt, uint32_t nargs, ...)
+{
+    va_list    args;
+
+    va_start(args, nargs);
+    dce_btrace_vlog(fmt, nargs, args);
+    va_end(args);
+}
+
+uint32_t dce_btrace_nargs(const char *fmt)
+{
+    uint32_t    nargs = 0;
+
+    while( *fmt ) {
+        if( *fmt++ != '%' ) {
+            continue;
+        }
+        if( *fmt == '%' ) {
+            fmt++;
+            continue;
+        }
+        nargs++;
+        /* '*' width or precision take one more */
+        while( *fmt && !((*fmt >= 'a' && *fmt <= 'z' && *fmt != 'l' && *fmt != 'h') ||
+                         (*fmt >= 'A' && *fmt <= 'Z' && *fmt != 'L'))) {
+            if( *fmt++ == '*' ) {
+                nargs++;
+            }
+        }
+    }
+
+    return (nargs);
+}
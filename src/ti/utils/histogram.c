@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* Log-linear histogram, see histogram.h */
+
+#include "histogram.h"
+
+/* Index of the most significant bit set, value != 0 */
+#ifdef __TI_COMPILER_VERSION__
+#define msb(value)    (31 - _norm(value))
+#else
+#define msb(value)    (31 - __builtin_clz(value))
+#endif
+
+void hist_add(histogram *h, uint32_t value)
+{
+    uint32_t    e, idx;
+
+    if( value < HIST_SUB ) {
+        idx = value;
+    } else {
+        e = msb(value);
+        idx = ((e - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+              ((value >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+    }
+
+    h->buckets[idx]++;
+    h->count++;
+    if( value > h->max ) {
+        h->max = value;
+    }
+}
+
+/* Lowest value of bucket idx */
+static uint32_t bucket_base(uint32_t idx)
+{
+    uint32_t    e;
+
+    if( idx < HIST_SUB ) {
+        return (idx);
+    }
+    e = (idx >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+    return ((HIST_SUB + (idx & (HIST_SUB - 1))) << (e - HIST_SUB_BITS));
+}
+
+uint32_t hist_percentile(const histogram *h, uint32_t pct)
+{
+    uint32_t    idx, seen = 0, rank, top;
+
+    if( !h->count ) {
+        return (0);
+    }
+
+    /* rank of the value wanted, from 1, rounded up */
+    rank = (uint32_t)(((uint64_t)h->count * pct + 99) / 100);
+    if( !rank ) {
+        rank = 1;
+    }
+
+    for( idx = 0; idx < HIST_BUCKETS; idx++ ) {
+        seen += h->buckets[idx];
+        if( seen >= rank ) {
+            break;
+        }
+    }
+
+    top = (idx + 1 < HIST_BUCKETS) ? bucket_base(idx + 1) - 1 : 0xFFFFFFFF;
+    return ((top < h->max) ? top : h->max);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __IPU_HISTOGRAM_H__
+#define __IPU_HISTOGRAM_H__
+
+#include <stdint.h>
+
+/* Fixed size log-linear histogram of 32-bit values.
+ *
+ * Each power of 2 is split in HIST_SUB linear buckets, so a value lands in
+ * a bucket at most 1/HIST_SUB of it wide: percentiles come out within 25%
+ * of the real value, whatever its range.  Adding a value is a count
+ * leading zeros and a few shifts, no division.
+ */
+
+#define HIST_SUB_BITS    2
+#define HIST_SUB         (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS     ((32 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct histogram {
+    uint32_t    count;
+    uint32_t    max;
+    uint32_t    buckets[HIST_BUCKETS];
+} histogram;
+
+void hist_add(histogram *h, uint32_t value);
+
+/* Value below which pct % of the values are, rounded up to the top of
+ * its bucket but not over the max.  0 when empty.
+ */
+uint32_t hist_percentile(const histogram *h, uint32_t pct);
+
+#endif /* __IPU_HISTOGRAM_H__ */
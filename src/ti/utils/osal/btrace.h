@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __IPU_BTRACE_H__
+#define __IPU_BTRACE_H__
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/* Binary trace.
+ *
+ * With dce_btrace set, the TRACE macros (see trace.h) do no formatting on
+ * the target: they log the address of their format string and their raw
+ * arguments into a ring per core, placed in TRACE_BUF (section ".btrace")
+ * next to the SysMin trace.  Its PA is printed at boot.  Logging is a
+ * dozen stores with the local core interrupts off, no lock is shared
+ * between the cores.
+ *
+ * Layout, all fields little endian:
+ *
+ *   Dce_BTrace_Hdr
+ *   Dce_BTrace_Ring rings[DCE_BTRACE_CORES]
+ *
+ * Within a ring, the record written n-th (from 0) is at
+ * recs[n % DCE_BTRACE_SIZE], the last one written is number head - 1.  ts
+ * is the raw 32-bit Timestamp count, at freq Hz, shared by the cores.
+ *
+ * tools/dcebtrace expands the records on the host: fmt is looked up in
+ * the loaded sections of the firmware ELF it was logged by, and formatted
+ * printf style with args[0..nargs-1], all 32-bit.  The TRACE macros log the file, line and
+ * function first, as "%s:%d:\t%s\t" of the format: %s arguments are
+ * addresses, which can be expanded the same way when they point in the
+ * image (file and function names always do), printed in hex otherwise.
+ * 64-bit and floating point arguments are not supported.
+ */
+
+#define DCE_BTRACE_MAGIC      0x52544244  /* "DBTR" */
+#define DCE_BTRACE_VERSION    1
+#define DCE_BTRACE_SIZE       512         /* records per core, power of 2 */
+#define DCE_BTRACE_CORES      2
+#define DCE_BTRACE_MAX_ARGS   13          /* file, line, function and 10 */
+
+typedef struct Dce_BTrace_Rec {
+    uint32_t    ts;
+    uint32_t    fmt;            /* address of the format string */
+    uint32_t    nargs;
+    uint32_t    args[DCE_BTRACE_MAX_ARGS];
+} Dce_BTrace_Rec;
+
+typedef struct Dce_BTrace_Ring {
+    uint32_t          head;     /* records written since boot */
+    uint32_t          pad[15];  /* keep the cores' heads apart */
+    Dce_BTrace_Rec    recs[DCE_BTRACE_SIZE];
+} Dce_BTrace_Ring;
+
+typedef struct Dce_BTrace_Hdr {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    size;           /* DCE_BTRACE_SIZE */
+    uint32_t    cores;          /* DCE_BTRACE_CORES */
+    uint32_t    freq;           /* of ts, in Hz */
+    uint32_t    pad[11];
+} Dce_BTrace_Hdr;
+
+extern uint32_t    dce_btrace;
+
+/* Number of arguments passed, up to 10.  11 to 20 do not build, as they
+ * would not fit in a record: the undeclared BTRACE_MORE_THAN_10_ARGS
+ * shows up in the error.
+ */
+#define BTRACE_NARGS(...)  BTRACE_NARGS_(0, ##__VA_ARGS__, \
+                                         BTRACE_TOO_MANY, BTRACE_TOO_MANY, BTRACE_TOO_MANY, \
+                                         BTRACE_TOO_MANY, BTRACE_TOO_MANY, BTRACE_TOO_MANY, \
+                                         BTRACE_TOO_MANY, BTRACE_TOO_MANY, BTRACE_TOO_MANY, \
+                                         BTRACE_TOO_MANY, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BTRACE_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, \
+                      _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, N, ...) N
+#define BTRACE_TOO_MANY    BTRACE_MORE_THAN_10_ARGS
+
+/* Log fmt with its nargs 32-bit arguments, from any context */
+void dce_btrace_log(const char *fmt, uint32_t nargs, ...);
+void dce_btrace_vlog(const char *fmt, uint32_t nargs, va_list args);
+
+/* Number of arguments fmt takes, for formats only known at run time */
+uint32_t dce_btrace_nargs(const char *fmt);
+
+#endif /* __IPU_BTRACE_H__ */
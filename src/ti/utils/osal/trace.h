@@ -38,6 +38,8 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "btrace.h"
+
 extern uint32_t    dce_debug;
 
 /********************* MACROS ************************/
@@ -61,9 +63,17 @@ extern uint32_t    dce_debug;
 #define VERB(FMT, ...)
 #endif
 
+/* With dce_btrace set, messages go in the binary trace and are formatted
+ * on the host, see btrace.h.
+ */
 #define MAX_DEBUG_LEVEL (4)
 #define TRACE(lvl, FMT, ...)  do { if((lvl) <= dce_debug ) { \
-                                       System_printf("%s:%d:\t%s\t" FMT "\n", __FILE__, __LINE__, __FUNCTION__, ##__VA_ARGS__); \
+                                       static const char    trace_fmt_[] = "%s:%d:\t%s\t" FMT "\n"; \
+                                       if( dce_btrace ) { \
+                                           dce_btrace_log(trace_fmt_, BTRACE_NARGS(__VA_ARGS__) + 3, __FILE__, __LINE__, __FUNCTION__, ##__VA_ARGS__); \
+                                       } else { \
+                                           System_printf(trace_fmt_, __FILE__, __LINE__, __FUNCTION__, ##__VA_ARGS__); \
+                                       } \
                                    } } while( 0 )
 
 #endif /* __IPU_TRACE_H__ */
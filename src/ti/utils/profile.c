@@ -41,10 +41,13 @@
 
 /* PSI_KPI profiler */
 #include "profile.h"
+#include "osal/btrace.h"
+#include "timebase.h"
 
 #include <string.h>
 #include <xdc/std.h>
 #include <xdc/runtime/Error.h>
+#include <xdc/runtime/Memory.h>
 #include <xdc/runtime/System.h>
 
 #include <ti/sysbios/BIOS.h>
@@ -60,14 +63,12 @@
 #include <ti/pm/IpcPower.h>
 #include <ti/ipc/remoteproc/Resource.h>
 
-#define REG_32K (0x4AE04030) //J6 and OMAP5
 #define TRACEGRP 0
 #define MAX_STRINGNAME_SIZE 255
 
 /* private function prototypes */
 void kpi_IVA_profiler_init  (void);
 void kpi_CPU_profiler_init  (void);
-void kpi_IVA_profiler_print (void);
 void kpi_CPU_profiler_print (void);
 void psi_kpi_task_test(Task_Handle prev, Task_Handle next);
 
@@ -78,10 +79,6 @@ void psi_kpi_task_test(Task_Handle prev, Task_Handle next);
  * Structure maintaining task data for Duacti CPU load
  *
  ***************************************************************/
-#define KPI_CONTEXT_TASK  0
-#define KPI_CONTEXT_SWI   1
-#define KPI_CONTEXT_HWI   2
-
 typedef struct {
     void         *handle;     /* Pointer to task handle, used to identify task */
     char          name[50];   /* Task name */
@@ -96,14 +93,13 @@ typedef struct {
  * Structure maintaining data for Ducati CPU load
  *
  ***************************************************************/
-#define CTX_DIRECT_NUM   256
 #define KPI_MAX_NB_TASKS 64
 #define KPI_MAX_NB_SWI   16
 #define KPI_MAX_NB_HWI   16
 #define MAX_NB_IT 32
 
 typedef struct {
-    unsigned long prev_t32;                       /* Store T32K value of previous task switch */
+    unsigned long prev_t32;                       /* Store time of previous task switch */
     unsigned long total_time;                     /* Total processing time */
     unsigned long kpi_time;                       /* Total instrumentation processing time */
     unsigned long kpi_count;                      /* Number of time instrumentation run */
@@ -116,8 +112,6 @@ typedef struct {
     psi_context_info swi[KPI_MAX_NB_HWI];         /* SWI info DB */
     unsigned long    nb_swi;                      /* Number of SWI in SWI info */
 
-    psi_context_info *context_cache[CTX_DIRECT_NUM]; /* pointers to tasks info DB */
-
     void   *context_stack[MAX_NB_IT];             /* to keep handles because of swi hwi */
     void * *pt_context_stack;                     /* stack pointer */
 
@@ -142,28 +136,123 @@ typedef struct {
     unsigned long ivahd_t_max_frame;
     unsigned long ivahd_t_min_frame;
     unsigned long ivahd_MHz;
-    unsigned long ivahd_MHzTime;
+    unsigned long long ivahd_MHzTime;
 
     unsigned long nb_frames;     /* Number of frames      */
 
-    unsigned long before_time;       /* T32K before codec execution */
-    unsigned long after_time;        /* T32K after codec execution */
+    unsigned long before_time;       /* time before codec execution */
+    unsigned long after_time;        /* time after codec execution */
 
-    unsigned long t32k_start;        /* T32K value at the beginning of video decode */
-    unsigned long t32k_end;          /* T32K value at the end of video decode */
-    unsigned long t32k_mpu_time;     /* T32K value at MPU side */
+    unsigned long t32k_start;        /* time at the beginning of video decode */
+    unsigned long t32k_end;          /* time at the end of video decode */
+    unsigned long t32k_mpu_time;     /* time at MPU side */
+
+    unsigned long awake;             /* IVA-HD was already awake for this frame */
+    unsigned long t_cold_tot;        /* IVA-HD tot time of frames which woke it */
+    unsigned long nb_cold;
+    unsigned long t_warm_tot;        /* IVA-HD tot time of frames which found it awake */
+    unsigned long nb_warm;
 } psi_iva_kpi;
 
+void kpi_IVA_profiler_print (psi_iva_kpi *kpi, const char *name);
+
 
 /***************************************************************
  * Globals
  ***************************************************************/
 unsigned long    kpi_control = 0;    /* instrumentation control (set with omapconf) */
 unsigned long    kpi_status  = 0;    /* instrumentation status variables */
+static int       kpi_wake_lock = 0;  /* IPU kept awake for the timebase */
 
-psi_iva_kpi     iva_kpi;             /* IVA data base */
+psi_iva_kpi     iva_kpi;             /* IVA data base, all instances */
 psi_bios_kpi    bios_kpi[2];         /* CPU data base (2 cores) */
 
+/***************************************************************
+ * Hook contexts
+ * -------------------------------------------------------------
+ * Each Task, Swi and Hwi keeps in its hook context where its
+ * entry is in the data base of each core, so that the hooks find
+ * it without searching:
+ *  - bits  0-7:  index + 1 in the data base of core 0, 0 if none
+ *  - bits  8-15: index + 1 in the data base of core 1
+ *  - bits 16-31: kpi_generation the indexes are valid for
+ * The data bases are cleared with each kpi_CPU_profiler_init(),
+ * which bumps kpi_generation.
+ *
+ ***************************************************************/
+#define KPI_HOOK_GEN_SHIFT  16
+
+static unsigned long    kpi_generation = 1;
+static Int              kpi_task_hook = -1;  /* hook set ids, -1 if not registered */
+static Int              kpi_swi_hook  = -1;
+static Int              kpi_hwi_hook  = -1;
+
+static inline psi_context_info *kpi_hook_get(Ptr hook, psi_context_info *db, unsigned long CoreId)
+{
+    unsigned long    ctx = (unsigned long)hook;
+    unsigned long    idx = (ctx >> (CoreId * 8)) & 0xff;
+
+    if(((ctx >> KPI_HOOK_GEN_SHIFT) != kpi_generation) || !idx ) {
+        return (NULL);
+    }
+
+    return (&db[idx - 1]);
+}
+
+static inline Ptr kpi_hook_set(Ptr hook, psi_context_info *db, psi_context_info *context, unsigned long CoreId)
+{
+    unsigned long    ctx = (unsigned long)hook;
+
+    if((ctx >> KPI_HOOK_GEN_SHIFT) != kpi_generation ) {
+        ctx = kpi_generation << KPI_HOOK_GEN_SHIFT;
+    }
+    ctx &= ~(0xffUL << (CoreId * 8));
+    ctx |= (unsigned long)(context - db + 1) << (CoreId * 8);
+
+    return ((Ptr)ctx);
+}
+
+void psi_kpi_task_register(Int id)
+{
+    kpi_task_hook = id;
+}
+
+void psi_kpi_swi_register(Int id)
+{
+    kpi_swi_hook = id;
+}
+
+void psi_kpi_hwi_register(Int id)
+{
+    kpi_hwi_hook = id;
+}
+
+/***************************************************************
+ * psi_component
+ * -------------------------------------------------------------
+ * Structure maintenaing data for Ducati Component traces and
+ * for the IVA-HD load and fps of each codec instance
+ *
+ ***************************************************************/
+typedef struct psi_component {
+    void *                   hComponent;
+    char                     name[50];
+    psi_iva_kpi              iva_kpi;   /* IVA data base, this instance only */
+    unsigned long            yielded;   /* when its frame last yielded */
+    unsigned long            paused;    /* time its frame spent yielded */
+    struct psi_component    *next;
+} psi_component;
+
+/***************************************************************
+ * kpi_comp_monitor
+ * -------------------------------------------------------------
+ * List of the components, as many as there are codec instances
+ *
+ ***************************************************************/
+psi_component      *kpi_comp_monitor = NULL;
+Uint32              kpi_comp_monitor_cnt=0;      /* no component yet */
+Uint32              kpi_comp_monitor_idx=0;      /* to name them */
+
 
 /***************************************************************
  * Functions
@@ -189,44 +278,19 @@ unsigned long Core_getId(void)
 
 #endif //BUILD_FOR_SMP
 
-/***************************************************************
- * get_32k
- * -------------------------------------------------------------
- * Function used to get 32k timer value
- *
- * @params: none
- *
- * @return: T32k value
- *
- ***************************************************************/
-unsigned long get_32k(void)
-{
-    Uint32 va;
-    volatile Uint32 pa = REG_32K;
-    if(!Resource_physToVirt(pa, &va)) {
-        //DEBUG("pa = 0x%x, va = 0x%x\n", pa, va);
-        return *( (volatile Uint32*)va);
-    }
-    else {
-        System_printf("Unable to read the timer value\n");
-        return 0;
-    }
-}
-
 /***************************************************************
  * get_time
  * -------------------------------------------------------------
- * Left here for test
+ * Time of all the KPI measurements
  *
  * @params: none
  *
- * @return: CTM timer value / 4096 (~100KHz)
- *          or 32K value (slower to read)
+ * @return: time in us, in the timebase selected with kpi_timebase
  *
  ***************************************************************/
 inline unsigned long get_time(void)
 {
-    return (get_32k());
+    return (kpi_time_us());
 }
 
 /***************************************************************
@@ -236,8 +300,7 @@ inline unsigned long get_time(void)
  *
  * @params: int core
  *
- * @return: CTM timer value / 4096 (~100KHz)
- *          or 32K value (slower to read)
+ * @return: time in us, in the timebase selected with kpi_timebase
  *
  * This function is equivalent to get_time().
  * it can be called when interrupts have been masked
@@ -245,7 +308,7 @@ inline unsigned long get_time(void)
  ***************************************************************/
 inline unsigned long get_time_core(int core)
 {
-    return (get_32k());
+    return (kpi_time_us());
 }
 
 /***************************************************************
@@ -304,17 +367,22 @@ void PSI_TracePrintf(Uint32 eTraceGrp, char *pcFormat, ...)
 {
     //  static TIMM_OSAL_PTR MyMutex = NULL;
     unsigned long    tstart = get_time();
-    unsigned long    key = Task_disable();
+    unsigned long    key;
     unsigned long    CoreId = Core_getId();
 
     va_list    varArgs;
 
     va_start(varArgs, pcFormat);
-    System_vprintf(pcFormat, varArgs);
+    if( dce_btrace ) {
+        /* no formatting, nor locking, to be done */
+        dce_btrace_vlog(pcFormat, dce_btrace_nargs(pcFormat), varArgs);
+    } else {
+        key = Task_disable();
+        System_vprintf(pcFormat, varArgs);
+        Task_restore(key);
+    }
     va_end(varArgs);
 
-    Task_restore(key);
-
     /* count overhead due to tracing when running (phase 1)*/
     if( kpi_status & KPI_INST_RUN ) {
         bios_kpi[CoreId].trace_time += get_time() - tstart;
@@ -359,9 +427,14 @@ void kpi_instInit(void)
 
     /* force clktrctrl to no sleep mode (fast 32k access) */
     //set_WKUPAON( 1 );
-#ifdef  USE_CTM_TIMER
-    IpcPower_wakeLock();
-#endif /*USE_CTM_TIMER*/
+
+    /* all times from now on come from the selected timebase, the fast
+     * counters may stop while sleeping */
+    kpi_time_init();
+    if( kpi_timebase != KPI_TB_32K ) {
+        IpcPower_wakeLock();
+        kpi_wake_lock = 1;
+    }
 
     /* IVA load setup */
     if( kpi_control & (KPI_END_SUMMARY | KPI_IVA_DETAILS)) {
@@ -423,9 +496,9 @@ void kpi_instDeinit(void)
     kpi_status = 0;
 
     /* Print the summarys */
-    PSI_TracePrintf(TRACEGRP, "\n<KPI> Profiler Deinit %-8lu\n", get_32k());
+    PSI_TracePrintf(TRACEGRP, "\n<KPI> Profiler Deinit %-8lu\n", get_time());
     if( iva_summary ) {
-        kpi_IVA_profiler_print();
+        kpi_IVA_profiler_print(&iva_kpi, "IVA");
     }
     if( cpu_summary ) {
         kpi_CPU_profiler_print();
@@ -433,9 +506,10 @@ void kpi_instDeinit(void)
 
     /* restore clktrctrl register */
     //set_WKUPAON( 0 );
-#ifdef  USE_CTM_TIMER
-    IpcPower_wakeUnlock();
-#endif /*USE_CTM_TIMER*/
+    if( kpi_wake_lock ) {
+        IpcPower_wakeUnlock();
+        kpi_wake_lock = 0;
+    }
 
 }
 
@@ -485,6 +559,148 @@ void psi_cpu_load_details(void)
 #endif //CPU_LOAD_DETAILS
 
 
+/***************************************************************
+ * kpi_IVA_reset
+ * -------------------------------------------------------------
+ * Clear an IVA data base
+ *
+ * @params: psi_iva_kpi *kpi
+ *
+ * @return: none
+ *
+ ***************************************************************/
+static void kpi_IVA_reset(psi_iva_kpi *kpi)
+{
+    kpi->ivahd_t_tot       = 0;       /* IVA-HD tot processing time per frame */
+    kpi->ivahd_t_max       = 0;       /* IVA-HD max processing time per frame */
+    kpi->ivahd_t_min       =~0;       /* IVA-HD min processing time per frame */
+    kpi->ivahd_t_max_frame = 0;
+    kpi->ivahd_t_min_frame = 0;
+    kpi->ivahd_MHzTime     = 0;
+
+    kpi->nb_frames     = 0;       /* Number of frames      */
+
+    kpi->before_time       = 0;
+    kpi->after_time        = 0;
+
+    kpi->t32k_start        = 0;
+    kpi->t32k_end          = 0;
+    kpi->t32k_mpu_time     = 0;
+
+    kpi->awake             = 0;
+    kpi->t_cold_tot        = 0;
+    kpi->nb_cold           = 0;
+    kpi->t_warm_tot        = 0;
+    kpi->nb_warm           = 0;
+}
+
+/***************************************************************
+ * kpi_comp_find
+ * -------------------------------------------------------------
+ * Look for a component in the monitor list.  The list is walked
+ * without a lock: DCE only adds and removes components, and runs
+ * the codecs, with its process lock held.
+ *
+ * @params: void * hComponent
+ *
+ * @return: psi_component *, NULL if not monitored
+ *
+ ***************************************************************/
+static psi_component *kpi_comp_find(void *hComponent)
+{
+    psi_component    *comp;
+
+    for( comp = kpi_comp_monitor; comp; comp = comp->next ) {
+        if( comp->hComponent == hComponent ) {
+            break;
+        }
+    }
+
+    return (comp);
+}
+
+/***************************************************************
+ * kpi_IVA_before
+ * -------------------------------------------------------------
+ * Account for a codec call starting at start in an IVA data base
+ *
+ * @params: psi_iva_kpi *kpi, unsigned long start
+ *
+ * @return: unsigned long time since the previous call started
+ *
+ ***************************************************************/
+static unsigned long kpi_IVA_before(psi_iva_kpi *kpi, unsigned long start)
+{
+    unsigned long    prev = kpi->before_time;
+
+    kpi->before_time = start;
+
+    /* record very 1st time codec is used */
+    if( !kpi->t32k_start ) {
+        kpi->t32k_start = kpi->before_time;
+        kpi->t32k_mpu_time = 0;  /* before the 1st codec call */
+    } else {
+        /* calculate the time from after codec done (kpi->after_time) until now (kpi->before_time) which is the time on MPU side */
+        kpi->t32k_mpu_time += kpi->before_time - kpi->after_time;
+    }
+
+    /* calculate delta frame time in ticks */
+    if( !kpi->nb_frames ) {
+        return (0);
+    }
+    return (start - prev);
+}
+
+/***************************************************************
+ * kpi_IVA_after
+ * -------------------------------------------------------------
+ * Account for a codec call ending at end in an IVA data base
+ *
+ * @params: psi_iva_kpi *kpi, unsigned long end,
+ *          unsigned long processing_time : IVA-HD time of the call,
+ *          unsigned long awake : IVA-HD awake when it started
+ *
+ * @return: unsigned long IVA-HD processing time of the call
+ *
+ ***************************************************************/
+static unsigned long kpi_IVA_after(psi_iva_kpi *kpi, unsigned long end,
+                                   unsigned long processing_time, unsigned long awake)
+{
+    kpi->after_time = end;
+    kpi->t32k_end   = end;
+
+    /* Total for Average */
+    kpi->ivahd_t_tot = (kpi->ivahd_t_tot + processing_time);
+
+    /* Max */
+    if( processing_time > kpi->ivahd_t_max ) {
+        kpi->ivahd_t_max       = processing_time;
+        kpi->ivahd_t_max_frame = kpi->nb_frames + 1;
+    }
+
+    /* Min */
+    if( processing_time < kpi->ivahd_t_min ) {
+        kpi->ivahd_t_min       = processing_time;
+        kpi->ivahd_t_min_frame = kpi->nb_frames + 1;
+    }
+
+    /* Split by IVA-HD power state at the start of the frame */
+    if( awake ) {
+        kpi->t_warm_tot += processing_time;
+        kpi->nb_warm++;
+    } else {
+        kpi->t_cold_tot += processing_time;
+        kpi->nb_cold++;
+    }
+
+    kpi->nb_frames++;
+
+    /* Processing time x MHz */
+    kpi->ivahd_MHzTime += ((unsigned long long)iva_kpi.ivahd_MHz * processing_time);
+
+    return (processing_time);
+}
+
 /***************************************************************
  * kpi_IVA_profiler_init
  * -------------------------------------------------------------
@@ -498,23 +714,9 @@ void psi_cpu_load_details(void)
 void kpi_IVA_profiler_init(void)
 {
 
-    PSI_TracePrintf(TRACEGRP, "<KPI> IVA Profiler Init %-8lu\n", get_32k());
+    PSI_TracePrintf(TRACEGRP, "<KPI> IVA Profiler Init %-8lu\n", get_time());
 
-    iva_kpi.ivahd_t_tot       = 0;       /* IVA-HD tot processing time per frame */
-    iva_kpi.ivahd_t_max       = 0;       /* IVA-HD max processing time per frame */
-    iva_kpi.ivahd_t_min       =~0;       /* IVA-HD min processing time per frame */
-    iva_kpi.ivahd_t_max_frame = 0;
-    iva_kpi.ivahd_t_min_frame = 0;
-    iva_kpi.ivahd_MHzTime     = 0;
-
-    iva_kpi.nb_frames     = 0;       /* Number of frames      */
-
-    iva_kpi.before_time       = 0;
-    iva_kpi.after_time        = 0;
-
-    iva_kpi.t32k_start        = 0;
-    iva_kpi.t32k_end          = 0;
-    iva_kpi.t32k_mpu_time     = 0;
+    kpi_IVA_reset(&iva_kpi);
 
 }
 
@@ -523,14 +725,15 @@ void kpi_IVA_profiler_init(void)
  * -------------------------------------------------------------
  * Function to be called before codec execution.
  *
- * @params: none
+ * @params: void * hComponent : codec instance
  *
  * @return: none
  *
  ***************************************************************/
-void kpi_before_codec(void)
+void kpi_before_codec(void *hComponent)
 {
-    unsigned long    start, prev, delta;
+    unsigned long    start, delta;
+    psi_component   *comp;
 
 #ifndef COMP_ENABLE_DUCATI_LOAD
     /* Started 1st time */
@@ -540,31 +743,23 @@ void kpi_before_codec(void)
 #endif //COMP_ENABLE_DUCATI_LOAD
 
     if( kpi_status & KPI_IVA_LOAD ) {
-        /* read the 32k timer */
-        start = get_32k();
+        /* read the time */
+        start = get_time();
 
-        prev = iva_kpi.before_time;
-        iva_kpi.before_time = start;
-
-        /* record very 1st time codec is used */
-        if( !iva_kpi.t32k_start ) {
-            iva_kpi.t32k_start = iva_kpi.before_time;
-            iva_kpi.t32k_mpu_time = 0;  /* before the 1st codec call */
-        } else {
-            /* calculate the time from after codec done (iva_kpi.after_time) until now (iva_kpi.before_time) which is the time on MPU side */
-            iva_kpi.t32k_mpu_time += iva_kpi.before_time - iva_kpi.after_time;
-        }
+        delta = kpi_IVA_before(&iva_kpi, start);
 
-        /* calculate delta frame time in ticks */
-        delta = start - prev;
-        if( !iva_kpi.nb_frames ) {
-            delta = 0;
+        comp = kpi_comp_find(hComponent);
+        if( comp ) {
+            delta = kpi_IVA_before(&comp->iva_kpi, start);
+            comp->iva_kpi.awake = iva_kpi.awake;
+            comp->paused = 0;
         }
 
 #ifdef  IVA_DETAILS
         if( kpi_status & KPI_IVA_TRACE ) {
             PSI_TracePrintf(TRACEGRP, "BEG %-7s %-4u %-8lu %d\n",
-                            "IVA", iva_kpi.nb_frames + 1, start, (delta * 100000) / 32768);
+                            comp ? comp->name : "IVA", (comp ? comp->iva_kpi.nb_frames : iva_kpi.nb_frames) + 1,
+                            start, delta / 10);
         }
 #endif /*IVA_DETAILS*/
 
@@ -584,52 +779,101 @@ void kpi_before_codec(void)
  * -------------------------------------------------------------
  * Function to be called at the end of processing.
  *
- * @params: none
+ * @params: void * hComponent : codec instance
  *
  * @return: none
  *
  ***************************************************************/
-void kpi_after_codec(void)
+void kpi_after_codec(void *hComponent)
 {
-    unsigned long    processing_time;
+    unsigned long    end, processing_time, awake;
+    psi_component   *comp;
 
     if( kpi_status & KPI_IVA_LOAD ) {
-        /* Read 32k timer */
-        iva_kpi.after_time = get_32k();
-        iva_kpi.t32k_end   = iva_kpi.after_time;
+        /* Read the time */
+        end = get_time();
+
+        /* the call may have yielded, and other calls run meanwhile: its
+         * own start and wake state are kept with the instance
+         */
+        comp = kpi_comp_find(hComponent);
+        if( comp ) {
+            processing_time = end - comp->iva_kpi.before_time - comp->paused;
+            awake = comp->iva_kpi.awake;
+            kpi_IVA_after(&comp->iva_kpi, end, processing_time, awake);
+        } else {
+            processing_time = end - iva_kpi.before_time;
+            awake = iva_kpi.awake;
+        }
 
-        /* Process IVA-HD working time */
-        processing_time = iva_kpi.after_time - iva_kpi.before_time;
+        kpi_IVA_after(&iva_kpi, end, processing_time, awake);
 
 #ifdef  IVA_DETAILS
         if( kpi_status & KPI_IVA_TRACE ) {
-            /* transform 32KHz ticks into ms */
+            /* transform us into 1/100 ms */
             PSI_TracePrintf(TRACEGRP, "END %-7s %-4u %-8lu %d\n",
-                            "IVA", iva_kpi.nb_frames + 1, iva_kpi.after_time, (processing_time * 100000) / 32768);
+                            comp ? comp->name : "IVA", comp ? comp->iva_kpi.nb_frames : iva_kpi.nb_frames,
+                            end, processing_time / 10);
         }
 #endif /*IVA_DETAILS*/
+    }
 
-        /* Total for Average */
-        iva_kpi.ivahd_t_tot = (iva_kpi.ivahd_t_tot + processing_time);
+}
 
-        /* Max */
-        if( processing_time > iva_kpi.ivahd_t_max ) {
-            iva_kpi.ivahd_t_max       = processing_time;
-            iva_kpi.ivahd_t_max_frame = iva_kpi.nb_frames + 1;
-        }
+/***************************************************************
+ * kpi_yield_codec
+ * -------------------------------------------------------------
+ * Function to be called when the codec call gives up the IVA-HD
+ * before it is done, see dce_yield().  Other calls may run until
+ * kpi_resume_codec, this is not counted in its processing time.
+ *
+ * @params: void * hComponent : codec instance
+ *
+ * @return: none
+ *
+ ***************************************************************/
+void kpi_yield_codec(void *hComponent)
+{
+    unsigned long    now;
+    psi_component   *comp;
+
+    if( kpi_status & KPI_IVA_LOAD ) {
+        now = get_time();
+        iva_kpi.after_time = now;
 
-        /* Min */
-        if( processing_time < iva_kpi.ivahd_t_min ) {
-            iva_kpi.ivahd_t_min       = processing_time;
-            iva_kpi.ivahd_t_min_frame = iva_kpi.nb_frames + 1;
+        comp = kpi_comp_find(hComponent);
+        if( comp ) {
+            comp->yielded = now;
         }
+    }
+}
 
-        iva_kpi.nb_frames++;
+/***************************************************************
+ * kpi_resume_codec
+ * -------------------------------------------------------------
+ * Function to be called when the codec call yielded by
+ * kpi_yield_codec gets the IVA-HD back.
+ *
+ * @params: void * hComponent : codec instance
+ *
+ * @return: none
+ *
+ ***************************************************************/
+void kpi_resume_codec(void *hComponent)
+{
+    unsigned long    now;
+    psi_component   *comp;
 
-        /* Processing time x MHz */
-        iva_kpi.ivahd_MHzTime += (iva_kpi.ivahd_MHz * processing_time);
-    }
+    if( kpi_status & KPI_IVA_LOAD ) {
+        now = get_time();
+        iva_kpi.t32k_mpu_time += now - iva_kpi.after_time;
+        iva_kpi.before_time = now;
 
+        comp = kpi_comp_find(hComponent);
+        if( comp ) {
+            comp->paused += now - comp->yielded;
+        }
+    }
 }
 
 /***************************************************************
@@ -651,6 +895,22 @@ void kpi_IVA_new_freq( unsigned long freq )
      }
 }
 
+/***************************************************************
+ * kpi_IVA_wake_state
+ * -------------------------------------------------------------
+ * Function to be called before kpi_before_codec, with the IVA-HD
+ * power state the frame is going to start from.
+ *
+ * @params: int awake : IVA-HD clock domain already awake
+ *
+ * @return: none
+ *
+ ***************************************************************/
+void kpi_IVA_wake_state(int awake)
+{
+    iva_kpi.awake = awake;
+}
+
 /***************************************************************
  * kpi_IVA_profiler_print
  * -------------------------------------------------------------
@@ -658,99 +918,91 @@ void kpi_IVA_new_freq( unsigned long freq )
  *
  * It is printing all results. syslink_trace_daemon must be enabled
  *
- * @params: none
+ * @params: psi_iva_kpi *kpi : all instances or a single one
+ *          const char *name : of the instance, or "IVA"
  *
  * @return: none
  *
  ***************************************************************/
-void kpi_IVA_profiler_print(void)
+void kpi_IVA_profiler_print(psi_iva_kpi *kpi, const char *name)
 {
     unsigned long    total_time, fps_x100, fps, frtick_x10, Ivatick_x10, Iva_pct, Iva_mhz;
     total_time = fps_x100 = fps = frtick_x10 = Ivatick_x10 = Iva_pct = Iva_mhz = 0;
     unsigned long    iva_frtick_x10, iva_fps_x100, iva_fps;
 
     /* Calculate the total time */
-    total_time = iva_kpi.t32k_end - iva_kpi.t32k_start;
+    total_time = kpi->t32k_end - kpi->t32k_start;
 
     if( total_time ) {
 
         /* Calculate the frame period and the framerate */
-        if( iva_kpi.nb_frames ) {
-            frtick_x10 = total_time * 10 / iva_kpi.nb_frames;
-            fps_x100 = 32768 * 1000 / frtick_x10;
+        if( kpi->nb_frames ) {
+            frtick_x10 = (unsigned long long)total_time * 10 / kpi->nb_frames;
+            fps_x100 = 1000000000 / frtick_x10;
             fps = fps_x100 / 100;
 
-            iva_frtick_x10 = iva_kpi.ivahd_t_tot * 10 / iva_kpi.nb_frames;
-            iva_fps_x100 = 32768 * 1000 / iva_frtick_x10;
+            iva_frtick_x10 = (unsigned long long)kpi->ivahd_t_tot * 10 / kpi->nb_frames;
+            iva_fps_x100 = 1000000000 / iva_frtick_x10;
             iva_fps = iva_fps_x100 / 100;
         }
 
         /* Calculate the IVA load */
-        if( iva_kpi.nb_frames ) {
-            Ivatick_x10 = (iva_kpi.ivahd_t_tot * 10 / iva_kpi.nb_frames);
+        if( kpi->nb_frames ) {
+            Ivatick_x10 = ((unsigned long long)kpi->ivahd_t_tot * 10 / kpi->nb_frames);
             Iva_pct = Ivatick_x10 * 100 / frtick_x10;
         }
 
         /* Cakculate the IVA MHz used */
-        Iva_mhz = iva_kpi.ivahd_MHzTime / total_time;
+        Iva_mhz = (unsigned long)(kpi->ivahd_MHzTime / total_time);
 
         PSI_TracePrintf(TRACEGRP, "\n");
         PSI_TracePrintf(TRACEGRP, "----------------------------------\n");
-        PSI_TracePrintf(TRACEGRP, "M4 stats:\n");
+        PSI_TracePrintf(TRACEGRP, "M4 stats (%s):\n", name);
         PSI_TracePrintf(TRACEGRP, "-------------\n");
-        PSI_TracePrintf(TRACEGRP, "                 IVA  1st beg: %lu\n", iva_kpi.t32k_start);
-        PSI_TracePrintf(TRACEGRP, "                 IVA last end: %lu\n", iva_kpi.t32k_end);
-        PSI_TracePrintf(TRACEGRP, "            Total time at MPU: %lu\n", iva_kpi.t32k_mpu_time);
-        PSI_TracePrintf(TRACEGRP, "        Total time at IVA (A): %lu\n", iva_kpi.ivahd_t_tot);
+        PSI_TracePrintf(TRACEGRP, "                 IVA  1st beg: %lu\n", kpi->t32k_start);
+        PSI_TracePrintf(TRACEGRP, "                 IVA last end: %lu\n", kpi->t32k_end);
+        PSI_TracePrintf(TRACEGRP, "            Total time at MPU: %lu\n", kpi->t32k_mpu_time);
+        PSI_TracePrintf(TRACEGRP, "        Total time at IVA (A): %lu\n", kpi->ivahd_t_tot);
         PSI_TracePrintf(TRACEGRP, "     Total (IVA+MPU) time (B): %lu\n", total_time);
-        PSI_TracePrintf(TRACEGRP, "        Number of samples (C): %lu\n", iva_kpi.nb_frames);
+        PSI_TracePrintf(TRACEGRP, "        Number of samples (C): %lu\n", kpi->nb_frames);
         PSI_TracePrintf(TRACEGRP, "  IVA period per sample (A/C): %lu\n", iva_frtick_x10 / 10);
         PSI_TracePrintf(TRACEGRP, "Total period per sample (B/C): %lu\n", frtick_x10 / 10);
         PSI_TracePrintf(TRACEGRP, "  fps based on total IVA time: %2d.%02d\n", iva_fps, iva_fps_x100 - (iva_fps * 100));
         PSI_TracePrintf(TRACEGRP, "      fps based on total time: %2d.%02d\n", fps, fps_x100 - (fps * 100));
 
         /* stat existing only if frames were processed */
-        if( iva_kpi.nb_frames ) {
+        if( kpi->nb_frames ) {
             PSI_TracePrintf(TRACEGRP, "\n");
             PSI_TracePrintf(TRACEGRP, "----------------------------------\n");
             PSI_TracePrintf(TRACEGRP, "IVA-HD processing time:\n");
             PSI_TracePrintf(TRACEGRP, "-----------------------\n");
-            PSI_TracePrintf(TRACEGRP, "  IVA average: %d\n", iva_kpi.ivahd_t_tot / iva_kpi.nb_frames);
-            PSI_TracePrintf(TRACEGRP, "      IVA max: %d frame: %d\n", iva_kpi.ivahd_t_max, iva_kpi.ivahd_t_max_frame);
-            PSI_TracePrintf(TRACEGRP, "      IVA min: %d frame: %d\n", iva_kpi.ivahd_t_min, iva_kpi.ivahd_t_min_frame);
+            PSI_TracePrintf(TRACEGRP, "  IVA average: %d\n", kpi->ivahd_t_tot / kpi->nb_frames);
+            PSI_TracePrintf(TRACEGRP, "      IVA max: %d frame: %d\n", kpi->ivahd_t_max, kpi->ivahd_t_max_frame);
+            PSI_TracePrintf(TRACEGRP, "      IVA min: %d frame: %d\n", kpi->ivahd_t_min, kpi->ivahd_t_min_frame);
             PSI_TracePrintf(TRACEGRP, "      IVA use: %d %%\n", Iva_pct);
             if (Iva_mhz) {
                 PSI_TracePrintf(TRACEGRP, "      IVA MHz: %d MHz\n\n", Iva_mhz);
             }
+
+            /* frames which had to wake IVA-HD up pay the wake-up and
+             * first MB latency on top of the processing time */
+            PSI_TracePrintf(TRACEGRP, "----------------------------------\n");
+            PSI_TracePrintf(TRACEGRP, "IVA-HD wake-up:\n");
+            PSI_TracePrintf(TRACEGRP, "-----------------------\n");
+            PSI_TracePrintf(TRACEGRP, "  frames waking IVA: %d avg: %d\n", kpi->nb_cold,
+                            kpi->nb_cold ? kpi->t_cold_tot / kpi->nb_cold : 0);
+            PSI_TracePrintf(TRACEGRP, "  frames IVA awake : %d avg: %d\n", kpi->nb_warm,
+                            kpi->nb_warm ? kpi->t_warm_tot / kpi->nb_warm : 0);
+            if( kpi->nb_cold && kpi->nb_warm ) {
+                PSI_TracePrintf(TRACEGRP, "  wake + 1st MB latency: %d\n\n",
+                                (long)(kpi->t_cold_tot / kpi->nb_cold) -
+                                (long)(kpi->t_warm_tot / kpi->nb_warm));
+            }
         }
     }
 
 }
 
-/***************************************************************
- * psi_component
- * -------------------------------------------------------------
- * Structure maintenaing data for Ducati Component traces
- *
- ***************************************************************/
-typedef struct {
-    void *         hComponent;
-    char           name[50];
-} psi_component;
-
-/* we trace up to MAX_COMPONENTS components */
-#define MAX_COMPONENTS 8
-
-/***************************************************************
- * kpi_comp_monitor
- * -------------------------------------------------------------
- * Contains up to 8 components data
- *
- ***************************************************************/
-psi_component    kpi_comp_monitor[MAX_COMPONENTS]; /* we trace up to MAX_COMPONENTS components */
-Uint32              kpi_comp_monitor_cnt=0;      /* no component yet */
-
-
 /***************************************************************
  * kpi_comp_init
  * -------------------------------------------------------------
@@ -764,7 +1016,8 @@ Uint32              kpi_comp_monitor_cnt=0;      /* no component yet */
 void kpi_comp_init(void *hComponent)
 {
 
-    Uint32            comp_cnt;
+    psi_component    *comp;
+    unsigned long     key;
 
 #ifdef  COMP_ENABLE_DUCATI_LOAD
     /* Started 1st time */
@@ -773,39 +1026,33 @@ void kpi_comp_init(void *hComponent)
     }
 #endif //COMP_ENABLE_DUCATI_LOAD
 
-    if( kpi_status & KPI_COMP_TRACE ) {
+    if( hComponent && (kpi_status & (KPI_COMP_TRACE | KPI_IVA_LOAD))) {
 
-        /* First init: clear kpi_comp_monitor components */
-        if( kpi_comp_monitor_cnt == 0 ) {
-            for( comp_cnt=0; comp_cnt < MAX_COMPONENTS; comp_cnt++ ) {
-                /*clear handler registery */
-                kpi_comp_monitor[comp_cnt].hComponent = 0;
-            }
+        comp = Memory_calloc(NULL, sizeof(psi_component), 0, NULL);
+        if( !comp ) {
+            return;
         }
 
-        /* identify the 1st component free in the table (maybe one was removed previously) */
-        for( comp_cnt=0; comp_cnt < MAX_COMPONENTS; comp_cnt++ ) {
-            if( kpi_comp_monitor[comp_cnt].hComponent == 0 ) {
-                break;
-            }
-        }
+        /* register the component handle */
+        comp->hComponent = hComponent;
+        kpi_IVA_reset(&comp->iva_kpi);
 
-        if( comp_cnt >= MAX_COMPONENTS ) {
-            return;
-        }
+        key = Task_disable();
+
+        //TBD : Need to figure out how to get component name here. Setting default to rpmsg-dce
+        System_sprintf(comp->name, "rpmsg-dce%d", kpi_comp_monitor_idx++); // Add index to the name
 
         /* current comp num and update */
         kpi_comp_monitor_cnt++;
+        comp->next = kpi_comp_monitor;
+        kpi_comp_monitor = comp;
 
-        /* register the component handle */
-        kpi_comp_monitor[comp_cnt].hComponent = hComponent;
-
+        Task_restore(key);
 
-        //TBD : Need to figure out how to get component name here. Setting default to rpmsg-dce
-        strcpy(kpi_comp_monitor[comp_cnt].name, "rpmsg-dce");
-        System_sprintf(kpi_comp_monitor[comp_cnt].name, "%s%d", kpi_comp_monitor[comp_cnt].name, comp_cnt); // Add index to the name
         /* trace component init */
-        PSI_TracePrintf(TRACEGRP, "<KPI> DCE %-8s Init %-8lu \n", kpi_comp_monitor[comp_cnt].name, get_32k());
+        if( kpi_status & KPI_COMP_TRACE ) {
+            PSI_TracePrintf(TRACEGRP, "<KPI> DCE %-8s Init %-8lu \n", comp->name, get_time());
+        }
 
     }
 
@@ -824,25 +1071,33 @@ void kpi_comp_init(void *hComponent)
 void kpi_comp_deinit(void* hComponent)
 {
 
-    Uint32    comp_cnt;
+    psi_component    **prev, *comp = NULL;
+    unsigned long      key;
 
-    if( kpi_comp_monitor_cnt > 0 ) {
-        /* identify the component from the registery */
-        for( comp_cnt=0; comp_cnt < MAX_COMPONENTS; comp_cnt++ ) {
-            if( kpi_comp_monitor[comp_cnt].hComponent == hComponent ) {
-                break;
-            }
+    /* unregister the component */
+    key = Task_disable();
+    for( prev = &kpi_comp_monitor; *prev; prev = &(*prev)->next ) {
+        if( (*prev)->hComponent == hComponent ) {
+            comp = *prev;
+            *prev = comp->next;
+            kpi_comp_monitor_cnt--;
+            break;
         }
+    }
+    Task_restore(key);
 
+    if( comp ) {
         /* trace component deinit */
-        if( comp_cnt < MAX_COMPONENTS ) {
-            PSI_TracePrintf(TRACEGRP, "<KPI> DCE %-7s Deinit %-8lu\n", kpi_comp_monitor[comp_cnt].name, get_32k());
+        if( kpi_status & KPI_COMP_TRACE ) {
+            PSI_TracePrintf(TRACEGRP, "<KPI> DCE %-7s Deinit %-8lu\n", comp->name, get_time());
+        }
 
-            /* unregister the component */
-            kpi_comp_monitor[comp_cnt].hComponent = 0;
+        /* this instance own summary */
+        if((kpi_control & KPI_END_SUMMARY) && (kpi_status & KPI_IVA_LOAD) && comp->iva_kpi.nb_frames ) {
+            kpi_IVA_profiler_print(&comp->iva_kpi, comp->name);
         }
 
-        kpi_comp_monitor_cnt--;
+        Memory_free(NULL, comp, sizeof(psi_component));
     }
 
     /* stop the instrumentation */
@@ -888,9 +1143,9 @@ unsigned long kpi_load_pct_x_100(unsigned long load, unsigned long total)
  ***************************************************************/
 void kpi_CPU_profiler_init(void)
 {
-    unsigned int    CoreId, i;
+    unsigned int    CoreId;
 
-    PSI_TracePrintf(TRACEGRP, "<KPI> CPU Profiler Init %-8lu\n", get_32k());
+    PSI_TracePrintf(TRACEGRP, "<KPI> CPU Profiler Init %-8lu\n", get_time());
 
     for( CoreId = 0; CoreId < 2; CoreId++ ) {
         psi_bios_kpi   *core_kpi = &bios_kpi[CoreId];
@@ -922,11 +1177,6 @@ void kpi_CPU_profiler_init(void)
         core_kpi->hwi[KPI_MAX_NB_HWI - 1].nb_switch  = 0;
         strcpy(core_kpi->hwi[KPI_MAX_NB_HWI - 1].name, "Other hwis");
 
-        /* clear the context pointers table */
-        for( i=0; i < CTX_DIRECT_NUM; i++ ) {
-            core_kpi->context_cache[i]= &(core_kpi->tasks[0]);  /* point to the Data Base */
-        }
-
         core_kpi->context_stack[0] = &(core_kpi->tasks[0]);     /* point to 1st context element */
         core_kpi->pt_context_stack = &(core_kpi->context_stack[0]); /* stack beginning */
 
@@ -938,6 +1188,12 @@ void kpi_CPU_profiler_init(void)
 
     }
 
+    /* forget the entries the hook contexts point to */
+    kpi_generation = (kpi_generation + 1) & 0xffff;
+    if( !kpi_generation ) {
+        kpi_generation = 1;
+    }
+
     /* set current time into prev_t32 in each data based */
     bios_kpi[0].prev_t32 = get_time();
     bios_kpi[1].prev_t32 = bios_kpi[0].prev_t32;
@@ -1082,6 +1338,51 @@ void kpi_CPU_profiler_print(void)
     }
 }
 
+/***************************************************************
+ * kpi_CPU_contexts
+ * -------------------------------------------------------------
+ * Copy the contexts of the CPU load data base of a core, with
+ * the time spent in each of them so far (live, nothing is
+ * reconstructed as for kpi_CPU_profiler_print)
+ *
+ * @params: int core, kpi_context *ctx, int max
+ *
+ * @return: number of contexts copied, 0 if the CPU load is not
+ *          being measured
+ *
+ ***************************************************************/
+int kpi_CPU_contexts(int core, kpi_context *ctx, int max)
+{
+    psi_bios_kpi       *core_kpi = &bios_kpi[core];
+    psi_context_info   *db[3];
+    unsigned long       nb[3], type, i;
+    int                 n = 0;
+
+    if( !(kpi_status & KPI_CPU_LOAD)) {
+        return (0);
+    }
+
+    db[KPI_CONTEXT_TASK] = core_kpi->tasks;
+    nb[KPI_CONTEXT_TASK] = core_kpi->nb_tasks;
+    db[KPI_CONTEXT_SWI] = core_kpi->swi;
+    nb[KPI_CONTEXT_SWI] = core_kpi->nb_swi;
+    db[KPI_CONTEXT_HWI] = core_kpi->hwi;
+    nb[KPI_CONTEXT_HWI] = core_kpi->nb_hwi;
+
+    for( type = KPI_CONTEXT_TASK; type <= KPI_CONTEXT_HWI; type++ ) {
+        for( i = 0; (i < nb[type]) && (n < max); i++, n++ ) {
+            ctx[n].handle = db[type][i].handle;
+            ctx[n].type = type;
+            ctx[n].total_time = db[type][i].total_time;
+            ctx[n].nb_switch = db[type][i].nb_switch;
+            strncpy(ctx[n].name, db[type][i].name, sizeof(ctx[n].name) - 1);
+            ctx[n].name[sizeof(ctx[n].name) - 1] = 0;
+        }
+    }
+
+    return (n);
+}
+
 /***************************************************************
  * psi_kpi_search_create_context_task
  * -------------------------------------------------------------
@@ -1285,17 +1586,19 @@ void psi_kpi_task_switch(Task_Handle prev, Task_Handle next)
         unsigned long       tick   = get_time_core(CoreId);
         psi_bios_kpi       *core_kpi = &bios_kpi[CoreId];
         psi_context_info   *context_next, *context;
-        unsigned long       cachePtr;
+        Ptr                 hook;
 
         /* Ending context */
         context = (psi_context_info *) *core_kpi->pt_context_stack;
 
         /* Starting context */
-        cachePtr= ((((long) next) >> 4) ^ (((long) next) >> 12)) & 0xff; /* build a simple 8 bits address for trying cache DB search */
-        context_next = core_kpi->context_cache[ cachePtr ];
-        if( context_next->handle != next ) {                      /* if NOT pointing to our handle make exhaustive seartch */
+        hook = (kpi_task_hook < 0) ? NULL : Task_getHookContext(next, kpi_task_hook);
+        context_next = kpi_hook_get(hook, core_kpi->tasks, CoreId);
+        if( !context_next ) {                                     /* first time on this core: search or create it */
             context_next = psi_kpi_search_create_context_task(next, core_kpi);
-            core_kpi->context_cache[ cachePtr ] = context_next;   /* update direct table (this may evict one already here) */
+            if( kpi_task_hook >= 0 ) {
+                Task_setHookContext(next, kpi_task_hook, kpi_hook_set(hook, core_kpi->tasks, context_next, CoreId));
+            }
         }
 
         /* Maintain stack for interrupts: save context starting */
@@ -1338,17 +1641,19 @@ void psi_kpi_swi_begin(Swi_Handle swi)
         unsigned long       tick   = get_time_core(CoreId);
         psi_bios_kpi       *core_kpi = &bios_kpi[CoreId];
         psi_context_info   *context_next, *context;
-        unsigned long       cachePtr;
+        Ptr                 hook;
 
         /* Ending context */
         context = (psi_context_info *) *core_kpi->pt_context_stack++; /* Going from a TASK or SWI to new SWI */
 
         /* Starting context */
-        cachePtr= ((((long) swi) >> 4) ^ (((long) swi) >> 12)) & 0xff; /* build a simple 8 bits address for trying cache DB search */
-        context_next = core_kpi->context_cache[ cachePtr ];
-        if( context_next->handle != swi ) {                       /* if NOT pointing to our handle make exhaustive seartch */
+        hook = (kpi_swi_hook < 0) ? NULL : Swi_getHookContext(swi, kpi_swi_hook);
+        context_next = kpi_hook_get(hook, core_kpi->swi, CoreId);
+        if( !context_next ) {                                     /* first time on this core: search or create it */
             context_next = psi_kpi_search_create_context_swi(swi, core_kpi);
-            core_kpi->context_cache[ cachePtr ] = context_next;   /* update direct table (this may evict one already here) */
+            if( kpi_swi_hook >= 0 ) {
+                Swi_setHookContext(swi, kpi_swi_hook, kpi_hook_set(hook, core_kpi->swi, context_next, CoreId));
+            }
         }
 
         /* Maintain stack for interrupts: save context starting */
@@ -1431,17 +1736,19 @@ void psi_kpi_hwi_begin(Hwi_Handle hwi)
         unsigned long       tick   = get_time_core(CoreId);
         psi_bios_kpi       *core_kpi = &bios_kpi[CoreId];
         psi_context_info   *context_next, *context;
-        unsigned long       cachePtr;
+        Ptr                 hook;
 
         /* Ending context */
         context = (psi_context_info *) *core_kpi->pt_context_stack++; /* Going from previous TASK or SWI to a HWI */
 
         /* Starting context */
-        cachePtr= ((((long) hwi) >> 4) ^ (((long) hwi) >> 12)) & 0xff; /* build a simple 8 bits address for trying cache DB search */
-        context_next = core_kpi->context_cache[ cachePtr ];
-        if( context_next->handle != hwi ) {                       /* if NOT pointing to our handle make exhaustive seartch */
+        hook = (kpi_hwi_hook < 0) ? NULL : Hwi_getHookContext(hwi, kpi_hwi_hook);
+        context_next = kpi_hook_get(hook, core_kpi->hwi, CoreId);
+        if( !context_next ) {                                     /* first time on this core: search or create it */
             context_next = psi_kpi_search_create_context_hwi(hwi, core_kpi);
-            core_kpi->context_cache[ cachePtr ] = context_next;   /* update direct table (this may evict one already here) */
+            if( kpi_hwi_hook >= 0 ) {
+                Hwi_setHookContext(hwi, kpi_hwi_hook, kpi_hook_set(hook, core_kpi->hwi, context_next, CoreId));
+            }
         }
 
         /* Maintain stack for interrupts: save context starting */
@@ -1525,14 +1832,16 @@ void psi_kpi_task_test(Task_Handle prev, Task_Handle next)
     unsigned long       tick   = get_time_core(CoreId);
     psi_bios_kpi       *core_kpi = &bios_kpi[CoreId];
     psi_context_info   *context_next;
-    unsigned long       cachePtr;
+    Ptr                 hook;
 
     /* Starting context */
-    cachePtr= ((((long) next) >> 4) ^ (((long) next) >> 12)) & 0xff; /* build a simple 8 bits address for trying cache DB search */
-    context_next = core_kpi->context_cache[ cachePtr ];
-    if( context_next->handle != next ) {                           /* if NOT pointing to our handle make exhaustive seartch */
+    hook = (kpi_task_hook < 0) ? NULL : Task_getHookContext(next, kpi_task_hook);
+    context_next = kpi_hook_get(hook, core_kpi->tasks, CoreId);
+    if( !context_next ) {                                         /* first time on this core: search or create it */
         context_next = psi_kpi_search_create_context_task(next, core_kpi);
-        core_kpi->context_cache[ cachePtr ] = context_next;       /* update direct table (this may evict one already here) */
+        if( kpi_task_hook >= 0 ) {
+            Task_setHookContext(next, kpi_task_hook, kpi_hook_set(hook, core_kpi->tasks, context_next, CoreId));
+        }
     }
 
     /* Maintain stack for interrupts: save context starting */
@@ -56,7 +56,7 @@
 //#define CINIT_ENABLE_DUCATI_LOAD  /* measure starts when codec is created */
 #define COMP_ENABLE_DUCATI_LOAD  /* measure starts when the first COMP component is created */
 
-//#define USE_CTM_TIMER           /* CTM vs 32K for measuring CPU load */
+/* times come from the timebase selected with kpi_timebase, see timebase.h */
 #define INST_COST               /* measure the instrumentation cost during the test */
 //#define COST_AFTER            /* allows estimating the instrumentation cost after completion */
 
@@ -79,16 +79,36 @@ typedef enum {
     KPI_IVA_USED  = (1 << 6)     /* IVA used in the test */
 } KPI_inst_status;
 
+extern unsigned long kpi_control;
+
+#define KPI_CONTEXT_TASK  0
+#define KPI_CONTEXT_SWI   1
+#define KPI_CONTEXT_HWI   2
+
+/* A context of the CPU load data base, see kpi_CPU_contexts() */
+typedef struct {
+    void          *handle;
+    unsigned long  type;        /* KPI_CONTEXT_xxx */
+    unsigned long  total_time;  /* time spent in it, in us */
+    unsigned long  nb_switch;   /* times it got activated */
+    char           name[16];
+} kpi_context;
+
 /* function protypes */
 extern void kpi_instInit        (void);
 extern void kpi_instDeinit      (void);
-extern void kpi_before_codec    (void);
-extern void kpi_after_codec     (void);
+extern void kpi_before_codec    (void* hComponent);
+extern void kpi_after_codec     (void* hComponent);
+extern void kpi_yield_codec     (void* hComponent);
+extern void kpi_resume_codec    (void* hComponent);
 extern void kpi_IVA_new_freq    (unsigned long freq);
+extern void kpi_IVA_wake_state  (int awake);
 
 extern void kpi_comp_init   (void* hComponent);
 extern void kpi_comp_deinit (void* hComponent);
 
+extern int  kpi_CPU_contexts(int core, kpi_context *ctx, int max);
+
 /* use disableCoreInts in SMP: faster and appropriate for us, otherwise is disable (non SMP) */
 #ifndef BUILD_FOR_SMP
 #define  Core_hwiDisable() Hwi_disable()
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Sampling profiler, see sampler.h for the layout */
+
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/family/arm/m3/Hwi.h>
+#ifdef  BUILD_FOR_SMP
+#include <ti/sysbios/hal/Core.h>
+#endif //BUILD_FOR_SMP
+
+#include "sampler.h"
+
+#ifdef  BUILD_FOR_SMP
+#define local_core()            Core_getId()
+#else
+#define local_core()            0
+#endif //BUILD_FOR_SMP
+
+/* SysTick, private to each core */
+#define SYST_CSR                (*(volatile uint32_t *)0xE000E010)
+#define SYST_RVR                (*(volatile uint32_t *)0xE000E014)
+#define SYST_CVR                (*(volatile uint32_t *)0xE000E018)
+#define SYST_CSR_ENABLE         (1 << 0)
+#define SYST_CSR_TICKINT        (1 << 1)
+#define SYST_CSR_CLKSOURCE      (1 << 2)    /* core clock */
+#define SYST_RELOAD_MAX         0x00FFFFFF
+#define SYSTICK_INT             15
+
+/* EXC_RETURN bit set when returning to thread mode (a task) */
+#define EXC_RETURN_THREAD       (1 << 3)
+
+typedef struct Kpi_Sampler {
+    Kpi_Sampler_Hdr     hdr;
+    Kpi_Sampler_Ring    rings[KPI_SAMPLER_CORES];
+} Kpi_Sampler;
+
+#pragma DATA_SECTION(kpi_sampler_buf, ".sampler")
+Kpi_Sampler    kpi_sampler_buf =
+{
+    .hdr =
+    {
+        .magic = KPI_SAMPLER_MAGIC,
+        .version = KPI_SAMPLER_VERSION,
+        .size = KPI_SAMPLER_SIZE,
+        .cores = KPI_SAMPLER_CORES,
+        .names = KPI_SAMPLER_NAMES,
+    },
+};
+
+uint32_t    kpi_sampler_hz = 0;
+
+static uint32_t    armed_hz[KPI_SAMPLER_CORES];    /* SysTick rate set */
+static uint32_t    named[KPI_SAMPLER_CORES];       /* samples looked at */
+
+/* sampler_isr.asm */
+extern void kpi_sampler_isr(void);
+
+/* Called by kpi_sampler_isr() with the frame stacked on the interrupt
+ * (r0-r3, r12, lr, pc, xpsr) and the EXC_RETURN value.  No BIOS call but
+ * reads here, this runs above the BIOS interrupt masking.
+ */
+void kpi_sampler_record(const uint32_t *frame, uint32_t exc_return)
+{
+    Kpi_Sampler_Ring    *ring = &kpi_sampler_buf.rings[local_core() & (KPI_SAMPLER_CORES - 1)];
+    Kpi_Sample          *s = &ring->samples[ring->head & (KPI_SAMPLER_SIZE - 1)];
+
+    s->pc = frame[6];
+    s->lr = frame[5];
+    s->task = (uint32_t)Task_self();
+    s->flags = (exc_return & EXC_RETURN_THREAD) ? 0 : KPI_SAMPLE_HANDLER;
+
+    /* only once the sample is complete */
+    ring->head++;
+}
+
+static void sampler_arm(uint32_t hz)
+{
+    Types_FreqHz    freq;
+    uint32_t        reload;
+
+    SYST_CSR = 0;
+    if( !hz ) {
+        return;
+    }
+
+    BIOS_getCpuFreq(&freq);
+    reload = freq.lo / hz;
+    if( reload > SYST_RELOAD_MAX + 1 ) {
+        reload = SYST_RELOAD_MAX + 1;
+    }
+    kpi_sampler_buf.hdr.hz = freq.lo / reload;
+
+    Hwi_plug(SYSTICK_INT, (Void *)kpi_sampler_isr);
+    Hwi_setPriority(SYSTICK_INT, 0);
+
+    SYST_RVR = reload - 1;
+    SYST_CVR = 0;
+    SYST_CSR = SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE;
+}
+
+/* Record the names of the tasks seen in the new samples of core */
+static void sampler_names(uint32_t core)
+{
+    Kpi_Sampler_Ring    *ring = &kpi_sampler_buf.rings[core];
+    uint32_t             head = ring->head;
+    uint32_t             i, j, task;
+    String               name;
+
+    if( head - named[core] > KPI_SAMPLER_SIZE ) {
+        named[core] = head - KPI_SAMPLER_SIZE;
+    }
+
+    for( i = named[core]; i != head; i++ ) {
+        task = ring->samples[i & (KPI_SAMPLER_SIZE - 1)].task;
+        for( j = 0; j < KPI_SAMPLER_NAMES; j++ ) {
+            if( ring->names[j].task == task ) {
+                break;
+            }
+            if( !ring->names[j].task ) {
+                name = Task_Handle_name((Task_Handle)task);
+                strncpy(ring->names[j].name, name ? name : "",
+                        sizeof(ring->names[j].name) - 1);
+                ring->names[j].task = task;
+                break;
+            }
+        }
+    }
+
+    named[core] = head;
+}
+
+void kpi_sampler_idle(void)
+{
+    uint32_t    core = local_core() & (KPI_SAMPLER_CORES - 1);
+    uint32_t    hz = kpi_sampler_hz;
+
+    /* the SysTick settings do not survive the core being powered down */
+    if((hz != armed_hz[core]) || (hz && !(SYST_CSR & SYST_CSR_ENABLE))) {
+        sampler_arm(hz);
+        armed_hz[core] = hz;
+    }
+
+    if( hz ) {
+        sampler_names(core);
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __IPU_SAMPLER_H__
+#define __IPU_SAMPLER_H__
+
+#include <stdint.h>
+
+/* Sampling profiler.
+ *
+ * A statistical alternative to the PSI hooks of profile.c: with
+ * kpi_sampler_hz set, the SysTick of each core interrupts it at that rate,
+ * and the interrupted PC and LR are logged with the running task into a
+ * ring per core, placed in TRACE_BUF (section ".sampler").  Its PA is
+ * printed at boot.  Nothing runs on context switches, the cost is one
+ * short interrupt per sample.
+ *
+ * The SysTick interrupt is plugged directly in the vector table at the
+ * highest priority (zero latency, see sampler_isr.asm), so code running
+ * with interrupts disabled gets sampled too.  The SysTicks are started and
+ * stopped from each core's idle loop, once kpi_sampler_hz changes.  Pick
+ * a rate which is not a multiple of the Clock tick, e.g. 997 Hz, not to
+ * sample the same phase of periodic work.  A sleeping core does not
+ * sample, and is woken up at that rate.
+ *
+ * Layout, all fields little endian:
+ *
+ *   Kpi_Sampler_Hdr
+ *   Kpi_Sampler_Ring rings[KPI_SAMPLER_CORES]
+ *
+ * Within a ring, the sample taken n-th (from 0) is at
+ * samples[n % KPI_SAMPLER_SIZE], the last one is number head - 1.  names[]
+ * gives the name of the tasks seen in the samples, filled in from the idle
+ * loop when the Task instances are named (empty otherwise).
+ *
+ * pc is where the core got interrupted, lr is only reliable as the caller
+ * while pc is in a leaf function.  Both are to be looked up in the symbols
+ * of the firmware ELF (tools/dcesample).
+ */
+
+#define KPI_SAMPLER_MAGIC       0x504d5344  /* "DSMP" */
+#define KPI_SAMPLER_VERSION     1
+#define KPI_SAMPLER_SIZE        2048        /* samples per core, power of 2 */
+#define KPI_SAMPLER_CORES       2
+#define KPI_SAMPLER_NAMES       32          /* task names per core */
+
+/* flags */
+#define KPI_SAMPLE_HANDLER      (1 << 0)    /* in a Hwi or Swi, task preempted */
+
+typedef struct Kpi_Sample {
+    uint32_t    pc;
+    uint32_t    lr;
+    uint32_t    task;           /* Task_Handle */
+    uint32_t    flags;
+} Kpi_Sample;
+
+typedef struct Kpi_Sampler_Name {
+    uint32_t    task;
+    char        name[28];
+} Kpi_Sampler_Name;
+
+typedef struct Kpi_Sampler_Ring {
+    uint32_t            head;       /* samples taken since boot */
+    uint32_t            pad[15];
+    Kpi_Sampler_Name    names[KPI_SAMPLER_NAMES];
+    Kpi_Sample          samples[KPI_SAMPLER_SIZE];
+} Kpi_Sampler_Ring;
+
+typedef struct Kpi_Sampler_Hdr {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    size;           /* KPI_SAMPLER_SIZE */
+    uint32_t    cores;          /* KPI_SAMPLER_CORES */
+    uint32_t    names;          /* KPI_SAMPLER_NAMES */
+    uint32_t    hz;             /* rate the samples were taken at */
+    uint32_t    pad[10];
+} Kpi_Sampler_Hdr;
+
+/* Sampling rate in Hz, 0 (default) stops sampling */
+extern uint32_t    kpi_sampler_hz;
+
+/* Idle function of each core (see the cfg) */
+void kpi_sampler_idle(void);
+
+#endif /* __IPU_SAMPLER_H__ */
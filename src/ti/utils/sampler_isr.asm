@@ -0,0 +1,57 @@
+;
+; Copyright (c) 2011, Texas Instruments Incorporated
+; All rights reserved.
+;
+; Redistribution and use in source and binary forms, with or without
+; modification, are permitted provided that the following conditions
+; are met:
+;
+; *  Redistributions of source code must retain the above copyright
+;    notice, this list of conditions and the following disclaimer.
+;
+; *  Redistributions in binary form must reproduce the above copyright
+;    notice, this list of conditions and the following disclaimer in the
+;    documentation and/or other materials provided with the distribution.
+;
+; *  Neither the name of Texas Instruments Incorporated nor the names of
+;    its contributors may be used to endorse or promote products derived
+;    from this software without specific prior written permission.
+;
+; THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+; AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+; THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+; PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+; CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+; EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+; PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+; WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+; OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+; EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+;
+
+;
+; Entry of the sampling profiler interrupt, see sampler.h.
+;
+; Plugged in the vector table (not dispatched by BIOS): hands the frame
+; stacked by the interrupt and the EXC_RETURN value over to
+; kpi_sampler_record(), which returns from the interrupt.
+;
+
+        .thumb
+
+        .global kpi_sampler_isr
+        .global kpi_sampler_record
+
+        .text
+
+kpi_sampler_isr: .asmfunc
+        mov     r1, lr              ; EXC_RETURN
+        tst     r1, #4              ; frame on the process or main stack
+        ite     eq
+        mrseq   r0, msp
+        mrsne   r0, psp
+        b       kpi_sampler_record
+        .endasmfunc
+
+        .end
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+/* KPI timebase, see timebase.h */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <xdc/runtime/Timestamp.h>
+#include <xdc/runtime/Types.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/hal/Hwi.h>
+#ifdef  BUILD_FOR_SMP
+#include <ti/sysbios/hal/Core.h>
+#endif //BUILD_FOR_SMP
+#include <ti/ipc/remoteproc/Resource.h>
+
+#include "profile.h"
+#include "timebase.h"
+
+#define REG_32K (0x4AE04030) //J6 and OMAP5
+
+/* Cortex-M4 debug registers (private peripheral bus) */
+#define DEMCR           (*(volatile Uint32 *)0xE000EDFC)
+#define DEMCR_TRCENA    (1 << 24)
+#define DWT_CTRL        (*(volatile Uint32 *)0xE0001000)
+#define DWT_CYCCNTENA   (1 << 0)
+#define DWT_CYCCNT      (*(volatile Uint32 *)0xE0001004)
+
+/* us per 32 kHz tick, in Q32: 1000000 / 32768 = 15625 / 512 */
+#define US_PER_32K_Q32  ((uint64_t)15625 << 23)
+
+#ifdef  BUILD_FOR_SMP
+#define TB_CORES        2
+#define tb_core()       Core_getId()
+#else
+#define TB_CORES        1
+#define tb_core()       0
+#endif //BUILD_FOR_SMP
+
+typedef struct {
+    uint32_t    last_raw;       /* fast counter at the last read */
+    uint64_t    now_q32;        /* us at the last read, Q32 */
+    uint32_t    sync_raw;       /* fast counter at the last calibration */
+    uint32_t    sync_32k;       /* 32 kHz timer at the last calibration */
+    uint64_t    sync_q32;       /* us at the last calibration, Q32 */
+    uint32_t    ticks_per_s;    /* fast counter ticks in a second */
+    uint64_t    us_per_tick;    /* Q32 */
+} kpi_tb_core;
+
+unsigned long    kpi_timebase = KPI_TB_TIMESTAMP;
+
+static KPI_timebase    timebase = KPI_TB_32K;   /* the one in use */
+static uint32_t        tb_freq;                 /* its nominal frequency */
+static uint32_t        ts_freq;                 /* Timestamp frequency */
+static kpi_tb_core     tb[TB_CORES];
+
+/***************************************************************
+ * get_32k
+ * -------------------------------------------------------------
+ * Function used to get 32k timer value
+ *
+ * @params: none
+ *
+ * @return: T32k value
+ *
+ ***************************************************************/
+unsigned long get_32k(void)
+{
+    Uint32 va;
+    volatile Uint32 pa = REG_32K;
+    if(!Resource_physToVirt(pa, &va)) {
+        //DEBUG("pa = 0x%x, va = 0x%x\n", pa, va);
+        return *( (volatile Uint32*)va);
+    }
+    else {
+        System_printf("Unable to read the timer value\n");
+        return 0;
+    }
+}
+
+static inline uint32_t read_raw(void)
+{
+    switch( timebase ) {
+        case KPI_TB_TIMESTAMP :
+            return (Timestamp_get32());
+        case KPI_TB_DWT :
+            return (DWT_CYCCNT);
+        default :
+            return (get_32k());
+    }
+}
+
+/* Start the calibration of the calling core over */
+static void tb_core_init(kpi_tb_core *c)
+{
+    c->ticks_per_s = tb_freq;
+    c->us_per_tick = ((uint64_t)1000000 << 32) / tb_freq;
+    c->sync_32k = get_32k();
+    c->last_raw = c->sync_raw = read_raw();
+    c->now_q32 = c->sync_q32 = (uint64_t)c->sync_32k * US_PER_32K_Q32;
+}
+
+/***************************************************************
+ * kpi_time_init
+ * -------------------------------------------------------------
+ * Select the timebase from kpi_timebase and start counting
+ *
+ * @params: none
+ *
+ * @return: none
+ *
+ ***************************************************************/
+void kpi_time_init(void)
+{
+    Types_FreqHz    freq;
+    unsigned long   key;
+    int             i;
+
+    timebase = (KPI_timebase)kpi_timebase;
+
+    switch( timebase ) {
+        case KPI_TB_TIMESTAMP :
+            Timestamp_getFreq(&freq);
+            break;
+        case KPI_TB_DWT :
+            DEMCR |= DEMCR_TRCENA;
+            DWT_CTRL |= DWT_CYCCNTENA;
+            BIOS_getCpuFreq(&freq);
+            break;
+        default :
+            timebase = KPI_TB_32K;
+            freq.lo = 32768;
+            break;
+    }
+
+    /* each core starts on its 1st read, the DWT counters are per core */
+    key = Core_hwiDisable();
+    tb_freq = freq.lo;
+    for( i = 0; i < TB_CORES; i++ ) {
+        tb[i].ticks_per_s = 0;
+    }
+    Core_hwiRestore(key);
+}
+
+/***************************************************************
+ * kpi_ts_to_us
+ * -------------------------------------------------------------
+ * Convert BIOS Timestamp counts to us
+ *
+ * @params: uint64_t counts : Timestamp_get32() delta, or a sum of them
+ *
+ * @return: time in us
+ *
+ ***************************************************************/
+uint64_t kpi_ts_to_us(uint64_t counts)
+{
+    Types_FreqHz    freq;
+
+    if( !ts_freq ) {
+        Timestamp_getFreq(&freq);
+        ts_freq = freq.lo ? freq.lo : 1;
+    }
+
+    /* split so that counts * 1000000 cannot overflow */
+    return ((counts / ts_freq) * 1000000 + ((counts % ts_freq) * 1000000) / ts_freq);
+}
+
+/***************************************************************
+ * kpi_time_us
+ * -------------------------------------------------------------
+ * Current time in the KPI timebase
+ *
+ * @params: none
+ *
+ * @return: time in us
+ *
+ ***************************************************************/
+unsigned long kpi_time_us(void)
+{
+    kpi_tb_core     *c;
+    unsigned long    key;
+    uint32_t         raw, delta, t32k, elapsed;
+    uint64_t         now;
+
+    if( timebase == KPI_TB_32K ) {
+        return ((unsigned long)(((uint64_t)get_32k() * US_PER_32K_Q32) >> 32));
+    }
+
+    key = Core_hwiDisable();
+    c = &tb[tb_core() % TB_CORES];
+    if( !c->ticks_per_s ) {
+        tb_core_init(c);
+    }
+    raw = read_raw();
+    delta = raw - c->last_raw;
+    c->last_raw = raw;
+
+    if((delta < c->ticks_per_s) && ((raw - c->sync_raw) < c->ticks_per_s)) {
+        c->now_q32 += (uint64_t)delta * c->us_per_tick;
+    } else {
+        /* a second since the calibration, or the counter wrapped, was
+         * reset or stopped: take the time from the 32 kHz timer, and
+         * recalibrate if the counter agrees with it within 1/8
+         */
+        t32k = get_32k();
+        elapsed = t32k - c->sync_32k;
+        now = c->sync_q32 + (uint64_t)elapsed * US_PER_32K_Q32;
+        delta = raw - c->sync_raw;
+        if( elapsed && delta ) {
+            uint64_t    expected = ((uint64_t)elapsed * c->ticks_per_s) >> 15;
+
+            if((delta > expected - (expected >> 3)) && (delta < expected + (expected >> 3))) {
+                c->ticks_per_s = (uint32_t)(((uint64_t)delta << 15) / elapsed);
+                c->us_per_tick = (now - c->sync_q32) / delta;
+            }
+        }
+        /* never go backward (us wrap on 32 bits) */
+        if((int64_t)(now - c->now_q32) > 0 ) {
+            c->now_q32 = now;
+        }
+        c->sync_raw = raw;
+        c->sync_32k = t32k;
+        c->sync_q32 = c->now_q32;
+    }
+
+    now = c->now_q32;
+    Core_hwiRestore(key);
+
+    return ((unsigned long)(now >> 32));
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __IPU_TIMEBASE_H__
+#define __IPU_TIMEBASE_H__
+
+#include <stdint.h>
+
+/* Timebase of the KPI measurements.
+ *
+ * Times are returned in us, on 32 bits (wraps after 71 minutes), from a
+ * fast counter selected with kpi_timebase when the instrumentation starts:
+ *
+ *   KPI_TB_32K        the 32 kHz sync timer, ~30 us resolution, slow to
+ *                     read (L4 access), but never stops
+ *   KPI_TB_TIMESTAMP  the BIOS Timestamp provider of the cfg (the CTM on
+ *                     ducati, or a dmtimer), shared by both cores
+ *   KPI_TB_DWT        the M4 DWT cycle counter, cheapest to read but one
+ *                     per core
+ *
+ * The fast counters are converted with a factor calibrated against the
+ * 32 kHz timer at least once a second of counting, which also makes up
+ * for the counter wrapping or stopping in between.  Calibration is kept
+ * per core.  As they may stop while the core sleeps, the IPU is kept awake
+ * while the instrumentation runs with one of them.
+ *
+ * This only covers the PSI_KPI times (profile.c).  The DCE profilers take
+ * raw Timestamp_get32() counts instead, which are cheaper to read and
+ * need no calibration over the short intervals they measure:
+ *
+ *   latency.c, rpcprof.c, lockprof.c  sums and histograms in counts, made
+ *                     us with kpi_ts_to_us() when read
+ *   iresman_hdvicp_prio.c             HDVICP wait times, in counts, summed
+ *                     up by latency.c
+ *   timeline.c, btrace.c              counts in each record, the Timestamp
+ *                     frequency in the buffer header for the host decoder
+ */
+
+typedef enum {
+    KPI_TB_32K = 0,
+    KPI_TB_TIMESTAMP,
+    KPI_TB_DWT
+} KPI_timebase;
+
+extern unsigned long    kpi_timebase;   /* KPI_timebase, patchable */
+
+/* Start counting with kpi_timebase */
+void kpi_time_init(void);
+
+/* Current time in us */
+unsigned long kpi_time_us(void);
+
+/* 32 kHz sync timer */
+unsigned long get_32k(void);
+
+/* BIOS Timestamp counts to us.  Not tied to kpi_timebase: for the times
+ * the DCE profilers take with Timestamp_get32(), whatever the Timestamp
+ * frequency (19.2 MHz or below 1 MHz included).
+ */
+uint64_t kpi_ts_to_us(uint64_t counts);
+
+#endif /* __IPU_TIMEBASE_H__ */
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Host test of the IVA-HD DVFS governor policy (dce/ivahd_gov.c).
+ *
+ * Frames are fed to the governor the way ivahd_dvfs_begin()/end() do,
+ * with times in us, and the OPP it selects is checked.
+ *
+ * Build and run it on the host with, e.g.:
+ *
+ *   gcc -O2 -Wall -I src/ti/framework/dce -o ivahd_gov_test \
+ *       test/ivahd_gov_test.c src/ti/framework/dce/ivahd_gov.c
+ *   ./ivahd_gov_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ivahd_gov.h"
+
+/* as in ivahd.c: OPP50 and OPP100 */
+static const uint32_t    opp_mhz[] = { 133, 266 };
+
+#define HEADROOM        20
+#define DOWN_FRAMES     30
+#define PERIOD_30FPS    33333
+
+static int    failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond)) { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while( 0 )
+
+static void gov_init(ivahd_gov *gov)
+{
+    ivahd_gov_init(gov, opp_mhz, 2, HEADROOM, DOWN_FRAMES);
+}
+
+/* n frames of stream id every period us from *now, busy us each, with
+ * the OPP selected before each of them.  Returns the last OPP.
+ */
+static int run(ivahd_gov *gov, void *id, uint32_t *now, int n,
+               uint32_t period, uint32_t busy)
+{
+    int    opp = gov->cur;
+
+    while( n-- ) {
+        opp = ivahd_gov_select(gov, *now);
+        ivahd_gov_frame(gov, id, *now, busy);
+        *now += period;
+    }
+
+    return (opp);
+}
+
+static void test_init(void)
+{
+    ivahd_gov    gov;
+
+    gov_init(&gov);
+    CHECK(gov.nopps == 2);
+    CHECK(gov.cur == 1);
+
+    /* nothing running asks for nothing */
+    CHECK(ivahd_gov_demand(&gov, 0) == 0);
+}
+
+/* a stream not characterized yet keeps the highest OPP */
+static void test_new_stream(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000;
+
+    gov_init(&gov);
+    run(&gov, (void *)1, &now, 2, PERIOD_30FPS, 1000);
+    CHECK(ivahd_gov_demand(&gov, now) == 0xffffffff);
+    CHECK(ivahd_gov_select(&gov, now) == 1);
+}
+
+/* a light stream goes down to OPP50, but only after DOWN_FRAMES */
+static void test_down(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000;
+    uint32_t     demand;
+
+    gov_init(&gov);
+    run(&gov, (void *)1, &now, 3, PERIOD_30FPS, 5000);
+
+    /* 5 ms at 266 MHz per 33.3 ms period, plus 20% */
+    demand = ivahd_gov_demand(&gov, now);
+    CHECK(demand == (5000 * 266 / PERIOD_30FPS) * (100 + HEADROOM) / 100);
+
+    CHECK(run(&gov, (void *)1, &now, DOWN_FRAMES - 1, PERIOD_30FPS, 5000) == 1);
+    CHECK(run(&gov, (void *)1, &now, 1, PERIOD_30FPS, 5000) == 0);
+}
+
+/* the work is kept in cycles: running twice as long at half the MHz is
+ * the same demand, so the governor stays down
+ */
+static void test_cycles(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000;
+
+    gov_init(&gov);
+    run(&gov, (void *)1, &now, 3 + DOWN_FRAMES, PERIOD_30FPS, 5000);
+    CHECK(gov.cur == 0);
+    CHECK(run(&gov, (void *)1, &now, 100, PERIOD_30FPS, 10000) == 0);
+}
+
+/* a second, heavy stream takes it back up at once */
+static void test_up(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000, i;
+
+    gov_init(&gov);
+    run(&gov, (void *)1, &now, 3 + DOWN_FRAMES, PERIOD_30FPS, 5000);
+    CHECK(gov.cur == 0);
+
+    /* a new stream is not characterized yet */
+    ivahd_gov_frame(&gov, (void *)2, now, 20000);
+    CHECK(ivahd_gov_select(&gov, now) == 1);
+
+    /* once it is, the two of them need more than OPP50 */
+    for( i = 0; i < 10; i++ ) {
+        ivahd_gov_frame(&gov, (void *)1, now, 5000);
+        ivahd_gov_frame(&gov, (void *)2, now, 16000);
+        now += PERIOD_30FPS;
+        CHECK(ivahd_gov_select(&gov, now) == 1);
+    }
+    CHECK(ivahd_gov_demand(&gov, now) > opp_mhz[0]);
+}
+
+/* deleted or paused streams stop counting */
+static void test_remove_stale(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000;
+
+    gov_init(&gov);
+    run(&gov, (void *)2, &now, 10, PERIOD_30FPS, 30000);
+    CHECK(ivahd_gov_demand(&gov, now) > opp_mhz[1]);
+
+    ivahd_gov_remove(&gov, (void *)2);
+    CHECK(ivahd_gov_demand(&gov, now) == 0);
+
+    run(&gov, (void *)3, &now, 10, PERIOD_30FPS, 30000);
+    CHECK(ivahd_gov_demand(&gov, now) > opp_mhz[1]);
+
+    /* not heard of for more than 4 periods */
+    now += 5 * PERIOD_30FPS;
+    CHECK(ivahd_gov_demand(&gov, now) == 0);
+
+    /* demand is computed across the 32-bit us wrap */
+    gov_init(&gov);
+    now = 0xffffffff - 5 * PERIOD_30FPS;
+    run(&gov, (void *)4, &now, 10, PERIOD_30FPS, 5000);
+    CHECK(ivahd_gov_demand(&gov, now) < opp_mhz[0]);
+}
+
+/* no more streams than there is room for, the others are not tracked */
+static void test_full(void)
+{
+    ivahd_gov    gov;
+    uint32_t     now = 1000;
+    uintptr_t    id;
+
+    gov_init(&gov);
+    for( id = 1; id <= IVAHD_GOV_MAX_STREAMS + 1; id++ ) {
+        ivahd_gov_frame(&gov, (void *)id, now, 1000);
+    }
+    for( id = 0; id < IVAHD_GOV_MAX_STREAMS; id++ ) {
+        CHECK(gov.streams[id].id == (void *)(id + 1));
+    }
+}
+
+int main(void)
+{
+    test_init();
+    test_new_stream();
+    test_down();
+    test_cycles();
+    test_up();
+    test_remove_stale();
+    test_full();
+
+    if( failures ) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return (1);
+    }
+
+    printf("ivahd_gov: all tests passed\n");
+    return (0);
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Host test of the TILER container allocator (baselib/tiler_container.c).
+ *
+ * The allocator is plain C, the test runs it against a stand-in of the
+ * DMM PAT: pat_refill() fills the PAT entries of an area the way
+ * dmm_refill() of iresman_tiledmemory.c does, one descriptor per
+ * rectangle of tiler_area_rects(), with consecutive pages.  Every slot
+ * handed out must be refilled exactly once, and never twice while in use.
+ *
+ * Build and run it on the host with, e.g.:
+ *
+ *   gcc -O2 -Wall -I platform/ti/dce/baselib -o tiler_container_test \
+ *       test/tiler_container_test.c platform/ti/dce/baselib/tiler_container.c
+ *   ./tiler_container_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiler_container.h"
+
+#define NO_PAGE    0xffffffff
+
+/* PAT stand-in: page backing each slot */
+static uint32_t    pat[TILER_CONTAINER_HEIGHT][TILER_CONTAINER_WIDTH];
+
+static int    failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond)) { \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while( 0 )
+
+static void pat_clear(void)
+{
+    memset(pat, 0xff, sizeof(pat));
+}
+
+/* Fill the PAT entries of area with pages from first on, as dmm_refill()
+ * does.  Returns the number of pages used, or -1 if an entry was taken.
+ */
+static int pat_refill(tiler_fmt fmt, const tiler_area *area, uint32_t first)
+{
+    tiler_area    rect[3];
+    uint32_t      page = first;
+    int           i, x, y, nrect;
+
+    nrect = tiler_area_rects(fmt, area, rect);
+
+    for( i = 0; i < nrect; i++ ) {
+        for( y = rect[i].y0; y <= rect[i].y1; y++ ) {
+            for( x = rect[i].x0; x <= rect[i].x1; x++ ) {
+                if( pat[y][x] != NO_PAGE ) {
+                    return (-1);
+                }
+                pat[y][x] = page++;
+            }
+        }
+    }
+
+    return (page - first);
+}
+
+/* Give the PAT entries of area back, as dmm_refill() with the dummy page */
+static void pat_release(tiler_fmt fmt, const tiler_area *area)
+{
+    tiler_area    rect[3];
+    int           i, x, y, nrect;
+
+    nrect = tiler_area_rects(fmt, area, rect);
+
+    for( i = 0; i < nrect; i++ ) {
+        for( y = rect[i].y0; y <= rect[i].y1; y++ ) {
+            for( x = rect[i].x0; x <= rect[i].x1; x++ ) {
+                pat[y][x] = NO_PAGE;
+            }
+        }
+    }
+}
+
+static int in_window(const tiler_container *tc, int x, int y)
+{
+    return ((x >= tc->win_x0) && (x <= tc->win_x1) &&
+            (y >= tc->win_y0) && (y <= tc->win_y1));
+}
+
+/* All the slots of a 2D area are in the window */
+static int area_in_window(const tiler_container *tc, const tiler_area *area)
+{
+    return (in_window(tc, area->x0, area->y0) && in_window(tc, area->x1, area->y1));
+}
+
+static void test_window(void)
+{
+    tiler_container    tc;
+
+    CHECK(tiler_container_init(&tc, 0, 96, 255, 127) == 0);
+    CHECK(tiler_container_init(&tc, -1, 0, 10, 10) < 0);
+    CHECK(tiler_container_init(&tc, 10, 0, 9, 10) < 0);
+    CHECK(tiler_container_init(&tc, 0, 0, TILER_CONTAINER_WIDTH, 10) < 0);
+    CHECK(tiler_container_init(&tc, 0, 0, 10, TILER_CONTAINER_HEIGHT) < 0);
+}
+
+/* 1080p NV12 buffers, as the decoders ask for them */
+static void test_2d(void)
+{
+    tiler_container    tc;
+    tiler_area         luma[8], chroma[8];
+    uint32_t           page = 0;
+    int                i, n, nluma, ret;
+
+    pat_clear();
+    tiler_container_init(&tc, 0, 96, 255, 127);
+
+    for( n = 0, nluma = 0; n < 8; n++ ) {
+        if( tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 1920, 1088, 0, &luma[n]) < 0 ) {
+            break;
+        }
+        nluma++;
+        CHECK(area_in_window(&tc, &luma[n]));
+        CHECK(tiler_area_slots(TILER_FMT_8BIT, &luma[n]) == 30 * 17);
+        ret = pat_refill(TILER_FMT_8BIT, &luma[n], page);
+        CHECK(ret == 30 * 17);
+        page += ret;
+
+        if( tiler_container_reserve_2d(&tc, TILER_FMT_16BIT, 960, 544, 0, &chroma[n]) < 0 ) {
+            break;
+        }
+        CHECK(area_in_window(&tc, &chroma[n]));
+        CHECK(tiler_area_slots(TILER_FMT_16BIT, &chroma[n]) == 15 * 17);
+        ret = pat_refill(TILER_FMT_16BIT, &chroma[n], page);
+        CHECK(ret == 15 * 17);
+        page += ret;
+    }
+
+    /* the 256x32 window takes 5 pairs side by side, and the luma of a
+     * 6th in the 31 slot columns left
+     */
+    CHECK(n == 5);
+    CHECK(nluma == 6);
+    CHECK(tc.slots_used == page);
+
+    /* a freed area is handed out again, at the same place (first fit) */
+    pat_release(TILER_FMT_8BIT, &luma[2]);
+    tiler_container_release(&tc, TILER_FMT_8BIT, &luma[2]);
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 1920, 1088, 0, &luma[7]) == 0);
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 1920, 1088, 0, &luma[6]) < 0);
+    CHECK(!memcmp(&luma[7], &luma[2], sizeof(tiler_area)));
+    CHECK(pat_refill(TILER_FMT_8BIT, &luma[7], page) == 30 * 17);
+
+    /* and taking everything back leaves the container empty */
+    for( i = 0; i < nluma; i++ ) {
+        tiler_container_release(&tc, TILER_FMT_8BIT, (i == 2) ? &luma[7] : &luma[i]);
+    }
+    for( i = 0; i < n; i++ ) {
+        tiler_container_release(&tc, TILER_FMT_16BIT, &chroma[i]);
+    }
+    CHECK(tc.slots_used == 0);
+}
+
+static void test_2d_align(void)
+{
+    tiler_container    tc;
+    tiler_area         a, b;
+
+    tiler_container_init(&tc, 3, 96, 255, 127);
+
+    /* 4KB aligned in 8-bit mode: 64 slot columns */
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 64, 64, 4096, &a) == 0);
+    CHECK(a.x0 == 64);
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 64, 64, 4096, &b) == 0);
+    CHECK(b.x0 == 128 && b.y0 == 96);
+    CHECK((tiler_area_offset(TILER_FMT_8BIT, &b) & ((1 << TILER_ACC_MODE_SHIFT) - 1)) % 4096 == 0);
+    CHECK(tiler_area_offset(TILER_FMT_8BIT, &b) >> TILER_ACC_MODE_SHIFT == TILER_FMT_8BIT);
+
+    /* wider than the window */
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 64 * 254, 64, 0, &a) < 0);
+    CHECK(tiler_container_reserve_2d(&tc, TILER_FMT_PAGE, 64, 64, 0, &a) < 0);
+}
+
+static void test_1d(void)
+{
+    tiler_container    tc;
+    tiler_area         a, b, rect[3];
+    uint32_t           page = 0;
+    int                ret;
+
+    pat_clear();
+
+    /* full width window: runs may wrap to the next row */
+    tiler_container_init(&tc, 0, 96, 255, 127);
+
+    CHECK(tiler_container_reserve_1d(&tc, 100 * TILER_SLOT_SIZE, &a) == 0);
+    CHECK(a.x0 == 0 && a.y0 == 96 && a.x1 == 99 && a.y1 == 96);
+    page += pat_refill(TILER_FMT_PAGE, &a, page);
+
+    /* 600 slots from 100: rest of the row, 1 full row, part of another */
+    CHECK(tiler_container_reserve_1d(&tc, 600 * TILER_SLOT_SIZE - 1, &b) == 0);
+    CHECK(tiler_area_slots(TILER_FMT_PAGE, &b) == 600);
+    CHECK(tiler_area_rects(TILER_FMT_PAGE, &b, rect) == 3);
+    CHECK(rect[0].x0 == 100 && rect[0].x1 == 255);
+    CHECK(rect[1].y0 == 97 && rect[1].y1 == 97);
+    CHECK(rect[2].x1 == b.x1 && rect[2].y1 == 98);
+    ret = pat_refill(TILER_FMT_PAGE, &b, page);
+    CHECK(ret == 600);
+
+    CHECK(tiler_area_offset(TILER_FMT_PAGE, &b) ==
+          (((96 * TILER_CONTAINER_WIDTH + 100) * TILER_SLOT_SIZE) |
+           (TILER_FMT_PAGE << TILER_ACC_MODE_SHIFT)));
+
+    tiler_container_release(&tc, TILER_FMT_PAGE, &a);
+    tiler_container_release(&tc, TILER_FMT_PAGE, &b);
+    CHECK(tc.slots_used == 0);
+    CHECK(tiler_container_reserve_1d(&tc, 0, &a) < 0);
+
+    /* partial width window: a run has to fit in a row */
+    tiler_container_init(&tc, 16, 96, 79, 127);
+    CHECK(tiler_container_reserve_1d(&tc, 65 * TILER_SLOT_SIZE, &a) < 0);
+    CHECK(tiler_container_reserve_1d(&tc, 40 * TILER_SLOT_SIZE, &a) == 0);
+    CHECK(tiler_container_reserve_1d(&tc, 40 * TILER_SLOT_SIZE, &b) == 0);
+    CHECK(a.y0 == a.y1 && b.y0 == b.y1 && b.y0 == a.y0 + 1);
+    CHECK(b.x0 == 16);
+}
+
+/* 2D and page mode areas share the window without overlapping */
+static void test_mixed(void)
+{
+    tiler_container    tc;
+    tiler_area         a;
+    uint32_t           page = 0;
+    int                ret, n2d = 0, n1d = 0;
+
+    pat_clear();
+    tiler_container_init(&tc, 0, 96, 255, 127);
+
+    for( ;; ) {
+        if( tiler_container_reserve_2d(&tc, TILER_FMT_8BIT, 720, 576, 0, &a) == 0 ) {
+            ret = pat_refill(TILER_FMT_8BIT, &a, page);
+            CHECK(ret > 0);
+            page += ret;
+            n2d++;
+        } else {
+            break;
+        }
+        if( tiler_container_reserve_1d(&tc, 300 * 1024, &a) == 0 ) {
+            ret = pat_refill(TILER_FMT_PAGE, &a, page);
+            CHECK(ret > 0);
+            page += ret;
+            n1d++;
+        }
+    }
+
+    CHECK(n2d > 0 && n1d > 0);
+    CHECK(tc.slots_used == page);
+}
+
+int main(void)
+{
+    test_window();
+    test_2d();
+    test_2d_align();
+    test_1d();
+    test_mixed();
+
+    if( failures ) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return (1);
+    }
+
+    printf("tiler_container: all tests passed\n");
+    return (0);
+}
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2011, Texas Instruments Incorporated
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# *  Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#
+# *  Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# *  Neither the name of Texas Instruments Incorporated nor the names of
+#    its contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""dcebtrace: expand the IPU binary trace into text.
+
+The records (see src/ti/utils/osal/btrace.h) are read from /dev/mem at the
+PA printed by the firmware at boot ("Binary trace PA"), or from a raw dump
+of the buffer.  Their format strings, and their %s arguments pointing in
+the image, are looked up in the loaded sections of the firmware ELF (the
+.xem4 the IPU runs), which has to be the very one that logged them:
+
+    dcebtrace.py --pa 0x9f0xxxxx --elf dce_ipu.xem4
+
+Records of both cores are merged in time order, each line starting with
+the core and the time in seconds since the oldest record:
+
+    core0    0.001234  dce.c:1890:	codec_process	DEBUG: >> codec=...
+
+The Timestamp counts are 32 bits, so the records are expected to span less
+than half their wrap time (about 110 s at 19.2 MHz).
+"""
+
+import argparse
+import mmap
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x52544244
+VERSION = 1
+HDR_SIZE = 64
+RING_HDR_SIZE = 64
+MAX_ARGS = 13
+REC_SIZE = 12 + 4 * MAX_ARGS
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+# printf conversion: flags, width, precision, length, conversion
+CONV = re.compile(r'%([-+ #0]*)(\*|\d*)(?:\.(\*|\d*))?(hh|h|ll|l|L|z|j|t)?([a-zA-Z%])')
+
+
+class Image(object):
+    """Loaded sections of a 32-bit little endian ELF, by address"""
+
+    def __init__(self, elf):
+        with open(elf, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF' or data[4] != 1 or data[5] != 1:
+            sys.exit('%s: not a 32-bit little endian ELF' % elf)
+        shoff, = struct.unpack_from('<I', data, 32)
+        shentsize, shnum = struct.unpack_from('<2H', data, 46)
+        self.sections = []
+        for i in range(shnum):
+            _, type, flags, addr, offset, size = \
+                struct.unpack_from('<6I', data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and type != SHT_NOBITS and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, contents in self.sections:
+            if base <= addr < base + len(contents):
+                end = contents.find(b'\0', addr - base)
+                if end < 0:
+                    end = len(contents)
+                return contents[addr - base:end].decode('ascii', 'replace')
+        return None
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def expand(image, fmt, args):
+    """printf of fmt with the 32-bit args"""
+    out = []
+    pos = 0
+    args = list(args)
+
+    def arg():
+        return args.pop(0) if args else 0
+
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        if width == '*':
+            width = str(signed(arg()))
+        spec = '%' + flags + width
+        if prec is not None:
+            if prec == '*':
+                prec = str(max(signed(arg()), 0))
+            spec += '.' + prec
+        value = arg()
+        if conv == 's':
+            s = image.string(value)
+            out.append((spec + 's') % (s if s is not None else '0x%08x' % value))
+        elif conv in 'di':
+            out.append((spec + 'd') % signed(value))
+        elif conv in 'uxXo':
+            out.append((spec + conv) % value)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xff))
+        elif conv == 'p':
+            out.append((spec + 's') % ('0x%08x' % value))
+        else:
+            out.append(m.group(0))
+    out.append(fmt[pos:])
+
+    return ''.join(out)
+
+
+def read_buffer(args):
+    if args.dump:
+        with open(args.dump, 'rb') as f:
+            return f.read()
+
+    fd = os.open('/dev/mem', os.O_RDONLY | os.O_SYNC)
+    page = args.pa & ~(mmap.PAGESIZE - 1)
+    offset = args.pa - page
+    mem = mmap.mmap(fd, offset + HDR_SIZE, mmap.MAP_SHARED, mmap.PROT_READ,
+                    offset=page)
+    size, cores = struct.unpack_from('<2I', mem, offset + 8)
+    length = offset + HDR_SIZE + cores * (RING_HDR_SIZE + size * REC_SIZE)
+    mem = mmap.mmap(fd, length, mmap.MAP_SHARED, mmap.PROT_READ, offset=page)
+    os.close(fd)
+    return mem[offset:]
+
+
+def records(data):
+    """Valid records of all the cores, as (core, ts, fmt, args), freq, and
+    the ts of the newest record of the first core which has any"""
+    magic, version, size, cores, freq = struct.unpack_from('<5I', data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('no binary trace buffer version %d found' % VERSION)
+
+    recs = []
+    newest = None
+    for core in range(cores):
+        base = HDR_SIZE + core * (RING_HDR_SIZE + size * REC_SIZE)
+        head, = struct.unpack_from('<I', data, base)
+        for n in range(max(head - size, 0), head):
+            off = base + RING_HDR_SIZE + (n % size) * REC_SIZE
+            ts, fmt, nargs = struct.unpack_from('<3I', data, off)
+            nargs = min(nargs, MAX_ARGS)
+            recs.append((core, ts, fmt,
+                         struct.unpack_from('<%dI' % nargs, data, off + 12)))
+        if head and newest is None:
+            newest = ts
+
+    return recs, freq, newest
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--pa', type=lambda x: int(x, 0),
+                     help='physical address of the binary trace buffer')
+    src.add_argument('--dump', help='raw dump of the binary trace buffer')
+    parser.add_argument('--elf', required=True, help='firmware ELF')
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    recs, freq, newest = records(read_buffer(args))
+    if not recs:
+        return
+
+    # relative to a recent record, then to the oldest one
+    recs = [(signed((ts - newest) & 0xffffffff), core, fmt, a)
+            for core, ts, fmt, a in recs]
+    recs.sort(key=lambda r: r[0])
+    first = recs[0][0]
+
+    for ticks, core, fmt, a in recs:
+        text = image.string(fmt)
+        if text is None:
+            text = '<format 0x%08x not in the ELF> %s' % (
+                fmt, ' '.join('0x%08x' % x for x in a))
+        else:
+            text = expand(image, text, a).rstrip('\n')
+        print('core%d %11.6f  %s' % (core, (ticks - first) / float(freq or 1),
+                                     text))
+
+
+if __name__ == '__main__':
+    main()
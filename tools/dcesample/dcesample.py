@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2011, Texas Instruments Incorporated
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# *  Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#
+# *  Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# *  Neither the name of Texas Instruments Incorporated nor the names of
+#    its contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""dcesample: turn the IPU sampling profiler rings into flamegraph input.
+
+The samples (see src/ti/utils/sampler.h) are read from /dev/mem at the PA
+printed by the firmware at boot ("Sampler PA"), or from a raw dump of the
+buffer.  Their PC, and optionally their LR as the caller, are looked up in
+the symbols of the firmware ELF (the .xem4 the IPU runs), and printed as
+folded stacks, one line per stack with its count:
+
+    core0;dce-server;viddec3_process;H264VDEC_TI_decode 42
+
+ready for flamegraph.pl.  With --seconds, the rings are polled for that
+long and only the new samples are counted, otherwise the samples the
+rings hold are.
+
+    dcesample.py --pa 0x9f0xxxxx --elf dce_ipu.xem4 --seconds 10 > out.folded
+    flamegraph.pl out.folded > ipu.svg
+"""
+
+import argparse
+import bisect
+import mmap
+import os
+import struct
+import subprocess
+import sys
+import time
+
+MAGIC = 0x504d5344
+VERSION = 1
+HDR_SIZE = 64
+RING_HDR_SIZE = 64
+NAME_SIZE = 32
+SAMPLE_SIZE = 16
+SAMPLE_HANDLER = 1 << 0
+
+
+class Symbols(object):
+    def __init__(self, elf, nm):
+        out = subprocess.check_output([nm, '-n', '--defined-only', elf],
+                                      universal_newlines=True)
+        self.addrs = []
+        self.names = []
+        for line in out.splitlines():
+            fields = line.split()
+            if len(fields) != 3 or fields[1] not in 'tTwW':
+                continue
+            # thumb functions have bit 0 set
+            self.addrs.append(int(fields[0], 16) & ~1)
+            self.names.append(fields[2])
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr & ~1) - 1
+        if i < 0:
+            return '0x%08x' % addr
+        return self.names[i]
+
+
+class Buffer(object):
+    def __init__(self, args):
+        if args.dump:
+            with open(args.dump, 'rb') as f:
+                self.data = f.read()
+            self.mem = None
+        else:
+            fd = os.open('/dev/mem', os.O_RDONLY | os.O_SYNC)
+            page = args.pa & ~(mmap.PAGESIZE - 1)
+            self.offset = args.pa - page
+            self.mem = mmap.mmap(fd, self.offset + HDR_SIZE, mmap.MAP_SHARED,
+                                 mmap.PROT_READ, offset=page)
+            hdr = self.mem[self.offset:self.offset + HDR_SIZE]
+            size, cores, names = struct.unpack_from('<3I', hdr, 8)
+            length = self.offset + HDR_SIZE + cores * ring_size(size, names)
+            self.mem = mmap.mmap(fd, length, mmap.MAP_SHARED,
+                                 mmap.PROT_READ, offset=page)
+            os.close(fd)
+
+    def read(self):
+        if self.mem is None:
+            return self.data
+        return self.mem[self.offset:]
+
+
+def ring_size(size, names):
+    return RING_HDR_SIZE + names * NAME_SIZE + size * SAMPLE_SIZE
+
+
+def parse(data):
+    magic, version, size, cores, names, hz = struct.unpack_from('<6I', data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('no sampler buffer version %d found' % VERSION)
+
+    rings = []
+    for core in range(cores):
+        base = HDR_SIZE + core * ring_size(size, names)
+        head, = struct.unpack_from('<I', data, base)
+        tasks = {}
+        for i in range(names):
+            task, name = struct.unpack_from('<I28s', data,
+                                            base + RING_HDR_SIZE + i * NAME_SIZE)
+            if task:
+                tasks[task] = name.split(b'\0')[0].decode('ascii', 'replace')
+        samples = base + RING_HDR_SIZE + names * NAME_SIZE
+        rings.append((head, tasks, samples))
+
+    return size, hz, rings
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--pa', type=lambda x: int(x, 0),
+                     help='physical address of the sampler buffer')
+    src.add_argument('--dump', help='raw dump of the sampler buffer')
+    parser.add_argument('--elf', required=True, help='firmware ELF')
+    parser.add_argument('--nm', default=os.environ.get('NM', 'nm'),
+                        help='nm knowing about ARM ELF (default: $NM or nm)')
+    parser.add_argument('--seconds', type=float, default=0,
+                        help='poll the rings for that long')
+    parser.add_argument('--lr', action='store_true',
+                        help='add the LR function as the caller')
+    args = parser.parse_args()
+
+    syms = Symbols(args.elf, args.nm)
+    buf = Buffer(args)
+
+    data = buf.read()
+    size, hz, rings = parse(data)
+    # samples already taken, only new ones are counted when polling
+    seen = [head if args.seconds else max(head - size, 0)
+            for head, tasks, samples in rings]
+    end = time.time() + args.seconds
+    stacks = {}
+    lost = 0
+
+    while True:
+        for core, (head, tasks, samples) in enumerate(rings):
+            if head - seen[core] > size:
+                lost += head - seen[core] - size
+                seen[core] = head - size
+            for n in range(seen[core], head):
+                pc, lr, task, flags = struct.unpack_from(
+                    '<4I', data, samples + (n % size) * SAMPLE_SIZE)
+                frames = ['core%d' % core,
+                          tasks.get(task) or 'task-0x%08x' % task]
+                if flags & SAMPLE_HANDLER:
+                    frames.append('[interrupt]')
+                if args.lr:
+                    frames.append(syms.lookup(lr))
+                frames.append(syms.lookup(pc))
+                key = ';'.join(frames)
+                stacks[key] = stacks.get(key, 0) + 1
+            seen[core] = head
+
+        if time.time() >= end:
+            break
+        # half the time the rings take to wrap
+        time.sleep(min(max(size / float(hz or 1000) / 2, 0.01), 1.0))
+        data = buf.read()
+        size, hz, rings = parse(data)
+
+    for key in sorted(stacks):
+        print('%s %d' % (key, stacks[key]))
+
+    total = sum(stacks.values())
+    sys.stderr.write('%d samples at %d Hz' % (total, hz))
+    if lost:
+        sys.stderr.write(', %d lost (rings wrapped)' % lost)
+    sys.stderr.write('\n')
+
+
+if __name__ == '__main__':
+    main()
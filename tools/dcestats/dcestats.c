@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2011, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* dcestats: host reader of the IPU live statistics page.
+ *
+ *   dcestats <page PA> [rate in Hz, default 1] [number of samples] [period PA]
+ *
+ * The PAs are printed by the firmware at boot ("Statistics page PA").  The
+ * updates are off by default: given the PA of the period, it is set to
+ * the sampling period while sampling, and back to 0 when done.  The
+ * page is mapped uncached from /dev/mem, sampled at the given rate, and
+ * the differences between consecutive samples are printed: CPU load of
+ * each context (when the instrumentation measures it), per codec instance
+ * process calls, per RPC calls and their phases, heaps and the process
+ * calls queue.
+ *
+ * Build it for the host with, e.g.:
+ *
+ *   $(CROSS_COMPILE)gcc -O2 -I src/ti/framework/dce -o dcestats \
+ *       tools/dcestats/dcestats.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dce_stats.h"
+
+static const char * const    ctx_types[] = { "task", "swi", "hwi" };
+
+/* rpcs[] entries, see dce_rpc.h */
+static const char * const    rpc_names[DCE_STATS_RPCS] = {
+    "engine_open", "engine_close", "codec_create", "codec_control",
+    "codec_get_version", "codec_process", "codec_delete", "get_rproc_info",
+    "codec_hibernate", "codec_resume", "codec_priority", "codec_latency",
+    "get_DataFxn", "put_DataFxn", "get_BufferFxn", "rpc15"
+};
+
+static const char * const    phase_names[DCE_STATS_PHASES] = {
+    "lock", "cache", "power", "codec", "callback", "other"
+};
+
+/* Mean time per call of each phase, between two samples */
+static void print_phases(const uint32_t *cur, const uint32_t *prev, uint32_t calls)
+{
+    uint32_t    i;
+
+    printf("   ");
+    for( i = 0; i < DCE_STATS_PHASES; i++ ) {
+        printf("  %s %u", phase_names[i], (cur[i] - (prev ? prev[i] : 0)) / calls);
+    }
+    printf(" us\n");
+}
+
+/* Copy of the page, consistent as per its sequence lock */
+static int sample(volatile const Dce_Stats_Page *page, Dce_Stats_Page *copy)
+{
+    uint32_t    seq;
+    int         tries;
+
+    for( tries = 0; tries < 1000; tries++ ) {
+        seq = page->seq;
+        if( seq & 1 ) {
+            usleep(100);
+            continue;
+        }
+        __sync_synchronize();
+        memcpy(copy, (const void *)page, sizeof(*copy));
+        __sync_synchronize();
+        if( page->seq == seq ) {
+            return (0);
+        }
+    }
+
+    return (-1);
+}
+
+static const Dce_Stats_Ctx *find_ctx(const Dce_Stats_Core *core, uint32_t handle, uint32_t type)
+{
+    uint32_t    i;
+
+    for( i = 0; i < core->nctx && i < DCE_STATS_MAX_CTX; i++ ) {
+        if((core->ctx[i].handle == handle) && (core->ctx[i].type == type)) {
+            return (&core->ctx[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+static const Dce_Stats_Codec *find_codec(const Dce_Stats_Page *p, uint32_t handle)
+{
+    uint32_t    i;
+
+    for( i = 0; i < p->ncodecs && i < DCE_STATS_MAX_CODECS; i++ ) {
+        if( p->codecs[i].handle == handle ) {
+            return (&p->codecs[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+static void print_delta(const Dce_Stats_Page *prev, const Dce_Stats_Page *cur)
+{
+    uint32_t                  dt = cur->time_us - prev->time_us;
+    const Dce_Stats_Ctx      *c, *pc;
+    const Dce_Stats_Codec    *k, *pk;
+    const Dce_Stats_Rpc      *r, *pr;
+    uint32_t                  i, j, calls;
+
+    if( !dt ) {
+        return;
+    }
+
+    printf("--- %u us, %u updates, cpu load %u%%, %u calls waiting\n",
+           cur->time_us, cur->updates, cur->cpu_load, cur->queue.waiting);
+
+    if( cur->flags & DCE_STATS_CPU_KPI ) {
+        for( i = 0; i < DCE_STATS_CORES; i++ ) {
+            for( j = 0; j < cur->cores[i].nctx && j < DCE_STATS_MAX_CTX; j++ ) {
+                c = &cur->cores[i].ctx[j];
+                pc = find_ctx(&prev->cores[i], c->handle, c->type);
+                if( !pc || (pc->time_us == c->time_us)) {
+                    continue;
+                }
+                printf("  core %u %-4s %08x %5.1f%% %6u sw  %.16s\n", i,
+                       ctx_types[c->type % 3], c->handle,
+                       100.0 * (c->time_us - pc->time_us) / dt,
+                       c->switches - pc->switches, c->name);
+            }
+        }
+    }
+
+    for( i = 0; i < cur->ncodecs && i < DCE_STATS_MAX_CODECS; i++ ) {
+        k = &cur->codecs[i];
+        pk = find_codec(prev, k->handle);
+        calls = pk ? k->calls - pk->calls : k->calls;
+        if( !calls ) {
+            continue;
+        }
+        printf("  codec %08x %6.1f calls/s  process %6u us  wait %6u us  RPC %6u us  (max process %u us)\n",
+               k->handle, 1000000.0 * calls / dt,
+               (k->proc_us - (pk ? pk->proc_us : 0)) / calls,
+               (k->wait_us - (pk ? pk->wait_us : 0)) / calls,
+               (k->rpc_us - (pk ? pk->rpc_us : 0)) / calls, k->proc_max_us);
+        print_phases(k->phase_us, pk ? pk->phase_us : NULL, calls);
+        printf("    host pre-IVA %u us  IVA-HD %u us  host post-IVA %u us  %.1f runs\n",
+               (k->pre_iva_us - (pk ? pk->pre_iva_us : 0)) / calls,
+               (k->hdvicp_us - (pk ? pk->hdvicp_us : 0)) / calls,
+               (k->post_iva_us - (pk ? pk->post_iva_us : 0)) / calls,
+               (double)(k->hdvicp_runs - (pk ? pk->hdvicp_runs : 0)) / calls);
+        printf("    IVA-HD per frame p50 %u us  p99 %u us  max %u us\n",
+               k->iva_p50_us, k->iva_p99_us, k->iva_max_us);
+    }
+
+    for( i = 0; i < cur->nrpcs && i < DCE_STATS_RPCS; i++ ) {
+        r = &cur->rpcs[i];
+        pr = (i < prev->nrpcs) ? &prev->rpcs[i] : NULL;
+        calls = pr ? r->calls - pr->calls : r->calls;
+        if( !calls ) {
+            continue;
+        }
+        printf("  rpc %-17s %6u calls  %6u us  p50 %u p99 %u max %u us\n",
+               rpc_names[i], calls, (r->total_us - (pr ? pr->total_us : 0)) / calls,
+               r->p50_us, r->p99_us, r->max_us);
+        print_phases(r->phase_us, pr ? pr->phase_us : NULL, calls);
+    }
+
+    for( i = 0; i < cur->nheaps && i < DCE_STATS_HEAPS; i++ ) {
+        printf("  heap %u  used %u / %u  high %u  largest free %u  %u allocs  %u failures\n", i,
+               cur->heaps[i].used, cur->heaps[i].total, cur->heaps[i].high_water,
+               cur->heaps[i].largest_free, cur->heaps[i].alloc_count,
+               cur->heaps[i].failures);
+    }
+
+    printf("  queue  %u runs  %u switches  %u saved  %u expired\n",
+           cur->queue.runs - prev->queue.runs,
+           cur->queue.switches - prev->queue.switches,
+           cur->queue.saved - prev->queue.saved,
+           cur->queue.expired - prev->queue.expired);
+}
+
+/* Map the firmware's dce_stats_period_ms at pa, NULL on failure */
+static volatile uint32_t *map_period(int fd, unsigned long pa, void **map, long *size)
+{
+    unsigned long    base;
+
+    *size = sysconf(_SC_PAGESIZE);
+    base = pa & ~(*size - 1);
+
+    *map = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, base);
+    if( *map == MAP_FAILED ) {
+        perror("mmap period");
+        return (NULL);
+    }
+
+    return ((volatile uint32_t *)((char *)*map + (pa - base)));
+}
+
+int main(int argc, char * *argv)
+{
+    volatile const Dce_Stats_Page    *page;
+    volatile uint32_t                *period = NULL;
+    Dce_Stats_Page                    samples[2];
+    unsigned long                     pa, period_pa = 0;
+    unsigned int                      rate = 1, count = 0, n;
+    void                             *map, *period_map = NULL;
+    long                              period_size = 0;
+    int                               fd;
+
+    if( argc < 2 ) {
+        fprintf(stderr, "usage: %s <page PA> [rate in Hz] [number of samples] [period PA]\n", argv[0]);
+        return (1);
+    }
+
+    pa = strtoul(argv[1], NULL, 0);
+    if( argc > 2 ) {
+        rate = strtoul(argv[2], NULL, 0);
+    }
+    if( argc > 3 ) {
+        count = strtoul(argv[3], NULL, 0);
+    }
+    if( argc > 4 ) {
+        period_pa = strtoul(argv[4], NULL, 0);
+    }
+    if( !rate || (pa & (DCE_STATS_SIZE - 1)) || (period_pa & 3)) {
+        fprintf(stderr, "bad page PA, period PA or rate\n");
+        return (1);
+    }
+
+    fd = open("/dev/mem", (period_pa ? O_RDWR : O_RDONLY) | O_SYNC);
+    if( fd < 0 ) {
+        perror("/dev/mem");
+        return (1);
+    }
+
+    if( period_pa ) {
+        period = map_period(fd, period_pa, &period_map, &period_size);
+        if( !period ) {
+            return (1);
+        }
+        *period = (1000 / rate) ? (1000 / rate) : 1;
+        /* let the firmware notice and fill the page a first time */
+        sleep(2);
+    }
+
+    map = mmap(NULL, DCE_STATS_SIZE, PROT_READ, MAP_SHARED, fd, pa);
+    if( map == MAP_FAILED ) {
+        perror("mmap");
+        return (1);
+    }
+    page = map;
+
+    if((page->magic != DCE_STATS_MAGIC) || (page->version != DCE_STATS_VERSION) ||
+       (page->size != sizeof(Dce_Stats_Page))) {
+        fprintf(stderr, "no statistics page version %d at 0x%lx\n", DCE_STATS_VERSION, pa);
+        return (1);
+    }
+
+    n = 0;
+    while( !count || n <= count ) {
+        if( sample(page, &samples[n & 1]) < 0 ) {
+            fprintf(stderr, "page not updated consistently, retrying\n");
+        } else {
+            if( n ) {
+                print_delta(&samples[(n - 1) & 1], &samples[n & 1]);
+            }
+            n++;
+        }
+        usleep(1000000 / rate);
+    }
+
+    if( period ) {
+        *period = 0;
+        munmap(period_map, period_size);
+    }
+    munmap(map, DCE_STATS_SIZE);
+    close(fd);
+
+    return (0);
+}
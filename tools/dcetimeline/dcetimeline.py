@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2011, Texas Instruments Incorporated
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# *  Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#
+# *  Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# *  Neither the name of Texas Instruments Incorporated nor the names of
+#    its contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+"""dcetimeline: turn the IVA-HD occupancy timeline into a Chrome trace.
+
+The events (see src/ti/framework/dce/timeline.h) are read from /dev/mem at
+the PA printed by the firmware at boot ("IVA-HD timeline PA"), or from a raw dump
+of the buffer, crash dumps included.  They are written as Chrome trace
+event JSON, which chrome://tracing and ui.perfetto.dev both load:
+
+    dcetimeline.py --pa 0x9f0xxxxx > ivahd.json
+
+One track per codec instance, named after its handle as the host sees it,
+with its "queue" (waiting for the process lock), "IVA-HD" (holding it) and
+"yield" (giving way mid frame) slices.  The IVA-HD clock domain forced on
+is an "awake" slice on a track of its own, its frequency a counter.
+
+Slices the ring starts in the middle of have lost their beginning and are
+dropped, those still running at the end are left open.
+"""
+
+import argparse
+import json
+import mmap
+import os
+import struct
+import sys
+
+MAGIC = 0x4e4c5444
+VERSION = 1
+HDR_SIZE = 24
+EVENT_SIZE = 16
+
+QUEUE_ENTER, QUEUE_EXIT, ACQUIRE, RELEASE, YIELD, RESUME, \
+    IVA_AWAKE, IVA_GATED, OPP = range(1, 10)
+
+PID = 1
+CLOCK_TID = 0
+
+# type: (slice, begins)
+SLICES = {
+    QUEUE_ENTER: ('queue', True),
+    QUEUE_EXIT: ('queue', False),
+    ACQUIRE: ('IVA-HD', True),
+    RELEASE: ('IVA-HD', False),
+    YIELD: ('yield', True),
+    RESUME: ('yield', False),
+    IVA_AWAKE: ('awake', True),
+    IVA_GATED: ('awake', False),
+}
+
+
+def read_buffer(args):
+    if args.dump:
+        with open(args.dump, 'rb') as f:
+            return f.read()
+
+    fd = os.open('/dev/mem', os.O_RDONLY | os.O_SYNC)
+    page = args.pa & ~(mmap.PAGESIZE - 1)
+    offset = args.pa - page
+    mem = mmap.mmap(fd, offset + HDR_SIZE, mmap.MAP_SHARED, mmap.PROT_READ,
+                    offset=page)
+    size, = struct.unpack_from('<I', mem, offset + 8)
+    mem = mmap.mmap(fd, offset + HDR_SIZE + size * EVENT_SIZE,
+                    mmap.MAP_SHARED, mmap.PROT_READ, offset=page)
+    os.close(fd)
+    return mem[offset:]
+
+
+def events(data):
+    """Valid events, oldest first, as (us, type, id, arg)"""
+    magic, version, size, freq, head, enabled = \
+        struct.unpack_from('<6I', data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('no timeline buffer version %d found' % VERSION)
+    if not freq:
+        return []
+
+    # unwrapped going forward from the oldest one
+    out = []
+    ticks = 0
+    prev = None
+    for n in range(max(head - size, 0), head):
+        ts, type, id, arg = struct.unpack_from(
+            '<4I', data, HDR_SIZE + (n % size) * EVENT_SIZE)
+        if prev is not None:
+            ticks += (ts - prev) & 0xffffffff
+        prev = ts
+        out.append((ticks * 1000000.0 / freq, type, id, arg))
+
+    return out
+
+
+def chrome_trace(evts):
+    trace = [{'ph': 'M', 'pid': PID, 'name': 'process_name',
+              'args': {'name': 'IVA-HD'}},
+             {'ph': 'M', 'pid': PID, 'tid': CLOCK_TID, 'name': 'thread_name',
+              'args': {'name': 'IVA-HD clock'}}]
+    tracks = set()
+    open_slices = {}
+
+    for us, type, id, arg in evts:
+        if type == OPP:
+            trace.append({'ph': 'C', 'pid': PID, 'ts': us, 'name': 'IVA-HD MHz',
+                          'args': {'MHz': arg}})
+            continue
+        if type not in SLICES:
+            continue
+
+        name, begins = SLICES[type]
+        tid = CLOCK_TID if type in (IVA_AWAKE, IVA_GATED) else id
+        if tid != CLOCK_TID and tid not in tracks:
+            tracks.add(tid)
+            trace.append({'ph': 'M', 'pid': PID, 'tid': tid,
+                          'name': 'thread_name',
+                          'args': {'name': 'codec 0x%08x' % tid}})
+
+        key = (tid, name)
+        if begins:
+            open_slices[key] = open_slices.get(key, 0) + 1
+            e = {'ph': 'B', 'pid': PID, 'tid': tid, 'ts': us, 'name': name}
+            if type == QUEUE_ENTER:
+                e['args'] = {'priority': arg}
+        else:
+            if not open_slices.get(key):
+                continue
+            open_slices[key] -= 1
+            e = {'ph': 'E', 'pid': PID, 'tid': tid, 'ts': us, 'name': name}
+            if type == RELEASE:
+                # process() result, signed
+                e['args'] = {'result': arg - (1 << 32) if arg >> 31 else arg}
+        trace.append(e)
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument('--pa', type=lambda x: int(x, 0),
+                     help='physical address of the timeline buffer')
+    src.add_argument('--dump', help='raw dump of the timeline buffer')
+    parser.add_argument('-o', '--output', help='JSON file (default: stdout)')
+    args = parser.parse_args()
+
+    evts = events(read_buffer(args))
+    out = open(args.output, 'w') if args.output else sys.stdout
+    json.dump(chrome_trace(evts), out)
+    out.write('\n')
+    if args.output:
+        out.close()
+
+    sys.stderr.write('%d events' % len(evts))
+    if evts:
+        sys.stderr.write(' over %.3f ms' % ((evts[-1][0] - evts[0][0]) / 1000))
+    sys.stderr.write('\n')
+
+
+if __name__ == '__main__':
+    main()